@@ -0,0 +1,147 @@
+#pragma once
+
+#include <dllib/tensor.hpp>
+#include <dllib/autograd.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace dllib {
+
+namespace helpers {
+
+template<class TData, size_t Dim>
+TData DotProduct(const TTensor<TData, Dim>& l, const TTensor<TData, Dim>& r) {
+  TData result = 0;
+  for (size_t d = 0; d < Dim; ++d) {
+    result += l[d] * r[d];
+  }
+  return result;
+}
+
+//  softmax(q k^T / sqrt(Dim)) v as a single node, computed a Tile x Tile block of scores at a time. Forward
+//  keeps a running maximum and sum of exponents per query (online softmax) and rescales the partial output
+//  whenever the maximum grows, so only the log-sum-exp of every query is kept for Backward. Backward
+//  recomputes the probabilities of every block from it
+template<class TData, size_t Batch, size_t Seq, size_t KeySeq, size_t Dim, size_t ValueDim, size_t Tile>
+struct TAttention {
+  using TQuery = TTensor<TData, Batch, Seq, Dim>;
+  using TKey = TTensor<TData, Batch, KeySeq, Dim>;
+  using TValue = TTensor<TData, Batch, KeySeq, ValueDim>;
+  using TResult = TTensor<TData, Batch, Seq, ValueDim>;
+
+  static inline const TData scale = 1 / std::sqrt(TData(Dim));
+
+  TResult Forward(const TQuery& q, const TKey& k, const TValue& v) {
+    TResult result(0);
+    TTensor<TData, Tile, Tile> scores;
+    TTensor<TData, Tile> max, exp_sum;
+    for (size_t b = 0; b < Batch; ++b) {
+      for (size_t i0 = 0; i0 < Seq; i0 += Tile) {
+        size_t rows = std::min(Tile, Seq - i0);
+        for (size_t j0 = 0; j0 < KeySeq; j0 += Tile) {
+          size_t columns = std::min(Tile, KeySeq - j0);
+          for (size_t r = 0; r < rows; ++r) {
+            auto& out = result[b][i0 + r];
+            TData block_max = scores[r][0] = DotProduct(q[b][i0 + r], k[b][j0]) * scale;
+            for (size_t c = 1; c < columns; ++c) {
+              block_max = std::max<TData>(block_max, scores[r][c] = DotProduct(q[b][i0 + r], k[b][j0 + c]) * scale);
+            }
+
+            if (j0 == 0) {
+              max[r] = block_max;
+              exp_sum[r] = 0;
+            } else if (block_max > max[r]) {
+              TData correction = std::exp(TData(max[r]) - block_max);
+              exp_sum[r] *= correction;
+              out *= correction;
+              max[r] = block_max;
+            }
+            for (size_t c = 0; c < columns; ++c) {
+              TData p = std::exp(TData(scores[r][c]) - TData(max[r]));
+              exp_sum[r] += p;
+              const auto& value = v[b][j0 + c];
+              for (size_t d = 0; d < ValueDim; ++d) {
+                out[d] += p * value[d];
+              }
+            }
+          }
+        }
+        for (size_t r = 0; r < rows; ++r) {
+          result[b][i0 + r] /= TData(exp_sum[r]);
+          log_sum_exp_[b][i0 + r] = max[r] + std::log(TData(exp_sum[r]));
+        }
+      }
+    }
+    return result;
+  }
+
+  void Backward(const IVariable<TResult>* current, TVariable<TQuery>& q, TVariable<TKey>& k, TVariable<TValue>& v) {
+    TTensor<TData, Tile, Tile> probabilities, scores_grad;
+    TTensor<TData, Tile> output_grad_dot;
+    for (size_t b = 0; b < Batch; ++b) {
+      for (size_t i0 = 0; i0 < Seq; i0 += Tile) {
+        size_t rows = std::min(Tile, Seq - i0);
+        //  The gradient of a score is p * (dp - sum(p * dp)), where the sum equals <dO, O> of the query
+        for (size_t r = 0; r < rows; ++r) {
+          output_grad_dot[r] = DotProduct(current->grad[b][i0 + r], current->value[b][i0 + r]);
+        }
+        for (size_t j0 = 0; j0 < KeySeq; j0 += Tile) {
+          size_t columns = std::min(Tile, KeySeq - j0);
+          for (size_t r = 0; r < rows; ++r) {
+            const auto& query = q->value[b][i0 + r];
+            const auto& output_grad = current->grad[b][i0 + r];
+            for (size_t c = 0; c < columns; ++c) {
+              TData p = probabilities[r][c] =
+                std::exp(DotProduct(query, k->value[b][j0 + c]) * scale - TData(log_sum_exp_[b][i0 + r]));
+              TData probability_grad = DotProduct(output_grad, v->value[b][j0 + c]);
+              scores_grad[r][c] = p * (probability_grad - TData(output_grad_dot[r])) * scale;
+            }
+          }
+
+          for (size_t r = 0; r < rows; ++r) {
+            for (size_t c = 0; c < columns; ++c) {
+              TData score_grad = scores_grad[r][c];
+              if (q->requires_grad) {
+                q->grad[b][i0 + r] += k->value[b][j0 + c] * score_grad;
+              }
+              if (k->requires_grad) {
+                k->grad[b][j0 + c] += q->value[b][i0 + r] * score_grad;
+              }
+              if (v->requires_grad) {
+                v->grad[b][j0 + c] += current->grad[b][i0 + r] * TData(probabilities[r][c]);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  TTensor<TData, Batch, Seq> log_sum_exp_;
+};
+
+}  // namespace helpers
+
+//  Scaled dot-product attention of the queries `q` over the keys `k` and values `v` of every batch
+//  element. Scores are processed in Tile x Tile blocks in both passes, so memory beyond the arguments and
+//  the result is O(Batch * Seq + Tile^2) rather than O(Batch * Seq * KeySeq)
+template<size_t Tile = 32, class TData, size_t Batch, size_t Seq, size_t KeySeq, size_t Dim, size_t ValueDim>
+TTensor<TData, Batch, Seq, ValueDim> ScaledDotProductAttention(
+  const TTensor<TData, Batch, Seq, Dim>& q,
+  const TTensor<TData, Batch, KeySeq, Dim>& k,
+  const TTensor<TData, Batch, KeySeq, ValueDim>& v) {
+
+  return helpers::TAttention<TData, Batch, Seq, KeySeq, Dim, ValueDim, Tile>{}.Forward(q, k, v);
+}
+
+template<size_t Tile = 32, class TData, size_t Batch, size_t Seq, size_t KeySeq, size_t Dim, size_t ValueDim>
+TVariable<TTensor<TData, Batch, Seq, ValueDim>> ScaledDotProductAttention(
+  const TVariable<TTensor<TData, Batch, Seq, Dim>>& q,
+  const TVariable<TTensor<TData, Batch, KeySeq, Dim>>& k,
+  const TVariable<TTensor<TData, Batch, KeySeq, ValueDim>>& v) {
+
+  return MakeOperation(helpers::TAttention<TData, Batch, Seq, KeySeq, Dim, ValueDim, Tile>{}, q, k, v);
+}
+
+}  // namespace dllib
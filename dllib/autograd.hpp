@@ -1,8 +1,13 @@
 #pragma once
 
 #include <dllib/tensor.hpp>
+#include <dllib/memory.hpp>
+#include <dllib/profiler.hpp>
 
 #include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
 #include <unordered_set>
 #include <vector>
 
@@ -18,9 +23,24 @@ struct IArbitraryVariable {
 
   virtual void PushGradient() = 0;
 
+  //  Recomputes value from the current values of the children, no-op for leaves
+  virtual void Recompute() {}
+
+  //  Size of the value, the gradient has the same size
+  [[nodiscard]] virtual size_t ValueBytes() const = 0;
+
+  //  True when PushGradient also writes gradients of variables which are not among the children
+  [[nodiscard]] virtual bool WritesOutsideChildren() const {
+    return false;
+  }
+
   virtual ~IArbitraryVariable() = default;
 
   bool requires_grad;
+
+  //  Incremented by every in-place modification of the value, so nodes which saved the value for
+  //  Backward can tell it's no longer the one they've seen
+  size_t version = 0;
 };
 
 template<CTensor T>
@@ -32,6 +52,116 @@ struct TLeafNode;
 template<class TOperation, CTensor... TArgs>
 struct TOperationNode;
 
+template<CTensor TT>
+struct TVariable;
+
+namespace helpers {
+
+template<class TOperation, class... TArgs>
+using TOperationResult = std::invoke_result_t<decltype(&TOperation::Forward), TOperation*, TArgs...>;
+
+inline thread_local bool grad_enabled = true;
+
+//  Set while a graph is being captured for replay (see TStaticGraph), nodes which don't require
+//  gradient then retain their arguments too
+inline thread_local bool graph_capture_enabled = false;
+
+//  Set while Checkpoint recomputes a segment during Backward. Operations with effects beyond their value
+//  (e.g. BatchNorm folding the batch into its running statistics) skip them, the forward pass of the
+//  step has made them already
+inline thread_local bool checkpoint_recompute_enabled = false;
+
+//  Sets checkpoint_recompute_enabled for its lifetime
+struct TCheckpointRecomputeGuard {
+  TCheckpointRecomputeGuard() : previous(checkpoint_recompute_enabled) {
+    checkpoint_recompute_enabled = true;
+  }
+
+  TCheckpointRecomputeGuard(const TCheckpointRecomputeGuard&) = delete;
+  TCheckpointRecomputeGuard& operator=(const TCheckpointRecomputeGuard&) = delete;
+
+  ~TCheckpointRecomputeGuard() {
+    checkpoint_recompute_enabled = previous;
+  }
+
+  const bool previous;
+};
+
+//  Hands out the storage of the nodes made while a planned graph is captured (see TPlannedGraph)
+class INodeStorage {
+ public:
+  struct TSlots {
+    void* value;
+    void* grad;
+  };
+
+  //  Storage for the value and the gradient of the next node, both null to leave the node its own
+  virtual TSlots Next(size_t bytes) = 0;
+
+  //  Called with every node after it is made
+  virtual void Made(IArbitraryVariable* node) = 0;
+
+ protected:
+  ~INodeStorage() = default;
+};
+
+inline thread_local INodeStorage* node_storage = nullptr;
+
+//  Sets the node storage of the current thread while alive
+class TNodeStorageScope {
+ public:
+  explicit TNodeStorageScope(INodeStorage* storage) : previous_(node_storage) {
+    node_storage = storage;
+  }
+
+  TNodeStorageScope(const TNodeStorageScope&) = delete;
+  TNodeStorageScope& operator=(const TNodeStorageScope&) = delete;
+
+  ~TNodeStorageScope() {
+    node_storage = previous_;
+  }
+
+  [[nodiscard]] INodeStorage* GetPrevious() const {
+    return previous_;
+  }
+
+ private:
+  INodeStorage* const previous_;
+};
+
+}  // namespace helpers
+
+template<class TOperation, CTensor... TArgs>
+TVariable<helpers::TOperationResult<TOperation, TArgs...>> MakeOperation(
+  TOperation op,
+  const TVariable<TArgs>&... args);
+
+//  Whether operations on TVariable record the graph for Backward in the current thread
+inline bool IsGradEnabled() {
+  return helpers::grad_enabled;
+}
+
+//  While alive, operations on TVariable don't build the graph: the result is computed straight
+//  away and stored in a leaf recycled per thread, arguments are not retained and DropOut is an
+//  identity. FullyConnected and Bias take their tensor path and make a single leaf for the output.
+//  Guards may be nested, the previous mode is restored on destruction.
+class TNoGradGuard {
+ public:
+  TNoGradGuard() : previous_(helpers::grad_enabled) {
+    helpers::grad_enabled = false;
+  }
+
+  TNoGradGuard(const TNoGradGuard&) = delete;
+  TNoGradGuard& operator=(const TNoGradGuard&) = delete;
+
+  ~TNoGradGuard() {
+    helpers::grad_enabled = previous_;
+  }
+
+ private:
+  const bool previous_;
+};
+
 template<CTensor TT>
 struct TVariable : public std::shared_ptr<IVariable<TT>> {
  private:
@@ -81,7 +211,7 @@ struct TVariable : public std::shared_ptr<IVariable<TT>> {
       }
     };
 
-    return std::make_shared<TOperationNode<TView, TT>>(TView{}, *this);
+    return MakeOperation(TView{}, *this);
   }
 
   template<class U = TT, class TTransposeResult = helpers::TTransposeResult<U>>
@@ -98,7 +228,7 @@ struct TVariable : public std::shared_ptr<IVariable<TT>> {
       }
     };
 
-    return std::make_shared<TOperationNode<TTranspose, TT>>(TTranspose{}, *this);
+    return MakeOperation(TTranspose{}, *this);
   }
 
   TVariable operator-() const {
@@ -114,7 +244,7 @@ struct TVariable : public std::shared_ptr<IVariable<TT>> {
       }
     };
 
-    return std::make_shared<TOperationNode<TNeg, TT>>(TNeg{}, *this);
+    return MakeOperation(TNeg{}, *this);
   }
 
   std::tuple<TT&, TT&> GetSerializationFields() const {
@@ -127,13 +257,27 @@ template<CTensor T>
 struct IVariable : public IArbitraryVariable {
   using IArbitraryVariable::requires_grad;
 
-  // NOLINTNEXTLINE
-  IVariable(const T& value, bool requires_grad = false) : IArbitraryVariable(requires_grad), value(value), grad(0) {}
+  //  `value` and `grad` are the storage of the node itself (see helpers::TInlineStorage) or slots of the
+  //  arena of a planned graph (see TPlannedGraph)
+  IVariable(T& value, T& grad, bool requires_grad)
+    : IArbitraryVariable(requires_grad), value(value), grad(grad) {}
+
+  IVariable(const IVariable&) = delete;
+  IVariable& operator=(const IVariable&) = delete;
 
   ~IVariable() override = default;
 
+  [[nodiscard]] size_t ValueBytes() const final {
+    return sizeof(T);
+  }
+
   template<class U = T>
   std::enable_if_t<U::DimensionCount == 0, void> Backward() {
+    Backward(T(1));
+  }
+
+  //  Same as Backward(), but for an arbitrary shaped variable with the given gradient of the result
+  void Backward(const T& output_grad) {
     std::unordered_set<IArbitraryVariable*> SubGraph;
     std::vector<IArbitraryVariable*> order;
 
@@ -153,7 +297,7 @@ struct IVariable : public IArbitraryVariable {
       }
     }
 
-    grad = 1;
+    grad = output_grad;
     PushGradient();
     while (!order.empty()) {
       order.back()->PushGradient();
@@ -165,13 +309,39 @@ struct IVariable : public IArbitraryVariable {
     grad.FillWith(0);
   }
 
-  T value;
-  T grad;
+  //  Adds (or subtracts) the value of `term` to the value in place, keeping the node in the graph: its
+  //  gradient then also flows to `term`. Returns false if the node can't take it and the sum has to be
+  //  a new node (see AddInplace)
+  virtual bool AccumulateInplace(const TVariable<T>&, bool /* subtract */) {
+    return false;
+  }
+
+  T& value;
+  T& grad;
 };
 
+namespace helpers {
+
+//  Value and gradient kept inside of the node. Nodes inherit it before IVariable, so the storage is
+//  constructed by the time IVariable binds to it. The value is charged by the node
+template<CTensor T>
+struct TInlineStorage {
+  explicit TInlineStorage(const T& value) : stored_value(value), stored_grad(0) {
+  }
+
+  T stored_value;
+  T stored_grad;
+  [[no_unique_address]] TMemoryCharge grad_charge{EMemoryCategory::Gradients, sizeof(T)};
+};
+
+}  // namespace helpers
+
 template<CTensor T>
-struct TLeafNode final : public IVariable<T> {
-  using IVariable<T>::IVariable;
+struct TLeafNode final : private helpers::TInlineStorage<T>, public IVariable<T> {
+  TLeafNode(const T& value, bool requires_grad)
+    : helpers::TInlineStorage<T>(value), IVariable<T>(this->stored_value, this->stored_grad, requires_grad) {
+  }
+
   using IVariable<T>::value;
   using IVariable<T>::grad;
   using IVariable<T>::requires_grad;
@@ -182,6 +352,9 @@ struct TLeafNode final : public IVariable<T> {
   }
 
   void PushGradient() {}
+
+ private:
+  [[no_unique_address]] helpers::TLeafValueCharge value_charge_{this->requires_grad, sizeof(T)};
 };
 
 namespace helpers {
@@ -190,6 +363,109 @@ constexpr bool CalculateOr(auto... args) {
   return (args || ... || false);
 }
 
+//  Operations may declare `static constexpr bool AlwaysRequiresGrad()` returning true when their result
+//  depends on variables which are not passed as arguments (e.g. parameters captured by a checkpointed function)
+template<class TOperation>
+constexpr bool VAlwaysRequiresGrad = false;
+
+template<class TOperation> requires requires { TOperation::AlwaysRequiresGrad(); }
+constexpr bool VAlwaysRequiresGrad<TOperation> = TOperation::AlwaysRequiresGrad();
+
+//  Operations may declare `static constexpr bool WritesOutsideArguments()` returning true when Backward
+//  accumulates into gradients of variables which are not passed as arguments, so it can't run concurrently
+//  with any other node, see ParallelBackward
+template<class TOperation>
+constexpr bool VWritesOutsideArguments = false;
+
+template<class TOperation> requires requires { TOperation::WritesOutsideArguments(); }
+constexpr bool VWritesOutsideArguments<TOperation> = TOperation::WritesOutsideArguments();
+
+inline void CheckVersion(const IArbitraryVariable* v, size_t expected) {
+  if (v->version != expected) {
+    throw std::runtime_error(
+      "A value saved for Backward has been modified by an in-place operation: version is " +
+      std::to_string(v->version) + ", expected " + std::to_string(expected));
+  }
+}
+
+template<class TOperation, CTensor... TArgs>
+TOperationResult<TOperation, TArgs...> RunForward(TOperation& op, const TArgs&... args) {
+  TOperationScope<TOperation, TOperationResult<TOperation, TArgs...>, TArgs...> scope(TProfiler::EPhase::Forward);
+  return op.Forward(args...);
+}
+
+//  Allocator of the leaves holding results while gradients are disabled. A few freed blocks of every
+//  type are kept per thread and handed out again, so inference in a loop stops going to the heap
+//  after the first pass. Once the list of the thread is destroyed (a variable held in a static or a
+//  thread_local may outlive it), blocks go straight to std::allocator
+template<class T>
+struct TRecyclingAllocator {
+  using value_type = T;
+
+  TRecyclingAllocator() = default;
+
+  template<class U>
+  explicit TRecyclingAllocator(const TRecyclingAllocator<U>&) {
+  }
+
+  T* allocate(size_t n) {
+    auto* list = GetFreeList();
+    if (n == 1 && list && list->size > 0) {
+      return list->blocks[--list->size];
+    }
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T* ptr, size_t n) {
+    auto* list = GetFreeList();
+    if (n == 1 && list && list->size < TFreeList::Capacity) {
+      list->blocks[list->size++] = ptr;
+    } else {
+      std::allocator<T>().deallocate(ptr, n);
+    }
+  }
+
+  template<class U>
+  bool operator==(const TRecyclingAllocator<U>&) const {
+    return true;
+  }
+
+ private:
+  struct TFreeList {
+    static constexpr size_t Capacity = 8;
+
+    ~TFreeList() {
+      for (size_t i = 0; i < size; ++i) {
+        std::allocator<T>().deallocate(blocks[i], 1);
+      }
+      size = 0;
+      destroyed = true;
+    }
+
+    T* blocks[Capacity];
+    size_t size = 0;
+  };
+
+  static TFreeList* GetFreeList() {
+    if (destroyed) {
+      return nullptr;
+    }
+    thread_local TFreeList list;
+    return &list;
+  }
+
+  //  Trivially destructible, so it may still be read after the list is gone
+  static inline thread_local bool destroyed = false;
+};
+
+//  Result of an operation while gradients are disabled. TVariable is a shared node, so one leaf is still
+//  made per operation and its reference count is touched, only the heap allocation is recycled. The
+//  tensor path of the layers avoids both
+template<CTensor T>
+TVariable<T> MakeNoGradLeaf(const T& value) {
+  return std::allocate_shared<TLeafNode<T>>(TRecyclingAllocator<TLeafNode<T>>(), value, false);
+}
+
 template<CTensor T>
 constexpr T* GetGradientPointerIfRequired(const TVariable<T>& v) {
   if (v->requires_grad) {
@@ -203,34 +479,81 @@ constexpr T* GetGradientPointerIfRequired(const TVariable<T>& v) {
 
 
 template<class TOperation, CTensor... TArgs>
-struct TOperationNode : public IVariable<std::invoke_result_t<decltype(&TOperation::Forward), TOperation*, TArgs...>> {
-  using TValue = std::invoke_result_t<decltype(&TOperation::Forward), TOperation*, TArgs...>;
+struct TOperationNode : public IVariable<helpers::TOperationResult<TOperation, TArgs...>> {
+  using TValue = helpers::TOperationResult<TOperation, TArgs...>;
 
   using IVariable<TValue>::value;
   using IVariable<TValue>::grad;
   using IVariable<TValue>::requires_grad;
   using IVariable<TValue>::ZeroGrad;
 
-  // NOLINTNEXTLINE
-  TOperationNode(TOperation op, const TVariable<TArgs>& ... args) :
-    IVariable<TValue>(op.Forward(args->value...), helpers::CalculateOr(args->requires_grad...)),
+  //  `value` has to hold the result of the forward pass of `op` already, see MakeOperation
+  TOperationNode(TValue& value, TValue& grad, TOperation op, const TVariable<TArgs>& ... args) :
+    IVariable<TValue>(value, grad, helpers::CalculateOr(helpers::VAlwaysRequiresGrad<TOperation>, args->requires_grad...)),
     operation_(std::move(op)),
-    args_({args...}) {
+    args_({args...}),
+    arg_versions_{args->version...},
+    saved_version_(this->version) {
 
-    if (!requires_grad) {
+    if (!requires_grad && !helpers::graph_capture_enabled) {
       args_ = {};
     }
   }
 
-  TOperationNode(TOperationNode&&) noexcept = default;
+  //  Operations with random state may define Resample() to get it renewed on every recomputation
+  void Recompute() final {
+    if constexpr (requires { operation_.Resample(); }) {
+      operation_.Resample();
+    }
+    value = std::apply([this](const auto&... args) {
+      arg_versions_ = {args->version...};
+      return helpers::RunForward(operation_, args->value...);
+    }, args_);
+    for (const auto& [term, subtract] : inplace_terms_) {
+      if (subtract) {
+        value -= term->value;
+      } else {
+        value += term->value;
+      }
+    }
+    saved_version_ = this->version;
+  }
+
+  //  The gradient of a sum is the same for both of its terms, so the node keeps pushing its gradient to
+  //  the arguments and also passes it to `term`. Not possible if Backward reads the value of the node, or
+  //  if the node dropped its arguments for not requiring gradient
+  bool AccumulateInplace(const TVariable<TValue>& term, bool subtract) final {
+    if (BackwardReadsValue || !requires_grad || helpers::graph_capture_enabled) {
+      return false;
+    }
+    if (subtract) {
+      value -= term->value;
+    } else {
+      value += term->value;
+    }
+    ++this->version;
+    if (term->requires_grad) {
+      inplace_terms_.emplace_back(term, subtract);
+    }
+    return true;
+  }
+
+  [[nodiscard]] bool WritesOutsideChildren() const final {
+    return helpers::VWritesOutsideArguments<TOperation>;
+  }
 
   [[nodiscard]] std::vector<IArbitraryVariable*> GetChildren() const {
-    return [this]<size_t... i>(std::index_sequence<i...>) -> std::vector<IArbitraryVariable*>{
+    auto children = [this]<size_t... i>(std::index_sequence<i...>) -> std::vector<IArbitraryVariable*>{
       return { static_cast<IArbitraryVariable*>(get<i>(args_).get())... };
     }(std::make_index_sequence<sizeof...(TArgs)>());
+    for (const auto& term : inplace_terms_) {
+      children.push_back(term.first.get());
+    }
+    return children;
   }
 
   void PushGradient() {
+    helpers::TOperationScope<TOperation, TValue, TArgs...> scope(TProfiler::EPhase::Backward);
     [this]<size_t... i>(std::index_sequence<i...>) {
       constexpr bool pointers_callable = std::is_invocable_v<
         decltype(&TOperation::Backward),
@@ -266,6 +589,14 @@ struct TOperationNode : public IVariable<std::invoke_result_t<decltype(&TOperati
                     callable_with_current_variable_and_parent_gradients == 1,
         "You should implement only one Backward overload");
 
+      //  Only Backward overloads getting variables may read the saved values
+      if constexpr (variables_callable || callable_with_current_variable) {
+        (helpers::CheckVersion(get<i>(args_).get(), arg_versions_[i]), ...);
+      }
+      if constexpr (callable_with_current_variable || callable_with_current_variable_and_parent_gradients) {
+        helpers::CheckVersion(this, saved_version_);
+      }
+
       if constexpr (pointers_callable) {
         operation_.Backward(grad, helpers::GetGradientPointerIfRequired(get<i>(args_))...);
       } else if constexpr (variables_callable) {
@@ -276,14 +607,92 @@ struct TOperationNode : public IVariable<std::invoke_result_t<decltype(&TOperati
         operation_.Backward(this, get<i>(args_)...);
       }
     }(std::make_index_sequence<sizeof...(TArgs)>());
+    for (auto& [term, subtract] : inplace_terms_) {
+      if (subtract) {
+        term->grad -= grad;
+      } else {
+        term->grad += grad;
+      }
+    }
     ZeroGrad();
   }
 
  private:
+  //  Backward overloads getting the node itself may read its value
+  static constexpr bool BackwardReadsValue =
+    std::is_invocable_v<decltype(&TOperation::Backward), TOperation*, const IVariable<TValue>*, TArgs*...> ||
+    std::is_invocable_v<decltype(&TOperation::Backward), TOperation*, const IVariable<TValue>*, TVariable<TArgs>&...>;
+
   TOperation operation_;
   std::tuple<TVariable<TArgs>...> args_;
+  std::array<size_t, sizeof...(TArgs)> arg_versions_;
+  size_t saved_version_;
+  //  Variables added to the value by AddInplace and SubInplace, with whether they were subtracted
+  std::vector<std::pair<TVariable<TValue>, bool>> inplace_terms_;
+  [[no_unique_address]] helpers::TMemoryCharge operation_charge_{EMemoryCategory::Activations, sizeof(TOperation)};
 };
 
+namespace helpers {
+
+//  Operation node owning its value and gradient. The forward pass runs on `op` before it is moved into
+//  the node, so the result is constructed right in the storage
+template<class TOperation, CTensor... TArgs>
+struct TInlineOperationNode final
+  : private TInlineStorage<TOperationResult<TOperation, TArgs...>>, public TOperationNode<TOperation, TArgs...> {
+
+  // NOLINTNEXTLINE
+  TInlineOperationNode(TOperation op, const TVariable<TArgs>& ... args) :
+    TInlineStorage<TOperationResult<TOperation, TArgs...>>(RunForward(op, args->value...)),
+    TOperationNode<TOperation, TArgs...>(this->stored_value, this->stored_grad, std::move(op), args...) {
+  }
+
+ private:
+  [[no_unique_address]] TMemoryCharge value_charge_{
+    EMemoryCategory::Activations, sizeof(TOperationResult<TOperation, TArgs...>)};
+};
+
+//  Makes the node with the storage handed out by `node_storage`, or with its own storage if there is no
+//  slot for it
+template<class TOperation, CTensor... TArgs>
+TVariable<TOperationResult<TOperation, TArgs...>> MakeNodeInStorage(
+  TOperation op,
+  const TVariable<TArgs>&... args) {
+
+  using TValue = TOperationResult<TOperation, TArgs...>;
+
+  //  Nodes made by the forward pass of the operation itself (e.g. by Checkpoint) are temporaries and
+  //  keep their own storage
+  TNodeStorageScope scope(nullptr);
+  auto* storage = scope.GetPrevious();
+
+  TVariable<TValue> node;
+  if (auto slots = storage->Next(sizeof(TValue)); slots.value) {
+    auto* value = new (slots.value) TValue(RunForward(op, args->value...));
+    auto* grad = new (slots.grad) TValue;
+    node = std::make_shared<TOperationNode<TOperation, TArgs...>>(*value, *grad, std::move(op), args...);
+  } else {
+    node = std::make_shared<TInlineOperationNode<TOperation, TArgs...>>(std::move(op), args...);
+  }
+  storage->Made(node.get());
+  return node;
+}
+
+}  // namespace helpers
+
+template<class TOperation, CTensor... TArgs>
+TVariable<helpers::TOperationResult<TOperation, TArgs...>> MakeOperation(
+  TOperation op,
+  const TVariable<TArgs>&... args) {
+
+  if (!IsGradEnabled()) {
+    return helpers::MakeNoGradLeaf(helpers::RunForward(op, args->value...));
+  }
+  if (helpers::node_storage) {
+    return helpers::MakeNodeInStorage(std::move(op), args...);
+  }
+  return std::make_shared<helpers::TInlineOperationNode<TOperation, TArgs...>>(std::move(op), args...);
+}
+
 template<CTensor T>
 TVariable<T> operator+(const TVariable<T>& l, const TVariable<T>& r) {
   struct TAddition {
@@ -301,7 +710,7 @@ TVariable<T> operator+(const TVariable<T>& l, const TVariable<T>& r) {
     }
   };
 
-  return std::make_shared<TOperationNode<TAddition, T, T>>(TAddition{}, l, r);
+  return MakeOperation(TAddition{}, l, r);
 }
 
 template<CTensor T>
@@ -321,7 +730,7 @@ TVariable<T> operator-(const TVariable<T>& l, const TVariable<T>& r) {
     }
   };
 
-  return std::make_shared<TOperationNode<TSubtraction, T, T>>(TSubtraction{}, l, r);
+  return MakeOperation(TSubtraction{}, l, r);
 }
 
 template<CTensor T>
@@ -341,7 +750,7 @@ TVariable<T> operator*(const TVariable<T>& l, const TVariable<T>& r) {
     }
   };
 
-  return std::make_shared<TOperationNode<TMultiplication, T, T>>(TMultiplication{}, l, r);
+  return MakeOperation(TMultiplication{}, l, r);
 }
 
 template<CTensor T1, CTensor T2>
@@ -361,7 +770,7 @@ TVariable<helpers::TMatrixProductResult<T1, T2>> MatrixProduct(const TVariable<T
     };
   };
 
-  return std::make_shared<TOperationNode<TMatrixProduct, T1, T2>>(TMatrixProduct{}, l, r);
+  return MakeOperation(TMatrixProduct{}, l, r);
 }
 
 template<CTensor T>
@@ -378,7 +787,7 @@ TVariable<T> Log(const TVariable<T>& val) {
     }
   };
 
-  return std::make_shared<TOperationNode<TLog, T>>(TLog{}, val);
+  return MakeOperation(TLog{}, val);
 }
 
 template<CTensor T>
@@ -395,7 +804,7 @@ TVariable<T> Sqrt(const TVariable<T>& val) {
     }
   };
 
-  return std::make_shared<TOperationNode<TSqrt, T>>(TSqrt{}, val);
+  return MakeOperation(TSqrt{}, val);
 }
 
 template<size_t Dim, CTensor T1, CTensor T2>
@@ -421,7 +830,7 @@ TVariable<helpers::TStackAlongResult<Dim, T1, T2>> StackAlong(
     }
   };
 
-  return std::make_shared<TOperationNode<TStackAlong, T1, T2>>(TStackAlong{}, v1, v2);
+  return MakeOperation(TStackAlong{}, v1, v2);
 }
 
 template<CTensor T>
@@ -438,7 +847,7 @@ auto Sum(const TVariable<T>& val) {
     }
   };
 
-  return std::make_shared<TOperationNode<TSum, T>>(TSum{}, val);
+  return MakeOperation(TSum{}, val);
 }
 
 template<CTensor T>
@@ -455,7 +864,7 @@ TVariable<T> Exp(const TVariable<T>& val) {
     }
   };
 
-  return std::make_shared<TOperationNode<TExp, T>>(TExp{}, val);
+  return MakeOperation(TExp{}, val);
 }
 
 template<CTensor T>
@@ -472,7 +881,7 @@ TVariable<T> Tanh(const TVariable<T>& val) {
     }
   };
 
-  return std::make_shared<TOperationNode<TTanh, T>>(TTanh{}, val);
+  return MakeOperation(TTanh{}, val);
 }
 
 template<CTensor T>
@@ -489,7 +898,96 @@ TVariable<T> Sigmoid(const TVariable<T>& val) {
     }
   };
 
-  return std::make_shared<TOperationNode<TSigmoid, T>>(TSigmoid{}, val);
+  return MakeOperation(TSigmoid{}, val);
+}
+
+namespace helpers {
+
+//  Whether the value of `target` may be overwritten without breaking the graph, i.e. the result of the
+//  operation doesn't require gradient. While a graph is captured operation nodes are never modified, a
+//  replay recomputes them without the write
+template<CTensor T, CTensor... TArgs>
+bool CanModifyInplace(const TVariable<T>& target, const TVariable<TArgs>&... args) {
+  if (graph_capture_enabled && !target.IsLeaf()) {
+    return false;
+  }
+  if (!IsGradEnabled() || !CalculateOr(target->requires_grad, args->requires_grad...)) {
+    return true;
+  }
+  if (target->requires_grad && target.IsLeaf()) {
+    throw std::runtime_error("A leaf variable which requires gradient can't be modified in-place");
+  }
+  return false;
+}
+
+}  // namespace helpers
+
+//  In-place counterparts of the operations above. The value of `target` is overwritten and its version
+//  is bumped when autograd allows it, otherwise `target` is rebound to the result of the ordinary
+//  operation. Leaves requiring gradient may only be modified under TNoGradGuard.
+//  Sums also stay in place inside the graph: an operation node requiring gradient which nothing but
+//  `target` refers to (so no other node has used its value yet) takes the term into its value, unless
+//  its Backward reads that value (see IVariable::AccumulateInplace). A node added to itself is never
+//  taken in place, it would hold a reference to itself as a term
+template<CTensor T>
+TVariable<T>& AddInplace(TVariable<T>& target, const TVariable<T>& other) {
+  if (helpers::CanModifyInplace(target, other)) {
+    target->value += other->value;
+    ++target->version;
+  } else if (target.use_count() > 1 || target.get() == other.get() ||
+             !target->AccumulateInplace(other, /* subtract = */ false)) {
+    target = target + other;
+  }
+  return target;
+}
+
+template<CTensor T>
+TVariable<T>& SubInplace(TVariable<T>& target, const TVariable<T>& other) {
+  if (helpers::CanModifyInplace(target, other)) {
+    target->value -= other->value;
+    ++target->version;
+  } else if (target.use_count() > 1 || target.get() == other.get() ||
+             !target->AccumulateInplace(other, /* subtract = */ true)) {
+    target = target - other;
+  }
+  return target;
+}
+
+template<CTensor T>
+TVariable<T>& MulInplace(TVariable<T>& target, const TVariable<T>& other) {
+  if (helpers::CanModifyInplace(target, other)) {
+    target->value *= other->value;
+    ++target->version;
+  } else {
+    target = target * other;
+  }
+  return target;
+}
+
+template<CTensor T>
+TVariable<T>& TanhInplace(TVariable<T>& target) {
+  if (helpers::CanModifyInplace(target)) {
+    ApplyFunctionInplace<T::DimensionCount>([](typename T::TData x) {
+      return std::tanh(x);
+    }, target->value);
+    ++target->version;
+  } else {
+    target = Tanh(target);
+  }
+  return target;
+}
+
+template<CTensor T>
+TVariable<T>& SigmoidInplace(TVariable<T>& target) {
+  if (helpers::CanModifyInplace(target)) {
+    ApplyFunctionInplace<T::DimensionCount>([](typename T::TData x) {
+      return 1 / (1 + std::exp(-x));
+    }, target->value);
+    ++target->version;
+  } else {
+    target = Sigmoid(target);
+  }
+  return target;
 }
 
 }
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+
+namespace dllib {
+
+//  Brain floating point: the upper half of an IEEE single, so it has the range of float with 8 bits of
+//  precision. It's a storage type, arithmetic goes through float and the result is rounded to nearest
+//  even when it's stored back. Usable as TData of tensors and variables, e.g. to run forward and backward
+//  of a model in half the memory (see TMixedPrecision)
+class TBFloat16 {
+ public:
+  constexpr TBFloat16() = default;
+
+  // NOLINTNEXTLINE
+  constexpr TBFloat16(float value) : bits_(Round(value)) {
+  }
+
+  // NOLINTNEXTLINE
+  constexpr operator float() const {
+    return std::bit_cast<float>(uint32_t(bits_) << 16);
+  }
+
+  [[nodiscard]] static constexpr TBFloat16 FromBits(uint16_t bits) {
+    TBFloat16 result;
+    result.bits_ = bits;
+    return result;
+  }
+
+  [[nodiscard]] constexpr uint16_t Bits() const {
+    return bits_;
+  }
+
+  constexpr TBFloat16& operator+=(float other) {
+    return *this = float(*this) + other;
+  }
+
+  constexpr TBFloat16& operator-=(float other) {
+    return *this = float(*this) - other;
+  }
+
+  constexpr TBFloat16& operator*=(float other) {
+    return *this = float(*this) * other;
+  }
+
+  constexpr TBFloat16& operator/=(float other) {
+    return *this = float(*this) / other;
+  }
+
+  void Dump(std::ostream& out) const {
+    out.write(reinterpret_cast<const char*>(&bits_), sizeof(bits_));
+  }
+
+  void Load(std::istream& in) {
+    in.read(reinterpret_cast<char*>(&bits_), sizeof(bits_));
+  }
+
+ private:
+  static constexpr uint16_t Round(float value) {
+    uint32_t bits = std::bit_cast<uint32_t>(value);
+    //  Rounding could carry a NaN payload into infinity, keep it a (quiet) NaN instead
+    if ((bits & 0x7fffffff) > 0x7f800000) {
+      return uint16_t((bits >> 16) | 0x40);
+    }
+    bits += 0x7fff + ((bits >> 16) & 1);
+    return uint16_t(bits >> 16);
+  }
+
+  uint16_t bits_ = 0;
+};
+
+static_assert(sizeof(TBFloat16) == 2);
+
+}  // namespace dllib
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <dllib/tensor.hpp>
+#include <dllib/autograd.hpp>
+#include <dllib/layer.hpp>
+
+#include <cmath>
+#include <utility>
+
+namespace dllib {
+
+//  Runs `function` on `input` without keeping any of the intermediate values: only the input and the
+//  result are stored, the rest of the segment is recomputed during Backward. `function` must map
+//  TVariable<TIn> to a TVariable and may only capture leaves (e.g. layer parameters) besides its input.
+//  The state of helpers::entropy is saved, so DropOut masks are the same in the recomputed segment, and
+//  the recomputation runs with helpers::checkpoint_recompute_enabled, so BatchNorm doesn't update its
+//  running statistics twice.
+template<CTensor TIn, class TFunction>
+auto Checkpoint(TFunction function, const TVariable<TIn>& input) {
+  using TOut = typename std::invoke_result_t<TFunction&, const TVariable<TIn>&>::TUnderlying;
+
+  struct TCheckpoint {
+    static constexpr bool AlwaysRequiresGrad() {
+      return true;
+    }
+
+    static constexpr bool WritesOutsideArguments() {
+      return true;
+    }
+
+    TOut Forward(const TIn& val) {
+      //  The graph of the segment is released as soon as its value is copied out. TNoGradGuard is not
+      //  used here on purpose: it would turn DropOut into an identity
+      entropy_ = helpers::entropy;
+      return function_(TVariable<TIn>(val, false))->value;
+    }
+
+    void Backward(const IVariable<TOut>* current, TVariable<TIn>& parent) {
+      TVariable<TIn> recomputed_input(parent->value, parent->requires_grad);
+
+      auto output = [this, &recomputed_input] {
+        helpers::TEntropySwapGuard entropy_guard(entropy_);
+        helpers::TCheckpointRecomputeGuard recompute_guard;
+        return function_(recomputed_input);
+      }();
+
+      if (output->requires_grad) {
+        output->Backward(current->grad);
+      }
+      if (parent->requires_grad) {
+        parent->grad += recomputed_input->grad;
+      }
+    }
+
+    TFunction function_;
+    std::mt19937 entropy_;
+  };
+
+  return MakeOperation(TCheckpoint{std::move(function), {}}, input);
+}
+
+//  Applies `function(i, x)` for i from 0 to depth - 1, checkpointing every `segment` consecutive steps.
+//  With the default segment of sqrt(depth) steps, activation memory is O(sqrt(depth)) at the cost of one
+//  extra forward pass.
+template<CTensor T, class TFunction>
+TVariable<T> CheckpointSequential(TFunction function, size_t depth, TVariable<T> x, size_t segment = 0) {
+  if (segment == 0) {
+    segment = std::max<size_t>(1, std::lround(std::sqrt(depth)));
+  }
+
+  for (size_t begin = 0; begin < depth; begin += segment) {
+    size_t end = std::min(depth, begin + segment);
+    x = Checkpoint([function, begin, end](TVariable<T> value) {
+      for (size_t i = begin; i < end; ++i) {
+        value = function(i, value);
+      }
+      return value;
+    }, x);
+  }
+  return x;
+}
+
+}  // namespace dllib
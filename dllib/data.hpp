@@ -0,0 +1,290 @@
+#pragma once
+
+#include <dllib/tensor.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dllib {
+
+namespace helpers {
+
+//  Layout of a dataset file: this header followed by `samples` records of `features` floats and then
+//  `targets` floats each, in native byte order
+struct TDatasetHeader {
+  static constexpr char Magic[8] = {'D', 'L', 'L', 'D', 'A', 'T', 'A', '1'};
+
+  char magic[8];
+  uint64_t samples;
+  uint64_t features;
+  uint64_t targets;
+};
+
+static_assert(sizeof(TDatasetHeader) % alignof(float) == 0);
+
+}  // namespace helpers
+
+//  Writes samples to a dataset file for TMappedDataset, the header is completed by Close(). The destructor
+//  closes the file too but can't report a failure, so call Close() explicitly to find out whether it's written
+template<size_t Features, size_t Targets = 1>
+class TDatasetWriter {
+ public:
+  explicit TDatasetWriter(const std::string& path) : out_(path, std::ios::binary | std::ios::trunc) {
+    if (!out_) {
+      throw std::runtime_error("Can't open " + path + " for writing");
+    }
+    WriteHeader();
+  }
+
+  TDatasetWriter(const TDatasetWriter&) = delete;
+  TDatasetWriter& operator=(const TDatasetWriter&) = delete;
+
+  ~TDatasetWriter() {
+    if (out_.is_open()) {
+      try {
+        Close();
+      } catch (...) {
+        //  Destructors must not throw, the error is only reported by an explicit Close()
+      }
+    }
+  }
+
+  void Add(const TTensor<float, Features>& features, const TTensor<float, Targets>& targets) {
+    out_.write(reinterpret_cast<const char*>(&features), sizeof(features));
+    out_.write(reinterpret_cast<const char*>(&targets), sizeof(targets));
+    ++samples_;
+  }
+
+  void Close() {
+    out_.seekp(0);
+    WriteHeader();
+    out_.close();
+    if (out_.fail()) {
+      throw std::runtime_error("Failed to write the dataset");
+    }
+  }
+
+ private:
+  void WriteHeader() {
+    helpers::TDatasetHeader header{};
+    std::copy(std::begin(header.Magic), std::end(header.Magic), header.magic);
+    header.samples = samples_;
+    header.features = Features;
+    header.targets = Targets;
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  }
+
+  std::ofstream out_;
+  uint64_t samples_ = 0;
+};
+
+//  Read only view of a dataset file mapped into memory: samples are read straight from the page cache
+//  without copying or parsing, and only the pages that are touched are ever loaded
+template<size_t Features, size_t Targets = 1>
+class TMappedDataset {
+ public:
+  using TFeatures = TTensor<float, Features>;
+  using TTargets = TTensor<float, Targets>;
+
+  explicit TMappedDataset(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("open " + path + ": " + std::strerror(errno));
+    }
+    struct stat info{};
+    if (fstat(fd, &info) < 0) {
+      close(fd);
+      throw std::runtime_error("fstat " + path + ": " + std::strerror(errno));
+    }
+    bytes_ = size_t(info.st_size);
+    if (bytes_ < sizeof(helpers::TDatasetHeader)) {
+      close(fd);
+      throw std::runtime_error(path + " is not a dataset: too short");
+    }
+    data_ = mmap(nullptr, bytes_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data_ == MAP_FAILED) {
+      data_ = nullptr;
+      throw std::runtime_error("mmap " + path + ": " + std::strerror(errno));
+    }
+
+    try {
+      Validate(path);
+    } catch (...) {
+      munmap(data_, bytes_);
+      throw;
+    }
+  }
+
+  TMappedDataset(const TMappedDataset&) = delete;
+  TMappedDataset& operator=(const TMappedDataset&) = delete;
+
+  ~TMappedDataset() {
+    if (data_) {
+      munmap(data_, bytes_);
+    }
+  }
+
+  [[nodiscard]] size_t Size() const {
+    return size_;
+  }
+
+  [[nodiscard]] const TFeatures& GetFeatures(size_t index) const {
+    return *reinterpret_cast<const TFeatures*>(Record(index));
+  }
+
+  [[nodiscard]] const TTargets& GetTargets(size_t index) const {
+    return *reinterpret_cast<const TTargets*>(Record(index) + sizeof(TFeatures));
+  }
+
+ private:
+  static constexpr size_t RecordBytes = sizeof(TFeatures) + sizeof(TTargets);
+
+  void Validate(const std::string& path) {
+    const auto& header = *static_cast<const helpers::TDatasetHeader*>(data_);
+    if (!std::equal(std::begin(header.Magic), std::end(header.Magic), header.magic)) {
+      throw std::runtime_error(path + " is not a dataset: wrong magic");
+    }
+    if (header.features != Features || header.targets != Targets) {
+      throw std::runtime_error(
+        path + " has " + std::to_string(header.features) + " features and " + std::to_string(header.targets) +
+        " targets, expected " + std::to_string(Features) + " and " + std::to_string(Targets));
+    }
+    if ((bytes_ - sizeof(helpers::TDatasetHeader)) / RecordBytes < header.samples) {
+      throw std::runtime_error(path + " is truncated");
+    }
+    size_ = header.samples;
+  }
+
+  [[nodiscard]] const std::byte* Record(size_t index) const {
+    return static_cast<const std::byte*>(data_) + sizeof(helpers::TDatasetHeader) + index * RecordBytes;
+  }
+
+  void* data_ = nullptr;
+  size_t bytes_ = 0;
+  size_t size_ = 0;
+};
+
+//  Endless stream of batches from a dataset. A background thread shuffles the sample order once per
+//  epoch and gathers the samples of the next batch into one of two buffers while the training thread
+//  works on the other one, so with a step slower than gathering Next() returns immediately. An epoch that
+//  doesn't divide into batches continues into the next one
+template<size_t Batch, size_t Features, size_t Targets = 1>
+class TBatchLoader {
+ public:
+  struct TBatch {
+    TTensor<float, Batch, Features> features;
+    TTensor<float, Batch, Targets> targets;
+  };
+
+  explicit TBatchLoader(const TMappedDataset<Features, Targets>& dataset, bool shuffle = true, uint64_t seed = 0)
+    : dataset_(dataset),
+      buffers_(2),
+      order_(dataset.Size()),
+      shuffle_(shuffle),
+      gen_(seed) {
+
+    if (dataset.Size() == 0) {
+      throw std::runtime_error("Can't load batches from an empty dataset");
+    }
+    std::iota(order_.begin(), order_.end(), size_t(0));
+    position_ = order_.size();
+    worker_ = std::jthread([this](std::stop_token stop) {
+      Prefetch(stop);
+    });
+  }
+
+  TBatchLoader(const TBatchLoader&) = delete;
+  TBatchLoader& operator=(const TBatchLoader&) = delete;
+
+  //  The next batch, valid until the following call
+  const TBatch& Next() {
+    std::unique_lock lock(mutex_);
+    if (current_ != NoBuffer) {
+      filled_[current_] = false;
+      changed_.notify_all();
+    }
+    current_ = current_ == 0 ? 1 : 0;
+    changed_.wait(lock, [this] {
+      return filled_[current_];
+    });
+    return buffers_[current_];
+  }
+
+  //  Number of full passes over the dataset started so far by the background thread
+  [[nodiscard]] size_t Epoch() const {
+    std::lock_guard guard(mutex_);
+    return epoch_;
+  }
+
+ private:
+  static constexpr size_t NoBuffer = 2;
+
+  void Prefetch(std::stop_token stop) {
+    for (size_t slot = 0; ; slot = 1 - slot) {
+      {
+        std::unique_lock lock(mutex_);
+        if (!changed_.wait(lock, stop, [this, slot] { return !filled_[slot]; })) {
+          return;
+        }
+      }
+      Gather(buffers_[slot]);
+      {
+        std::lock_guard guard(mutex_);
+        filled_[slot] = true;
+      }
+      changed_.notify_all();
+    }
+  }
+
+  void Gather(TBatch& batch) {
+    for (size_t b = 0; b < Batch; ++b) {
+      if (position_ == order_.size()) {
+        if (shuffle_) {
+          std::shuffle(order_.begin(), order_.end(), gen_);
+        }
+        position_ = 0;
+        std::lock_guard guard(mutex_);
+        ++epoch_;
+      }
+      size_t index = order_[position_++];
+      batch.features[b] = dataset_.GetFeatures(index);
+      batch.targets[b] = dataset_.GetTargets(index);
+    }
+  }
+
+  const TMappedDataset<Features, Targets>& dataset_;
+  std::vector<TBatch> buffers_;
+  bool filled_[2] = {false, false};
+  size_t current_ = NoBuffer;
+
+  //  Owned by the background thread
+  std::vector<size_t> order_;
+  size_t position_ = 0;
+  const bool shuffle_;
+  std::mt19937_64 gen_;
+
+  size_t epoch_ = 0;
+  mutable std::mutex mutex_;
+  std::condition_variable_any changed_;
+  //  Last, so that it's stopped and joined before anything it uses is destroyed
+  std::jthread worker_;
+};
+
+}  // namespace dllib
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <dllib/tensor.hpp>
+#include <dllib/autograd.hpp>
+#include <dllib/optimizer.hpp>
+#include <dllib/parallel.hpp>
+
+#include <vector>
+
+namespace dllib {
+
+//  Synchronous data parallelism over the threads of a pool. The model is replicated, every replica runs
+//  forward and backward on its shard of the batch concurrently, then the gradients of the replicas are
+//  summed by a tree reduction (log2 of the number of replicas rounds of pairwise additions, the pairs of
+//  a round run in parallel) and added to the gradients of the model. A single optimizer built on the
+//  model then makes the step, and the next Backward copies the updated values back to the replicas.
+//
+//  Gradients are summed, so with a loss summed over samples the result matches one step on the whole
+//  batch up to floating point summation order; with a mean the shard losses need to be scaled by the
+//  shard size over the batch size
+template<class TModel>
+class TDataParallel {
+ public:
+  TDataParallel(TModel& model, TThreadPool& pool, size_t replicas = 0)
+    : model_(model),
+      pool_(pool) {
+
+    if (replicas == 0) {
+      replicas = pool.Size();
+    }
+    replicas_.reserve(replicas);
+    for (size_t i = 0; i < replicas; ++i) {
+      replicas_.push_back(helpers::MakeReplica(model));
+    }
+  }
+
+  //  Runs `step(replica, shard)` for every shard from 0 to Size() - 1 and accumulates the gradients of
+  //  the scalar losses it returns into the gradients of the model. If a step or its Backward throws, the
+  //  exception is rethrown here, the gradients of the replicas are dropped and the model is left as it was
+  template<class TStep>
+  void Backward(TStep&& step) {
+    for (size_t shard = 0; shard < replicas_.size(); ++shard) {
+      pool_.Submit([this, shard, &step] {
+        auto& replica = replicas_[shard];
+        ForEachParameter([](auto& shared, auto& local) {
+          local->value = shared->value;
+        }, model_, replica);
+        step(replica, shard)->Backward();
+      });
+    }
+    try {
+      pool_.Wait();
+    } catch (...) {
+      for (auto& replica : replicas_) {
+        ForEachParameter([](auto& local) {
+          local->ZeroGrad();
+        }, replica);
+      }
+      throw;
+    }
+
+    for (size_t stride = 1; stride < replicas_.size(); stride *= 2) {
+      for (size_t i = 0; i + stride < replicas_.size(); i += 2 * stride) {
+        pool_.Submit([this, i, stride] {
+          ForEachParameter([](auto& to, auto& from) {
+            to->grad += from->grad;
+            from->ZeroGrad();
+          }, replicas_[i], replicas_[i + stride]);
+        });
+      }
+      pool_.Wait();
+    }
+
+    ForEachParameter([](auto& shared, auto& local) {
+      shared->grad += local->grad;
+      local->ZeroGrad();
+    }, model_, replicas_.front());
+  }
+
+  [[nodiscard]] size_t Size() const {
+    return replicas_.size();
+  }
+
+ private:
+  TModel& model_;
+  TThreadPool& pool_;
+  std::vector<TModel> replicas_;
+};
+
+}  // namespace dllib
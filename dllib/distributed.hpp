@@ -0,0 +1,534 @@
+#pragma once
+
+#include <dllib/tensor.hpp>
+#include <dllib/autograd.hpp>
+#include <dllib/optimizer.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace dllib {
+
+//  Connection of a process (a rank) to its neighbours in a ring of `Size()` processes
+class ITransport {
+ public:
+  [[nodiscard]] virtual size_t Rank() const = 0;
+
+  [[nodiscard]] virtual size_t Size() const = 0;
+
+  //  Sends `to_next` to the rank Rank() + 1 and receives `from_previous` from the rank Rank() - 1 (both
+  //  modulo Size()) at the same time, returns when both are done
+  virtual void Exchange(std::span<const std::byte> to_next, std::span<std::byte> from_previous) = 0;
+
+  virtual ~ITransport() = default;
+};
+
+namespace helpers {
+
+//  `error` has to be saved by the caller if anything (e.g. close) runs between the failed call and this one
+[[noreturn]] inline void ThrowSystemError(const std::string& what, int error = errno) {
+  throw std::runtime_error(what + ": " + std::strerror(error));
+}
+
+}  // namespace helpers
+
+//  Ranks connected by Unix domain sockets in `directory`. Every rank listens on its own socket, connects
+//  to the next rank and accepts the previous one, waiting up to `timeout` for the others to start
+class TUnixSocketTransport final : public ITransport {
+ public:
+  TUnixSocketTransport(
+    const std::string& directory,
+    size_t rank,
+    size_t size,
+    std::chrono::milliseconds timeout = std::chrono::seconds(30))
+    : rank_(rank),
+      size_(size) {
+
+    if (size_ == 1) {
+      return;
+    }
+
+    std::string own_path = SocketPath(directory, rank_);
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+      helpers::ThrowSystemError("socket");
+    }
+    auto own_address = MakeAddress(own_path);
+    unlink(own_path.c_str());
+    if (bind(listener, reinterpret_cast<sockaddr*>(&own_address), sizeof(own_address)) < 0 || listen(listener, 1) < 0) {
+      int error = errno;
+      close(listener);
+      helpers::ThrowSystemError("bind " + own_path, error);
+    }
+
+    //  The state of a socket is unspecified after a failed connect, so every attempt opens a new one
+    auto next_address = MakeAddress(SocketPath(directory, (rank_ + 1) % size_));
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true) {
+      next_ = socket(AF_UNIX, SOCK_STREAM, 0);
+      if (next_ < 0) {
+        int error = errno;
+        close(listener);
+        helpers::ThrowSystemError("socket", error);
+      }
+      if (connect(next_, reinterpret_cast<sockaddr*>(&next_address), sizeof(next_address)) == 0) {
+        break;
+      }
+      int error = errno;
+      close(next_);
+      if ((error != ENOENT && error != ECONNREFUSED) || std::chrono::steady_clock::now() > deadline) {
+        close(listener);
+        helpers::ThrowSystemError("connect to rank " + std::to_string((rank_ + 1) % size_), error);
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    previous_ = accept(listener, nullptr, nullptr);
+    int accept_error = errno;
+    close(listener);
+    unlink(own_path.c_str());
+    if (previous_ < 0) {
+      close(next_);
+      helpers::ThrowSystemError("accept", accept_error);
+    }
+
+    fcntl(next_, F_SETFL, fcntl(next_, F_GETFL) | O_NONBLOCK);
+    fcntl(previous_, F_SETFL, fcntl(previous_, F_GETFL) | O_NONBLOCK);
+  }
+
+  TUnixSocketTransport(const TUnixSocketTransport&) = delete;
+  TUnixSocketTransport& operator=(const TUnixSocketTransport&) = delete;
+
+  ~TUnixSocketTransport() override {
+    if (next_ >= 0) {
+      close(next_);
+    }
+    if (previous_ >= 0) {
+      close(previous_);
+    }
+  }
+
+  [[nodiscard]] size_t Rank() const final {
+    return rank_;
+  }
+
+  [[nodiscard]] size_t Size() const final {
+    return size_;
+  }
+
+  void Exchange(std::span<const std::byte> to_next, std::span<std::byte> from_previous) final {
+    size_t sent = 0;
+    size_t received = 0;
+    while (sent < to_next.size() || received < from_previous.size()) {
+      pollfd fds[2] = {
+        {next_, short(sent < to_next.size() ? POLLOUT : 0), 0},
+        {previous_, short(received < from_previous.size() ? POLLIN : 0), 0},
+      };
+      if (poll(fds, 2, -1) < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        helpers::ThrowSystemError("poll");
+      }
+      //  POLLHUP is reported even for a descriptor polled for nothing, once the neighbour is done and gone
+      if (sent < to_next.size() && (fds[0].revents & (POLLOUT | POLLERR | POLLHUP))) {
+        ssize_t n = send(next_, to_next.data() + sent, to_next.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno != EAGAIN && errno != EINTR) {
+          helpers::ThrowSystemError("send");
+        }
+        sent += std::max<ssize_t>(n, 0);
+      }
+      if (received < from_previous.size() && (fds[1].revents & (POLLIN | POLLERR | POLLHUP))) {
+        ssize_t n = recv(previous_, from_previous.data() + received, from_previous.size() - received, 0);
+        if (n == 0) {
+          throw std::runtime_error("The previous rank has closed the connection");
+        }
+        if (n < 0 && errno != EAGAIN && errno != EINTR) {
+          helpers::ThrowSystemError("recv");
+        }
+        received += std::max<ssize_t>(n, 0);
+      }
+    }
+  }
+
+ private:
+  static std::string SocketPath(const std::string& directory, size_t rank) {
+    return directory + "/rank" + std::to_string(rank) + ".sock";
+  }
+
+  static sockaddr_un MakeAddress(const std::string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+      throw std::runtime_error("Socket path is too long: " + path);
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+  }
+
+  size_t rank_;
+  size_t size_;
+  int next_ = -1;
+  int previous_ = -1;
+};
+
+//  Ranks on one host connected by single-producer single-consumer byte rings in POSIX shared memory.
+//  The ring into rank r is named `name`-r, it's created by whichever of its two ends comes first and
+//  unlinked by the receiver. `name` must be unique per training job, segments left behind by a crashed
+//  job with the same name would be reused as they are
+class TSharedMemoryTransport final : public ITransport {
+ public:
+  TSharedMemoryTransport(const std::string& name, size_t rank, size_t size, size_t capacity = 1 << 20)
+    : rank_(rank),
+      size_(size),
+      capacity_(capacity),
+      inbound_name_(name + "-" + std::to_string(rank)) {
+
+    if (size_ == 1) {
+      return;
+    }
+    inbound_ = Map(inbound_name_);
+    outbound_ = Map(name + "-" + std::to_string((rank_ + 1) % size_));
+  }
+
+  TSharedMemoryTransport(const TSharedMemoryTransport&) = delete;
+  TSharedMemoryTransport& operator=(const TSharedMemoryTransport&) = delete;
+
+  ~TSharedMemoryTransport() override {
+    if (inbound_) {
+      munmap(inbound_, SegmentBytes());
+      shm_unlink(inbound_name_.c_str());
+    }
+    if (outbound_) {
+      munmap(outbound_, SegmentBytes());
+    }
+  }
+
+  [[nodiscard]] size_t Rank() const final {
+    return rank_;
+  }
+
+  [[nodiscard]] size_t Size() const final {
+    return size_;
+  }
+
+  void Exchange(std::span<const std::byte> to_next, std::span<std::byte> from_previous) final {
+    size_t sent = 0;
+    size_t received = 0;
+    while (sent < to_next.size() || received < from_previous.size()) {
+      size_t progress = 0;
+
+      if (sent < to_next.size()) {
+        uint64_t written = outbound_->written.load(std::memory_order_relaxed);
+        uint64_t free = capacity_ - (written - outbound_->read.load(std::memory_order_acquire));
+        size_t n = Copy(
+          std::min<size_t>(free, to_next.size() - sent), written,
+          [this, &to_next, sent](size_t offset, size_t at, size_t bytes) {
+            std::memcpy(Data(outbound_) + at, to_next.data() + sent + offset, bytes);
+          });
+        outbound_->written.store(written + n, std::memory_order_release);
+        sent += n;
+        progress += n;
+      }
+
+      if (received < from_previous.size()) {
+        uint64_t read = inbound_->read.load(std::memory_order_relaxed);
+        uint64_t available = inbound_->written.load(std::memory_order_acquire) - read;
+        size_t n = Copy(
+          std::min<size_t>(available, from_previous.size() - received), read,
+          [this, &from_previous, received](size_t offset, size_t at, size_t bytes) {
+            std::memcpy(from_previous.data() + received + offset, Data(inbound_) + at, bytes);
+          });
+        inbound_->read.store(read + n, std::memory_order_release);
+        received += n;
+        progress += n;
+      }
+
+      if (progress == 0) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+ private:
+  struct TRingHeader {
+    alignas(64) std::atomic<uint64_t> written;
+    alignas(64) std::atomic<uint64_t> read;
+  };
+
+  static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+  [[nodiscard]] size_t SegmentBytes() const {
+    return sizeof(TRingHeader) + capacity_;
+  }
+
+  static std::byte* Data(TRingHeader* ring) {
+    return reinterpret_cast<std::byte*>(ring + 1);
+  }
+
+  //  Splits `bytes` starting at the ring position `position` into at most two contiguous pieces
+  template<class TCopy>
+  size_t Copy(size_t bytes, uint64_t position, TCopy&& copy) const {
+    size_t at = position % capacity_;
+    size_t first = std::min(bytes, capacity_ - at);
+    copy(0, at, first);
+    if (first < bytes) {
+      copy(first, 0, bytes - first);
+    }
+    return bytes;
+  }
+
+  TRingHeader* Map(const std::string& name) const {
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+    if (fd < 0) {
+      helpers::ThrowSystemError("shm_open " + name);
+    }
+    //  Both ends truncate to the same size, a fresh segment is zero filled
+    if (ftruncate(fd, off_t(SegmentBytes())) < 0) {
+      int error = errno;
+      close(fd);
+      helpers::ThrowSystemError("ftruncate " + name, error);
+    }
+    void* memory = mmap(nullptr, SegmentBytes(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int mmap_error = errno;
+    close(fd);
+    if (memory == MAP_FAILED) {
+      helpers::ThrowSystemError("mmap " + name, mmap_error);
+    }
+    return static_cast<TRingHeader*>(memory);
+  }
+
+  size_t rank_;
+  size_t size_;
+  size_t capacity_;
+  std::string inbound_name_;
+  TRingHeader* inbound_ = nullptr;
+  TRingHeader* outbound_ = nullptr;
+};
+
+//  Sums `data` over all ranks in place: Size() - 1 steps of reduce-scatter followed by Size() - 1 steps
+//  of all-gather, every rank sends and receives 2 (Size() - 1) / Size() of the data in total
+template<class TData>
+void RingAllReduce(ITransport& transport, std::span<TData> data) {
+  size_t size = transport.Size();
+  if (size == 1 || data.empty()) {
+    return;
+  }
+  size_t rank = transport.Rank();
+  size_t chunk = (data.size() + size - 1) / size;
+  auto chunk_of = [&data, chunk](size_t index) {
+    size_t begin = std::min(data.size(), index * chunk);
+    return data.subspan(begin, std::min(data.size(), begin + chunk) - begin);
+  };
+
+  std::vector<TData> incoming(chunk);
+  for (size_t step = 0; step + 1 < size; ++step) {
+    auto to_send = chunk_of((rank + size - step) % size);
+    auto to_reduce = chunk_of((rank + size - step - 1) % size);
+    transport.Exchange(std::as_bytes(to_send), std::as_writable_bytes(std::span(incoming).first(to_reduce.size())));
+    for (size_t i = 0; i < to_reduce.size(); ++i) {
+      to_reduce[i] += incoming[i];
+    }
+  }
+  for (size_t step = 0; step + 1 < size; ++step) {
+    auto to_send = chunk_of((rank + 1 + size - step) % size);
+    auto to_receive = chunk_of((rank + size - step) % size);
+    transport.Exchange(std::as_bytes(to_send), std::as_writable_bytes(to_receive));
+  }
+}
+
+//  Data parallelism across processes: every rank holds a replica of the model initialized with the same
+//  values, runs Backward on its part of the batch, and the gradients are summed over all ranks by ring
+//  all-reduce, so that the same optimizer step on every rank keeps the replicas identical.
+//
+//  Parameters are grouped into buckets of about `bucket_bytes` in reverse order of GetParameters(),
+//  which is roughly the order their gradients become final. Backward walks the graph in the order of
+//  IVariable::Backward and hands a bucket to a communication thread as soon as the last gradient in it
+//  is final, so reduction of the last layers overlaps with backward through the first ones. Buckets are
+//  always reduced in the same order, so ranks never wait for each other's different buckets. Gradients
+//  are exchanged as raw memory of the tensors, all parameters must have the same TData. If the transport
+//  throws, the rest of the buckets aren't reduced and the exception is rethrown by Backward
+template<class TModel, class TData = float>
+class TDistributedDataParallel {
+ public:
+  TDistributedDataParallel(TModel& model, ITransport& transport, size_t bucket_bytes = 1 << 20)
+    : transport_(transport) {
+
+    ForEachParameter([this](auto& var) {
+      using T = typename std::remove_cvref_t<decltype(var)>::TUnderlying;
+      static_assert(std::is_same_v<typename T::TData, TData>, "All parameters must have the same TData");
+      parameters_.push_back({var.get(), &var->grad.template View<-1u>()[0].Data(), T::TotalElements, 0});
+    }, model);
+
+    for (size_t i = parameters_.size(); i-- > 0;) {
+      if (buckets_.empty() || (buckets_.back().size + parameters_[i].size) * sizeof(TData) > bucket_bytes) {
+        buckets_.emplace_back();
+      }
+      auto& bucket = buckets_.back();
+      parameters_[i].bucket = buckets_.size() - 1;
+      bucket.parameters.push_back(i);
+      bucket.size += parameters_[i].size;
+    }
+    for (auto& bucket : buckets_) {
+      bucket.buffer.resize(bucket.size);
+    }
+    for (size_t i = 0; i < parameters_.size(); ++i) {
+      index_[parameters_[i].node] = i;
+    }
+  }
+
+  template<CTensor T>
+  void Backward(const TVariable<T>& loss) {
+    static_assert(T::DimensionCount == 0, "Backward without an explicit gradient requires a scalar");
+
+    for (auto& bucket : buckets_) {
+      bucket.pending = bucket.parameters.size();
+    }
+    communication_failed_ = false;
+    std::exception_ptr communication_error;
+    std::jthread communication([this, &communication_error] {
+      try {
+        Communicate();
+      } catch (...) {
+        communication_error = std::current_exception();
+        std::lock_guard guard(mutex_);
+        communication_failed_ = true;
+      }
+    });
+
+    std::unordered_set<IArbitraryVariable*> sub_graph;
+    std::vector<IArbitraryVariable*> order;
+    auto dfs = [&sub_graph, &order](auto& self, IArbitraryVariable* v) -> void {
+      sub_graph.insert(v);
+      for (auto* child : v->GetChildren()) {
+        if (child->requires_grad && !sub_graph.contains(child)) {
+          self(self, child);
+        }
+      }
+      order.push_back(v);
+    };
+    for (auto* child : loss->GetChildren()) {
+      if (child->requires_grad && !sub_graph.contains(child)) {
+        dfs(dfs, child);
+      }
+    }
+
+    //  Parameters outside of the graph have zero gradients here, but not necessarily on other ranks. The
+    //  same goes for the rest of the parameters if backward throws, the communication thread can't stop
+    //  half way without hanging the other ranks
+    std::vector<bool> done(parameters_.size());
+    auto finish = [this, &done] {
+      for (size_t i = 0; i < parameters_.size(); ++i) {
+        if (!done[i]) {
+          MarkFinal(i);
+        }
+      }
+    };
+
+    try {
+      loss->grad = T(1);
+      loss->PushGradient();
+      for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        (*it)->PushGradient();
+        if (auto found = index_.find(*it); found != index_.end()) {
+          done[found->second] = true;
+          MarkFinal(found->second);
+        }
+      }
+    } catch (...) {
+      finish();
+      throw;
+    }
+    finish();
+
+    communication.join();
+    if (communication_error) {
+      std::rethrow_exception(communication_error);
+    }
+  }
+
+  [[nodiscard]] size_t BucketCount() const {
+    return buckets_.size();
+  }
+
+ private:
+  struct TParameter {
+    IArbitraryVariable* node;
+    TData* grad;
+    size_t size;
+    size_t bucket;
+  };
+
+  struct TBucket {
+    std::vector<size_t> parameters;
+    std::vector<TData> buffer;
+    size_t size = 0;
+    size_t pending = 0;
+  };
+
+  //  After the communication thread has failed nobody waits for the buckets, the rest are left as they are
+  void MarkFinal(size_t parameter) {
+    auto& bucket = buckets_[parameters_[parameter].bucket];
+    std::lock_guard guard(mutex_);
+    if (communication_failed_) {
+      return;
+    }
+    if (--bucket.pending == 0) {
+      ready_cv_.notify_one();
+    }
+  }
+
+  void Communicate() {
+    for (auto& bucket : buckets_) {
+      {
+        std::unique_lock lock(mutex_);
+        ready_cv_.wait(lock, [&bucket] {
+          return bucket.pending == 0;
+        });
+      }
+
+      auto position = bucket.buffer.begin();
+      for (auto i : bucket.parameters) {
+        position = std::copy_n(parameters_[i].grad, parameters_[i].size, position);
+      }
+      RingAllReduce(transport_, std::span(bucket.buffer));
+      auto from = bucket.buffer.begin();
+      for (auto i : bucket.parameters) {
+        std::copy_n(from, parameters_[i].size, parameters_[i].grad);
+        from += parameters_[i].size;
+      }
+    }
+  }
+
+  ITransport& transport_;
+  std::vector<TParameter> parameters_;
+  std::vector<TBucket> buckets_;
+  std::unordered_map<IArbitraryVariable*, size_t> index_;
+
+  std::mutex mutex_;
+  std::condition_variable ready_cv_;
+  bool communication_failed_ = false;
+};
+
+}  // namespace dllib
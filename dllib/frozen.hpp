@@ -0,0 +1,250 @@
+#pragma once
+
+#include <dllib/tensor.hpp>
+#include <dllib/autograd.hpp>
+#include <dllib/layer.hpp>
+#include <dllib/normalization.hpp>
+#include <dllib/sequential.hpp>
+#include <dllib/serialization.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <typeindex>
+#include <vector>
+
+namespace dllib {
+
+namespace helpers {
+
+template<class T>
+concept HasTensorValue = requires(const T& var) {
+  requires VIsTensor<decltype(var->value)>;
+};
+
+//  Calls `function` on every tensor reachable through GetSerializationFields, in the order Dump writes them.
+//  Scalar fields are skipped
+template<class T, class TFunction>
+void ForEachSerializedTensor(const T& value, TFunction& function) {
+  if constexpr (VIsTensor<T>) {
+    function(value);
+  } else if constexpr (HasTensorValue<T>) {
+    function(value->value);
+  } else if constexpr (HasSerializationFields<T>) {
+    std::apply([&function](const auto&... fields) {
+      (ForEachSerializedTensor(fields, function), ...);
+    }, value.GetSerializationFields());
+  } else {
+    static_assert(std::is_arithmetic_v<T>, "Only tensors, variables and objects with GetSerializationFields can be frozen");
+  }
+}
+
+}  // namespace helpers
+
+//  Copies of all the tensors of a model in one contiguous block, each aligned to Alignment bytes. Tensors
+//  are numbered in the order Dump writes them, which is also the order of the blob
+class TFrozenWeights {
+ public:
+  static constexpr size_t Alignment = 64;
+
+  template<class TModel>
+  explicit TFrozenWeights(const TModel& model) {
+    auto measure = [this](const auto& tensor) {
+      using T = std::remove_cvref_t<decltype(tensor)>;
+      static_assert(std::is_trivially_destructible_v<T>);
+      entries_.push_back({size_, typeid(T)});
+      size_ = (size_ + sizeof(T) + Alignment - 1) / Alignment * Alignment;
+    };
+    helpers::ForEachSerializedTensor(model, measure);
+
+    data_.reset(static_cast<std::byte*>(::operator new(std::max(size_, Alignment), std::align_val_t(Alignment))));
+    size_t i = 0;
+    auto copy = [this, &i](const auto& tensor) {
+      using T = std::remove_cvref_t<decltype(tensor)>;
+      new (data_.get() + entries_[i++].offset) T(tensor);
+    };
+    helpers::ForEachSerializedTensor(model, copy);
+  }
+
+  //  The i-th tensor, which should be of type T
+  template<CTensor T>
+  const T& Get(size_t i) const {
+    if (i >= entries_.size() || entries_[i].type != typeid(T)) {
+      throw std::runtime_error("Frozen weights don't have a tensor of this type at index " + std::to_string(i));
+    }
+    return *std::launder(reinterpret_cast<const T*>(data_.get() + entries_[i].offset));
+  }
+
+  size_t TensorCount() const {
+    return entries_.size();
+  }
+
+  const std::byte* Data() const {
+    return data_.get();
+  }
+
+  size_t Size() const {
+    return size_;
+  }
+
+ private:
+  struct TEntry {
+    size_t offset;
+    std::type_index type;
+  };
+
+  struct TAlignedDelete {
+    void operator()(std::byte* data) const {
+      ::operator delete(data, std::align_val_t(Alignment));
+    }
+  };
+
+  std::vector<TEntry> entries_;
+  std::unique_ptr<std::byte[], TAlignedDelete> data_;
+  size_t size_ = 0;
+};
+
+namespace helpers {
+
+//  A layer of FrozenSequential: pointers to its tensors in the blob and a const Forward on TInput, so one
+//  step can serve any number of threads at once. `index` is the number of the first tensor of the layer
+template<class TLayer, class TInput>
+struct TFrozenStep;
+
+template<class TData, size_t Batch, size_t From, size_t To>
+struct TFrozenStep<FullyConnected<TData, From, To>, TTensor<TData, Batch, From>> {
+  using TOutput = TTensor<TData, Batch, To>;
+
+  TFrozenStep(const FullyConnected<TData, From, To>&, const TFrozenWeights& weights, size_t& index)
+    : weights_(&weights.Get<TTensor<TData, From, To>>(index)),
+      bias_(&weights.Get<TTensor<TData, To>>(index + 1)) {
+    index += 2;
+  }
+
+  TOutput Forward(const TTensor<TData, Batch, From>& x) const {
+    TOutput result;
+    for (size_t b = 0; b < Batch; ++b) {
+      result[b] = *bias_;
+    }
+    MatrixProduct(x, *weights_, result);
+    return result;
+  }
+
+  const TTensor<TData, From, To>* weights_;
+  const TTensor<TData, To>* bias_;
+};
+
+template<class TFunction, CTensor TInput>
+struct TFrozenStep<Activation<TFunction>, TInput> {
+  using TOutput = TInput;
+
+  TFrozenStep(const Activation<TFunction>&, const TFrozenWeights&, size_t&) {
+  }
+
+  TOutput Forward(const TInput& x) const {
+    return Activation<TFunction>{}(x);
+  }
+};
+
+template<class TData, size_t Batch, size_t Features>
+struct TFrozenStep<LayerNorm<TData, Features>, TTensor<TData, Batch, Features>> {
+  using TOutput = TTensor<TData, Batch, Features>;
+
+  TFrozenStep(const LayerNorm<TData, Features>& layer, const TFrozenWeights& weights, size_t& index)
+    : scale_(&weights.Get<TTensor<TData, Features>>(index)),
+      shift_(&weights.Get<TTensor<TData, Features>>(index + 1)),
+      epsilon_(layer.GetEpsilon()) {
+    index += 2;
+  }
+
+  TOutput Forward(const TOutput& x) const {
+    return LayerNormalize(x, *scale_, *shift_, epsilon_);
+  }
+
+  const TTensor<TData, Features>* scale_;
+  const TTensor<TData, Features>* shift_;
+  TData epsilon_;
+};
+
+template<class TData, size_t Batch, size_t Features>
+struct TFrozenStep<BatchNorm<TData, Features>, TTensor<TData, Batch, Features>> {
+  using TOutput = TTensor<TData, Batch, Features>;
+
+  TFrozenStep(const BatchNorm<TData, Features>& layer, const TFrozenWeights& weights, size_t& index)
+    : scale_(&weights.Get<TTensor<TData, Features>>(index)),
+      shift_(&weights.Get<TTensor<TData, Features>>(index + 1)),
+      mean_(&weights.Get<TTensor<TData, Features>>(index + 2)),
+      variance_(&weights.Get<TTensor<TData, Features>>(index + 3)),
+      epsilon_(layer.GetEpsilon()) {
+    index += 4;
+  }
+
+  TOutput Forward(const TOutput& x) const {
+    return NormalizeWithStatistics(x, *scale_, *shift_, *mean_, *variance_, epsilon_);
+  }
+
+  const TTensor<TData, Features>* scale_;
+  const TTensor<TData, Features>* shift_;
+  const TTensor<TData, Features>* mean_;
+  const TTensor<TData, Features>* variance_;
+  TData epsilon_;
+};
+
+}  // namespace helpers
+
+//  Inference-only copy of a Sequential: the weights are frozen into one aligned blob and there are no
+//  variables, gradients or graph nodes left. operator() is const and keeps the activations on the stack, so
+//  it doesn't allocate and can be called concurrently from any number of threads without locking. Later
+//  changes of the source model don't affect the frozen one
+template<CTensor TInput, class... TLayers>
+class FrozenSequential {
+  using TShapes = helpers::TSequentialShapes<helpers::TFrozenStep, TInput, TLayers...>;
+  using TSteps = typename TShapes::TSteps;
+
+  static constexpr size_t LayerCount = sizeof...(TLayers);
+
+ public:
+  using TOutput = typename TShapes::TOutput;
+
+  explicit FrozenSequential(const Sequential<TInput, TLayers...>& model)
+    : weights_(model),
+      steps_([this, &model]<size_t... i>(std::index_sequence<i...>) {
+        size_t index = 0;
+        //  Braced initialization keeps the order of the layers, and so the order of the tensors
+        return TSteps{std::tuple_element_t<i, TSteps>(model.template GetLayer<i>(), weights_, index)...};
+      }(std::make_index_sequence<LayerCount>())) {
+  }
+
+  TOutput operator()(const TInput& x) const {
+    return Apply<0>(x);
+  }
+
+  const TFrozenWeights& GetWeights() const {
+    return weights_;
+  }
+
+ private:
+  template<size_t i, CTensor T>
+  auto Apply(const T& x) const {
+    if constexpr (i + 1 == LayerCount) {
+      return get<i>(steps_).Forward(x);
+    } else {
+      return Apply<i + 1>(get<i>(steps_).Forward(x));
+    }
+  }
+
+  TFrozenWeights weights_;
+  TSteps steps_;
+};
+
+template<CTensor TInput, class... TLayers>
+FrozenSequential<TInput, TLayers...> Freeze(const Sequential<TInput, TLayers...>& model) {
+  return FrozenSequential<TInput, TLayers...>(model);
+}
+
+}  // namespace dllib
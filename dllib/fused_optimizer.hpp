@@ -0,0 +1,326 @@
+#pragma once
+
+#include <dllib/tensor.hpp>
+#include <dllib/autograd.hpp>
+#include <dllib/optimizer.hpp>
+#include <dllib/parallel.hpp>
+#include <dllib/serialization.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace dllib {
+
+//  Per-element updates of TFusedOptimizer. A kernel has StateCount values of state per parameter element,
+//  kept by the optimizer in flat buffers, and scalars of its own (written by Dump once per parameter, in
+//  the format of the matching optimizer unit). Update works on a chunk of elements copied to local arrays,
+//  zeros past the end of a parameter must stay harmless
+
+template<class TDataType>
+struct TFusedSGD {
+  using TData = TDataType;
+  static constexpr size_t StateCount = 0;
+
+  explicit TFusedSGD(TData lr) : lr_(lr) {
+  }
+
+  void BeginStep() {
+  }
+
+  template<size_t N>
+  void Update(TData (&value)[N], const TData (&grad)[N], TData (&)[StateCount + 1][N]) const {
+    for (size_t i = 0; i < N; ++i) {
+      value[i] -= grad[i] * lr_;
+    }
+  }
+
+  void Dump(std::ostream&) const {
+  }
+
+  void Load(std::istream&) {
+  }
+
+  TData lr_;
+};
+
+template<class TDataType>
+struct TFusedMomentum {
+  using TData = TDataType;
+  static constexpr size_t StateCount = 1;
+
+  TFusedMomentum(TData lr, TData alpha) : lr_(lr), alpha_(alpha) {
+  }
+
+  void BeginStep() {
+  }
+
+  template<size_t N>
+  void Update(TData (&value)[N], const TData (&grad)[N], TData (&states)[StateCount + 1][N]) const {
+    auto& momentum = states[0];
+    for (size_t i = 0; i < N; ++i) {
+      momentum[i] = momentum[i] * alpha_ + grad[i];
+      value[i] -= momentum[i] * lr_;
+    }
+  }
+
+  void Dump(std::ostream&) const {
+  }
+
+  void Load(std::istream&) {
+  }
+
+  TData lr_;
+  TData alpha_;
+};
+
+template<class TDataType>
+struct TFusedAdam {
+  using TData = TDataType;
+  static constexpr size_t StateCount = 2;
+
+  explicit TFusedAdam(TData lr, TData beta1 = 0.9, TData beta2 = 0.999, TData eps = 1e-8)
+    : lr_(lr), beta1_(beta1), beta2_(beta2), eps_(eps) {
+  }
+
+  void BeginStep() {
+    beta1_power_ *= beta1_;
+    beta2_power_ *= beta2_;
+  }
+
+  template<size_t N>
+  void Update(TData (&value)[N], const TData (&grad)[N], TData (&states)[StateCount + 1][N]) const {
+    auto& m = states[0];
+    auto& v = states[1];
+    TData m_scale = 1 / (1 - beta1_power_), v_scale = 1 / (1 - beta2_power_);
+    for (size_t i = 0; i < N; ++i) {
+      m[i] = m[i] * beta1_ + grad[i] * (1 - beta1_);
+      v[i] = v[i] * beta2_ + grad[i] * grad[i] * (1 - beta2_);
+      value[i] -= m[i] * m_scale / (std::sqrt(v[i] * v_scale) + eps_) * lr_;
+    }
+  }
+
+  void Dump(std::ostream& out) const {
+    dllib::Dump(out, beta1_power_);
+    dllib::Dump(out, beta2_power_);
+  }
+
+  void Load(std::istream& in) {
+    dllib::Load(in, beta1_power_);
+    dllib::Load(in, beta2_power_);
+  }
+
+  TData lr_;
+  TData beta1_;
+  TData beta2_;
+  TData eps_;
+  TData beta1_power_ = 1;
+  TData beta2_power_ = 1;
+};
+
+//  Optimizer doing the step of all its parameters in one pass: the state of every parameter lives in flat
+//  buffers, one per kind of state, and a single loop updates the values and the state and clears the
+//  gradients, without virtual calls or temporaries per parameter. The values and gradients stay in the
+//  variables, the optimizer keeps their nodes and takes the pointers to the data once, in AddParameter:
+//  a TVariable assigned another node afterwards is not followed, unlike in TOptimizerManager.
+//  With a thread pool the elements are split between its workers. Dump and Load use the format of
+//  TOptimizerManager with the matching unit
+template<class TKernel>
+class TFusedOptimizer {
+  using TData = typename TKernel::TData;
+
+  //  Elements are processed in chunks of this size, copied to local arrays which can't alias each other
+  //  or the variables, so the update loops vectorize
+  static constexpr size_t ChunkSize = 256;
+
+ public:
+  explicit TFusedOptimizer(TKernel kernel, TThreadPool* pool = nullptr) : kernel_(std::move(kernel)), pool_(pool) {
+  }
+
+  //  Splits the following steps between the workers of `pool`, or runs them on the calling thread if null
+  void SetThreadPool(TThreadPool* pool) {
+    pool_ = pool;
+  }
+
+  template<CTensor T>
+  void AddParameter(TVariable<T>& var) {
+    static_assert(std::is_same_v<typename T::TData, TData>, "All parameters should have the type of the optimizer");
+    static_assert(sizeof(TTensor<TData>) == sizeof(TData));
+    TData* value = &var->value.template View<-1u>()[0].Data();
+    TData* grad = &var->grad.template View<-1u>()[0].Data();
+    parameters_.push_back({var, value, grad, size_, T::TotalElements});
+    for (size_t begin = 0; begin < T::TotalElements; begin += ChunkSize) {
+      chunks_.push_back({value + begin, grad + begin, size_ + begin, std::min(ChunkSize, T::TotalElements - begin)});
+    }
+    size_ += T::TotalElements;
+    for (auto& state : states_) {
+      state.resize(size_, TData(0));
+    }
+    state_charge_.Resize(TKernel::StateCount * size_ * sizeof(TData));
+  }
+
+  template<helpers::HasParameters T>
+  void AddParameter(T& val) {
+    AddParameters(val.GetParameters());
+  }
+
+  template<class... TArgs>
+  void AddParameters(const std::tuple<TArgs&...>& params) {
+    std::apply([this](auto&... param) {
+      (AddParameter(param), ...);
+    }, params);
+  }
+
+  //  Also clears the gradients, in the same pass
+  void Step() {
+    kernel_.BeginStep();
+    if (!pool_ || pool_->Size() < 2) {
+      UpdateChunks(0, chunks_.size());
+    } else {
+      size_t tasks = std::min(pool_->Size(), chunks_.size());
+      for (size_t task = 0; task < tasks; ++task) {
+        pool_->Submit([this, task, tasks] {
+          UpdateChunks(chunks_.size() * task / tasks, chunks_.size() * (task + 1) / tasks);
+        });
+      }
+      pool_->Wait();
+    }
+    ++steps_;
+    for (auto& hook : step_hooks_) {
+      hook(steps_);
+    }
+  }
+
+  void ZeroGrad() {
+    ForEachGradient([](TData* grad, size_t size) {
+      std::fill(grad, grad + size, TData(0));
+    });
+  }
+
+  [[nodiscard]] bool HasFiniteGradients() const {
+    bool finite = true;
+    ForEachGradient([&finite](TData* grad, size_t size) {
+      for (size_t i = 0; i < size; ++i) {
+        finite = finite && helpers::IsFinite(grad[i]);
+      }
+    });
+    return finite;
+  }
+
+  void ScaleGradients(float factor) {
+    ForEachGradient([factor](TData* grad, size_t size) {
+      for (size_t i = 0; i < size; ++i) {
+        grad[i] *= factor;
+      }
+    });
+  }
+
+  //  Called after every Step with the number of steps made so far (see TOptimizerManager::AddStepHook)
+  void AddStepHook(std::function<void(size_t)> hook) {
+    step_hooks_.push_back(std::move(hook));
+  }
+
+  void Dump(std::ostream& out) const {
+    for (const auto& parameter : parameters_) {
+      kernel_.Dump(out);
+      for (const auto& state : states_) {
+        for (size_t i = parameter.offset; i < parameter.offset + parameter.size; ++i) {
+          dllib::Dump(out, state[i]);
+        }
+      }
+    }
+  }
+
+  void Load(std::istream& in) {
+    for (const auto& parameter : parameters_) {
+      kernel_.Load(in);
+      for (auto& state : states_) {
+        for (size_t i = parameter.offset; i < parameter.offset + parameter.size; ++i) {
+          dllib::Load(in, state[i]);
+        }
+      }
+    }
+  }
+
+  //  Number of parameter elements, each has TKernel::StateCount values of state
+  size_t Size() const {
+    return size_;
+  }
+
+ private:
+  struct TParameter {
+    //  Keeps the value and the gradient alive for the pointers
+    std::shared_ptr<const void> node;
+    TData* value;
+    TData* grad;
+    size_t offset;
+    size_t size;
+  };
+
+  //  Elements [offset, offset + size) of the state buffers, with the matching value and gradient
+  struct TChunk {
+    TData* value;
+    TData* grad;
+    size_t offset;
+    size_t size;
+  };
+
+  template<class TFunction>
+  void ForEachGradient(TFunction&& function) const {
+    for (const auto& parameter : parameters_) {
+      function(parameter.grad, parameter.size);
+    }
+  }
+
+  void UpdateChunks(size_t first, size_t last) {
+    //  One more state than the kernel has, so that the array isn't empty
+    TData value[ChunkSize], grad[ChunkSize], states[TKernel::StateCount + 1][ChunkSize];
+    for (size_t c = first; c < last; ++c) {
+      const auto& chunk = chunks_[c];
+      size_t n = chunk.size;
+      std::copy_n(chunk.value, n, value);
+      std::copy_n(chunk.grad, n, grad);
+      for (size_t s = 0; s < TKernel::StateCount; ++s) {
+        std::copy_n(states_[s].data() + chunk.offset, n, states[s]);
+      }
+      //  The loops of the kernel always run over the whole chunk, only then they vectorize at -O2
+      if (n < ChunkSize) {
+        std::fill(value + n, value + ChunkSize, TData(0));
+        std::fill(grad + n, grad + ChunkSize, TData(0));
+        for (size_t s = 0; s < TKernel::StateCount; ++s) {
+          std::fill(states[s] + n, states[s] + ChunkSize, TData(0));
+        }
+      }
+
+      kernel_.Update(value, grad, states);
+
+      std::copy_n(value, n, chunk.value);
+      std::fill_n(chunk.grad, n, TData(0));
+      for (size_t s = 0; s < TKernel::StateCount; ++s) {
+        std::copy_n(states[s], n, states_[s].data() + chunk.offset);
+      }
+    }
+  }
+
+  TKernel kernel_;
+  TThreadPool* pool_;
+  std::vector<TParameter> parameters_;
+  std::vector<TChunk> chunks_;
+  std::array<std::vector<TData>, TKernel::StateCount> states_;
+  [[no_unique_address]] helpers::TMemoryCharge state_charge_{EMemoryCategory::OptimizerState, 0};
+  std::vector<std::function<void(size_t)>> step_hooks_;
+  size_t size_ = 0;
+  size_t steps_ = 0;
+};
+
+//  The kernel is built from TData and `params`, as MakeOptimizerManager builds the units
+template<template<class> class TKernel, class TData, class... TParams>
+[[nodiscard]] auto MakeFusedOptimizer(TData lr, TParams&&... params) {
+  return TFusedOptimizer<TKernel<TData>>(TKernel<TData>(lr, TData(params)...));
+}
+
+}  // namespace dllib
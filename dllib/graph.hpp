@@ -0,0 +1,160 @@
+#pragma once
+
+#include <dllib/tensor.hpp>
+#include <dllib/autograd.hpp>
+
+#include <memory>
+#include <stdexcept>
+#include <typeindex>
+#include <unordered_set>
+#include <vector>
+
+namespace dllib {
+
+//  Records the graph built by a training step once and replays it on the following steps: values of all
+//  nodes are recomputed in place in a precomputed order and gradients are pushed in the same order
+//  IVariable::Backward would use. Nodes keep their storage between steps, so a replay does no heap
+//  allocation and no graph traversal.
+//
+//  New data has to be fed through leaves created outside of the build function (e.g. by assigning
+//  `input->value`); leaves created inside of it are captured with the values they had during capture.
+class TStaticGraph {
+ public:
+  //  Runs `build` eagerly while recording the graph of the scalar variable it returns and runs Backward
+  template<class TBuild>
+  auto Capture(TBuild&& build) {
+    auto root = Record(std::forward<TBuild>(build));
+    root->Backward();
+    return root;
+  }
+
+  //  Same as Capture, but without the Backward
+  template<class TBuild>
+  auto Record(TBuild&& build) {
+    Reset();
+
+    auto root = [&build] {
+      TCaptureGuard guard;
+      return build();
+    }();
+    using TLoss = typename decltype(root)::TUnderlying;
+    static_assert(TLoss::DimensionCount == 0, "Only scalar graphs can be captured");
+
+    root_ = root;
+    seed_ = [](IArbitraryVariable* v) {
+      static_cast<IVariable<TLoss>*>(v)->grad = 1;
+    };
+    BuildPlan();
+    return root;
+  }
+
+  //  Recomputes every node of the captured graph from the current values of the leaves and runs Backward
+  void Replay() {
+    if (!IsCaptured()) {
+      throw std::runtime_error("Replay of a graph which hasn't been captured");
+    }
+    for (auto* node : forward_order_) {
+      node->Recompute();
+    }
+    seed_(root_.get());
+    for (auto* node : backward_order_) {
+      node->PushGradient();
+    }
+  }
+
+  //  Replays the captured graph if it was captured by the same build function with the same `key`,
+  //  otherwise falls back to running `build` eagerly and captures the new graph. Shapes are part of the
+  //  build function type, data dependent control flow has to be reflected in `key` by the caller
+  template<class TBuild>
+  void Run(TBuild&& build, size_t key = 0) {
+    std::type_index build_type = typeid(std::remove_cvref_t<TBuild>);
+    if (IsCaptured() && build_type_ == build_type && key_ == key) {
+      Replay();
+      return;
+    }
+    Capture(std::forward<TBuild>(build));
+    build_type_ = build_type;
+    key_ = key;
+  }
+
+  [[nodiscard]] bool IsCaptured() const {
+    return root_ != nullptr;
+  }
+
+  //  Nodes of the captured graph in the order of recomputation, leaves excluded
+  [[nodiscard]] const std::vector<IArbitraryVariable*>& GetNodes() const {
+    return forward_order_;
+  }
+
+  //  Nodes in the order of PushGradient calls, starting with the root
+  [[nodiscard]] const std::vector<IArbitraryVariable*>& GetBackwardOrder() const {
+    return backward_order_;
+  }
+
+  void Reset() {
+    root_ = nullptr;
+    forward_order_.clear();
+    backward_order_.clear();
+    build_type_ = typeid(void);
+  }
+
+ private:
+  struct TCaptureGuard {
+    TCaptureGuard() : previous(helpers::graph_capture_enabled) {
+      helpers::graph_capture_enabled = true;
+    }
+
+    ~TCaptureGuard() {
+      helpers::graph_capture_enabled = previous;
+    }
+
+    const bool previous;
+  };
+
+  void BuildPlan() {
+    std::unordered_set<IArbitraryVariable*> visited;
+    auto dfs = [this, &visited](auto& self, IArbitraryVariable* v) -> void {
+      visited.insert(v);
+      auto children = v->GetChildren();
+      for (auto* child : children) {
+        if (child && !visited.contains(child)) {
+          self(self, child);
+        }
+      }
+      if (!children.empty()) {
+        forward_order_.push_back(v);
+      }
+    };
+    dfs(dfs, root_.get());
+
+    //  Same order as in IVariable::Backward
+    std::unordered_set<IArbitraryVariable*> sub_graph;
+    std::vector<IArbitraryVariable*> order;
+    auto backward_dfs = [&sub_graph, &order](auto& self, IArbitraryVariable* v) -> void {
+      sub_graph.insert(v);
+      for (auto* child : v->GetChildren()) {
+        if (child->requires_grad && !sub_graph.contains(child)) {
+          self(self, child);
+        }
+      }
+      order.push_back(v);
+    };
+    for (auto* child : root_->GetChildren()) {
+      if (child->requires_grad && !sub_graph.contains(child)) {
+        backward_dfs(backward_dfs, child);
+      }
+    }
+    backward_order_.push_back(root_.get());
+    backward_order_.insert(backward_order_.end(), order.rbegin(), order.rend());
+  }
+
+  std::shared_ptr<IArbitraryVariable> root_;
+  void (*seed_)(IArbitraryVariable*) = nullptr;
+  std::vector<IArbitraryVariable*> forward_order_;
+  std::vector<IArbitraryVariable*> backward_order_;
+
+  std::type_index build_type_ = typeid(void);
+  size_t key_ = 0;
+};
+
+}  // namespace dllib
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <dllib/tensor.hpp>
+#include <dllib/autograd.hpp>
+#include <dllib/layer.hpp>
+#include <dllib/optimizer.hpp>
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dllib {
+
+namespace helpers {
+
+//  Element-wise relaxed atomic accesses, so concurrent readers and writers of shared parameters don't
+//  race in the sense of the memory model. Elements are updated independently, a reader may observe a
+//  tensor half way through an update, which Hogwild tolerates by design
+template<CTensor T>
+void AtomicLoad(T& shared, T& local) {
+  auto& from = shared.template View<-1u>();
+  auto& to = local.template View<-1u>();
+  for (size_t i = 0; i < T::TotalElements; ++i) {
+    to[i] = std::atomic_ref(from[i].Data()).load(std::memory_order_relaxed);
+  }
+}
+
+template<CTensor T>
+void AtomicAddDifference(T& shared, const T& updated, const T& original) {
+  auto& to = shared.template View<-1u>();
+  const auto& new_values = updated.template View<-1u>();
+  const auto& old_values = original.template View<-1u>();
+  for (size_t i = 0; i < T::TotalElements; ++i) {
+    std::atomic_ref(to[i].Data()).fetch_add(new_values[i] - old_values[i], std::memory_order_relaxed);
+  }
+}
+
+}  // namespace helpers
+
+//  Lock-free asynchronous training of `model` by `threads` threads, Hogwild style. Every thread runs
+//  `steps` iterations of `step(replica, thread, iteration)`, which builds a graph on a thread-local
+//  replica of the model and returns the scalar loss. Gradients are accumulated in the replica only, the
+//  replica's own optimizer of type TOptimizer (constructed with `optimizer_params`, its state is per
+//  thread) updates the replica, and the change of every parameter is then added to the shared model with
+//  relaxed atomics. Before each iteration the replica rereads the shared parameters, so threads see each
+//  other's updates with a delay of at most one step and no locks are taken anywhere.
+//
+//  The gradients of the shared parameters are left untouched. Everything besides the parameters that
+//  `step` captures must be either thread-local or read-only; DropOut is safe since helpers::entropy is
+//  thread-local. If `step`, Backward or the optimizer throws in one of the threads, the other ones stop
+//  before their next iteration and the first exception is rethrown once all of them are joined
+template<template<CTensor T> class TOptimizer, class TModel, class TStep, class... TParams>
+void HogwildTrain(TModel& model, size_t threads, size_t steps, TStep&& step, const TParams&... optimizer_params) {
+  //  Replicas are made before any thread starts writing to the shared parameters
+  std::vector<TModel> replicas;
+  std::vector<TModel> originals;
+  replicas.reserve(threads);
+  originals.reserve(threads);
+  for (size_t thread = 0; thread < threads; ++thread) {
+    replicas.push_back(helpers::MakeReplica(model));
+    originals.push_back(helpers::MakeReplica(model));
+  }
+
+  std::atomic<bool> failed = false;
+  std::mutex error_mutex;
+  std::exception_ptr error;
+
+  auto worker = [&, steps](size_t thread) {
+    try {
+      auto& replica = replicas[thread];
+      auto& original = originals[thread];
+      auto optimizer = MakeOptimizerManager<TOptimizer>(optimizer_params...);
+      optimizer.AddParameter(replica);
+
+      for (size_t iteration = 0; iteration < steps && !failed.load(std::memory_order_relaxed); ++iteration) {
+        ForEachParameter([](auto& shared, auto& local, auto& copy) {
+          helpers::AtomicLoad(shared->value, local->value);
+          copy->value = local->value;
+        }, model, replica, original);
+
+        step(replica, thread, iteration)->Backward();
+        optimizer.Step();
+
+        ForEachParameter([](auto& shared, auto& local, auto& copy) {
+          helpers::AtomicAddDifference(shared->value, local->value, copy->value);
+        }, model, replica, original);
+      }
+    } catch (...) {
+      std::lock_guard guard(error_mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+      failed.store(true, std::memory_order_relaxed);
+    }
+  };
+
+  {
+    std::vector<std::jthread> workers;
+    workers.reserve(threads);
+    for (size_t thread = 0; thread < threads; ++thread) {
+      workers.emplace_back(worker, thread);
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+}  // namespace dllib
@@ -3,7 +3,10 @@
 #include <dllib/tensor.hpp>
 #include <dllib/autograd.hpp>
 
+#include <cmath>
+#include <concepts>
 #include <random>
+#include <utility>
 
 namespace dllib {
 
@@ -50,18 +53,38 @@ TVariable<TTensor<TData, BatchSize, FirstDim, OtherDims...>> AddBias(
     }
   };
 
-  return std::make_shared<TOperationNode<TAddBias, T, TBias>>(TAddBias{}, t, bias);
+  return MakeOperation(TAddBias{}, t, bias);
 }
 
-std::mt19937 entropy(std::random_device{}());
+//  Per thread, so concurrent training threads (see HogwildTrain) don't race on the generator
+inline thread_local std::mt19937 entropy(std::random_device{}());
 
+//  Swaps the state of `entropy` with `state` for its lifetime, so random operations run in between draw
+//  from `state` and leave `entropy` as it was
+struct TEntropySwapGuard {
+  explicit TEntropySwapGuard(std::mt19937& state) : state(state) {
+    std::swap(entropy, state);
+  }
+
+  TEntropySwapGuard(const TEntropySwapGuard&) = delete;
+  TEntropySwapGuard& operator=(const TEntropySwapGuard&) = delete;
+
+  ~TEntropySwapGuard() {
+    std::swap(entropy, state);
+  }
+
+  std::mt19937& state;
+};
+
+//  Storage types like TBFloat16 are sampled as float and rounded
 template<class TData>
 auto GetNormalGenerator() {
+  using TSample = std::conditional_t<std::is_floating_point_v<TData>, TData, float>;
   return [
     &rnd = entropy,
-    distribution = std::normal_distribution<TData>{}]() mutable {
+    distribution = std::normal_distribution<TSample>{}]() mutable {
 
-    return distribution(rnd);
+    return TData(distribution(rnd));
   };
 }
 
@@ -79,8 +102,8 @@ struct Bias {
   Bias() : Bias(helpers::GetNormalGenerator<TData>()) {
   }
 
-  template<class TGen>
-  explicit Bias(TGen& gen) {
+  template<class TGen> requires std::invocable<TGen&>
+  explicit Bias(TGen&& gen) {
     for (auto& x : bias->value) {
       x = gen();
     }
@@ -90,6 +113,9 @@ struct Bias {
     if constexpr (VIsTensor<decltype(value)>) {
       return helpers::AddBias(value, bias->value);
     } else {
+      if (!IsGradEnabled()) {
+        return helpers::MakeNoGradLeaf(helpers::AddBias(value->value, bias->value));
+      }
       return helpers::AddBias(value, bias);
     }
   }
@@ -123,6 +149,9 @@ class FullyConnected {
       auto result = MatrixProduct(value, var->value);
       return bias(result);
     } else {
+      if (!IsGradEnabled()) {
+        return helpers::MakeNoGradLeaf((*this)(value->value));
+      }
       auto result = MatrixProduct(value, var);
       return bias(result);
     }
@@ -141,6 +170,91 @@ class FullyConnected {
   Bias<TData, To> bias;
 };
 
+namespace helpers {
+
+struct TTanhFunction {
+  template<class TData>
+  static TData Apply(TData x) {
+    return std::tanh(x);
+  }
+
+  template<class TData>
+  static TData DerivativeOfResult(TData y) {
+    return 1 - y * y;
+  }
+};
+
+struct TSigmoidFunction {
+  template<class TData>
+  static TData Apply(TData x) {
+    return 1 / (1 + std::exp(-x));
+  }
+
+  template<class TData>
+  static TData DerivativeOfResult(TData y) {
+    return y * (1 - y);
+  }
+};
+
+struct TReLUFunction {
+  template<class TData>
+  static TData Apply(TData x) {
+    return x > 0 ? x : TData(0);
+  }
+
+  template<class TData>
+  static TData DerivativeOfResult(TData y) {
+    return y > 0 ? TData(1) : TData(0);
+  }
+};
+
+}  // namespace helpers
+
+//  Elementwise function as a layer without parameters. The derivative is expressed through the result,
+//  so backward needs nothing but the output
+template<class TFunction>
+struct Activation {
+  template<CTensor T>
+  T operator()(const T& value) {
+    using TData = typename T::TData;
+    return ApplyFunction<T::DimensionCount>([](TData x) {
+      return TFunction::Apply(x);
+    }, value);
+  }
+
+  template<CTensor T>
+  TVariable<T> operator()(const TVariable<T>& value) {
+    struct TActivation {
+      T Forward(const T& value) {
+        return Activation{}(value);
+      }
+
+      void Backward(const IVariable<T>* current, T* parent) {
+        if (parent) {
+          *parent += ApplyFunction<T::DimensionCount>([](typename T::TData grad, typename T::TData y) {
+            return grad * TFunction::DerivativeOfResult(y);
+          }, current->grad, current->value);
+        }
+      }
+    };
+
+    return MakeOperation(TActivation{}, value);
+  }
+
+  auto GetParameters() {
+    return std::tie();
+  }
+
+  auto GetSerializationFields() const {
+    return std::tie();
+  }
+};
+
+using TanhActivation = Activation<helpers::TTanhFunction>;
+using SigmoidActivation = Activation<helpers::TSigmoidFunction>;
+using ReLUActivation = Activation<helpers::TReLUFunction>;
+
+//  Acts as an identity on plain tensors and while gradients are disabled (see TNoGradGuard)
 template<class TDouble = float>
 auto DropOut(const auto& inp, TDouble p = 0.5) {
   using TInput = std::remove_cvref_t<decltype(inp)>;
@@ -148,17 +262,28 @@ auto DropOut(const auto& inp, TDouble p = 0.5) {
   if constexpr (VIsTensor<TInput>) {
     return inp;
   } else {
+    if (!IsGradEnabled()) {
+      return inp;
+    }
+
     using T = typename TInput::TUnderlying;
     constexpr size_t batch_size = T::Dimensions[0];
     constexpr size_t channels = T::Dimensions[1];
 
-    auto& gen = helpers::entropy;
-    TTensor<bool, batch_size, channels> alive;
-    for (auto& x : alive.template View<-1u>()) {
-      x = helpers::TossCoin(gen, 1 - p);
-    }
-
     struct TDropOut {
+      static TTensor<bool, batch_size, channels> SampleMask(TDouble p) {
+        auto& gen = helpers::entropy;
+        TTensor<bool, batch_size, channels> alive;
+        for (auto& x : alive.template View<-1u>()) {
+          x = helpers::TossCoin(gen, 1 - p);
+        }
+        return alive;
+      }
+
+      void Resample() {
+        alive_ = SampleMask(p_);
+      }
+
       auto DropOut(const T& val) {
         auto multiply = []<CTensor T>(const T& tensor, bool value) {
           return tensor * value;
@@ -177,11 +302,11 @@ auto DropOut(const auto& inp, TDouble p = 0.5) {
         }
       }
 
-      const TTensor<bool, batch_size, channels> alive_;
+      TTensor<bool, batch_size, channels> alive_;
       const TDouble p_;
     };
 
-    return TInput(std::make_shared<TOperationNode<TDropOut, T>>(TDropOut{alive, p}, inp));
+    return TInput(MakeOperation(TDropOut{TDropOut::SampleMask(p), p}, inp));
   }
 }
 
@@ -0,0 +1,443 @@
+#pragma once
+
+#include <dllib/tensor.hpp>
+#include <dllib/autograd.hpp>
+
+#include <cmath>
+#include <tuple>
+
+//  Deferred elementwise operations. Lazy(v) starts an expression: arithmetic and activations applied
+//  to it are only recorded in the expression type. When the value is needed (Evaluate, conversion to
+//  TVariable or Sum), the whole chain becomes a single graph node whose forward is one loop over the
+//  elements and whose backward is one loop pushing gradients to all of the variables of the expression.
+//
+//    TVariable<T> h = Tanh(Lazy(a) + b);
+//    Sum(Lazy(diff) * diff)->Backward();
+
+namespace dllib {
+
+namespace helpers {
+
+template<class T>
+concept CLazyExpression = requires {
+  typename std::remove_cvref_t<T>::TLazyTensor;
+};
+
+//  Expressions index the values and gradients of their variables as flat tensors
+template<CTensor T>
+using TFlatTensor = TTensor<typename T::TData, T::TotalElements>;
+
+}  // namespace helpers
+
+template<helpers::CLazyExpression TExpression>
+TVariable<typename TExpression::TLazyTensor> Evaluate(const TExpression& expression);
+
+//  Expressions evaluate a single element `i` given flat views of the values of all of the variables of
+//  the expression, `Offset` is the index of the first variable of the subexpression among them. Eval
+//  keeps the values of the subexpressions in `cache`, and Backward of the same element reads them from
+//  there, so every subexpression is evaluated once per element in the backward loop
+template<CTensor T>
+struct TLazyVariable {
+  using TLazyTensor = T;
+  using TData = typename T::TData;
+  using TFlat = helpers::TFlatTensor<T>;
+  static constexpr size_t VariableCount = 1;
+
+  struct TCache {
+  };
+
+  template<size_t Offset>
+  TData Eval(size_t i, const TFlat* const* values, TCache&) const {
+    return (*values[Offset])[i].Data();
+  }
+
+  template<size_t Offset>
+  void Backward(size_t i, TData grad, const TCache&, TFlat* const* grads) const {
+    if (grads[Offset]) {
+      (*grads[Offset])[i].Data() += grad;
+    }
+  }
+
+  std::tuple<TVariable<T>> GetVariables() const {
+    return {variable};
+  }
+
+  TVariable<T> variable;
+};
+
+template<CTensor T>
+struct TLazyScalar {
+  using TLazyTensor = T;
+  using TData = typename T::TData;
+  using TFlat = helpers::TFlatTensor<T>;
+  static constexpr size_t VariableCount = 0;
+
+  struct TCache {
+  };
+
+  template<size_t>
+  TData Eval(size_t, const TFlat* const*, TCache&) const {
+    return value;
+  }
+
+  template<size_t>
+  void Backward(size_t, TData, const TCache&, TFlat* const*) const {
+  }
+
+  std::tuple<> GetVariables() const {
+    return {};
+  }
+
+  TData value;
+};
+
+template<class TFunction, helpers::CLazyExpression TExpression>
+struct TLazyUnary {
+  using TLazyTensor = typename TExpression::TLazyTensor;
+  using TData = typename TLazyTensor::TData;
+  using TFlat = helpers::TFlatTensor<TLazyTensor>;
+  static constexpr size_t VariableCount = TExpression::VariableCount;
+
+  struct TCache {
+    TData input;
+    TData output;
+    [[no_unique_address]] typename TExpression::TCache expression;
+  };
+
+  template<size_t Offset>
+  TData Eval(size_t i, const TFlat* const* values, TCache& cache) const {
+    cache.input = expression.template Eval<Offset>(i, values, cache.expression);
+    cache.output = TFunction::Forward(cache.input);
+    return cache.output;
+  }
+
+  template<size_t Offset>
+  void Backward(size_t i, TData grad, const TCache& cache, TFlat* const* grads) const {
+    TData derivative = TFunction::Derivative(cache.input, cache.output);
+    expression.template Backward<Offset>(i, grad * derivative, cache.expression, grads);
+  }
+
+  auto GetVariables() const {
+    return expression.GetVariables();
+  }
+
+  // NOLINTNEXTLINE
+  operator TVariable<TLazyTensor>() const {
+    return Evaluate(*this);
+  }
+
+  TExpression expression;
+};
+
+template<class TFunction, helpers::CLazyExpression TLeft, helpers::CLazyExpression TRight>
+struct TLazyBinary {
+  using TLazyTensor = typename TLeft::TLazyTensor;
+  using TData = typename TLazyTensor::TData;
+  using TFlat = helpers::TFlatTensor<TLazyTensor>;
+  static constexpr size_t VariableCount = TLeft::VariableCount + TRight::VariableCount;
+
+  static_assert(std::is_same_v<TLazyTensor, typename TRight::TLazyTensor>);
+
+  struct TCache {
+    TData left_value;
+    TData right_value;
+    [[no_unique_address]] typename TLeft::TCache left;
+    [[no_unique_address]] typename TRight::TCache right;
+  };
+
+  template<size_t Offset>
+  TData Eval(size_t i, const TFlat* const* values, TCache& cache) const {
+    cache.left_value = left.template Eval<Offset>(i, values, cache.left);
+    cache.right_value = right.template Eval<Offset + TLeft::VariableCount>(i, values, cache.right);
+    return TFunction::Forward(cache.left_value, cache.right_value);
+  }
+
+  template<size_t Offset>
+  void Backward(size_t i, TData grad, const TCache& cache, TFlat* const* grads) const {
+    auto [dl, dr] = TFunction::Derivatives(cache.left_value, cache.right_value);
+    left.template Backward<Offset>(i, grad * dl, cache.left, grads);
+    right.template Backward<Offset + TLeft::VariableCount>(i, grad * dr, cache.right, grads);
+  }
+
+  auto GetVariables() const {
+    return std::tuple_cat(left.GetVariables(), right.GetVariables());
+  }
+
+  // NOLINTNEXTLINE
+  operator TVariable<TLazyTensor>() const {
+    return Evaluate(*this);
+  }
+
+  TLeft left;
+  TRight right;
+};
+
+namespace helpers {
+
+//  Derivatives of the unary functions are given both the argument and the result
+struct TLazyNeg {
+  static auto Forward(auto x) {
+    return -x;
+  }
+
+  template<class TData>
+  static TData Derivative(TData, TData) {
+    return -1;
+  }
+};
+
+struct TLazyExp {
+  static auto Forward(auto x) {
+    return std::exp(x);
+  }
+
+  template<class TData>
+  static TData Derivative(TData, TData y) {
+    return y;
+  }
+};
+
+struct TLazyLog {
+  static auto Forward(auto x) {
+    return std::log(x);
+  }
+
+  template<class TData>
+  static TData Derivative(TData x, TData) {
+    return 1 / x;
+  }
+};
+
+struct TLazyTanh {
+  static auto Forward(auto x) {
+    return std::tanh(x);
+  }
+
+  template<class TData>
+  static TData Derivative(TData, TData y) {
+    return 1 - y * y;
+  }
+};
+
+struct TLazySigmoid {
+  template<class TData>
+  static TData Forward(TData x) {
+    return 1 / (1 + std::exp(-x));
+  }
+
+  template<class TData>
+  static TData Derivative(TData, TData y) {
+    return y * (1 - y);
+  }
+};
+
+struct TLazyAdd {
+  static auto Forward(auto l, auto r) {
+    return l + r;
+  }
+
+  template<class TData>
+  static std::pair<TData, TData> Derivatives(TData, TData) {
+    return {1, 1};
+  }
+};
+
+struct TLazySub {
+  static auto Forward(auto l, auto r) {
+    return l - r;
+  }
+
+  template<class TData>
+  static std::pair<TData, TData> Derivatives(TData, TData) {
+    return {1, -1};
+  }
+};
+
+struct TLazyMul {
+  static auto Forward(auto l, auto r) {
+    return l * r;
+  }
+
+  template<class TData>
+  static std::pair<TData, TData> Derivatives(TData l, TData r) {
+    return {r, l};
+  }
+};
+
+struct TLazyDiv {
+  static auto Forward(auto l, auto r) {
+    return l / r;
+  }
+
+  template<class TData>
+  static std::pair<TData, TData> Derivatives(TData l, TData r) {
+    return {1 / r, -l / (r * r)};
+  }
+};
+
+template<CTensor T, class TOperand>
+auto AsLazy(const TOperand& operand) {
+  if constexpr (CLazyExpression<TOperand>) {
+    return operand;
+  } else if constexpr (std::is_arithmetic_v<TOperand>) {
+    return TLazyScalar<T>{typename T::TData(operand)};
+  } else {
+    static_assert(std::is_same_v<TOperand, TVariable<T>>, "Lazy operands must have the same shape");
+    return TLazyVariable<T>{operand};
+  }
+}
+
+template<class TLeft, class TRight>
+concept CLazyOperands = (CLazyExpression<TLeft> || CLazyExpression<TRight>) &&
+  (CLazyExpression<TLeft> || std::is_arithmetic_v<TLeft> || requires { typename TLeft::TUnderlying; }) &&
+  (CLazyExpression<TRight> || std::is_arithmetic_v<TRight> || requires { typename TRight::TUnderlying; });
+
+template<class TFunction, class TLeft, class TRight>
+auto MakeLazyBinary(const TLeft& l, const TRight& r) {
+  using T = typename std::conditional_t<CLazyExpression<TLeft>, TLeft, TRight>::TLazyTensor;
+  using TL = decltype(AsLazy<T>(l));
+  using TR = decltype(AsLazy<T>(r));
+  return TLazyBinary<TFunction, TL, TR>{AsLazy<T>(l), AsLazy<T>(r)};
+}
+
+template<class TExpression, class TIndices = std::make_index_sequence<TExpression::VariableCount>>
+struct TFusedElementwise;
+
+template<class TExpression, size_t... I>
+struct TFusedElementwise<TExpression, std::index_sequence<I...>> {
+  using T = typename TExpression::TLazyTensor;
+  using TData = typename T::TData;
+  using TFlat = TFlatTensor<T>;
+
+  template<size_t>
+  using TSame = T;
+
+  T Forward(const TSame<I>&... values) {
+    const TFlat* flat_values[] = {&values.template View<-1u>()..., nullptr};
+    T result;
+    auto& out = result.template View<-1u>();
+    for (size_t i = 0; i < T::TotalElements; ++i) {
+      typename TExpression::TCache cache;
+      out[i].Data() = expression.template Eval<0>(i, flat_values, cache);
+    }
+    return result;
+  }
+
+  void Backward(const T& grad, TVariable<TSame<I>>&... parents) {
+    const TFlat* flat_values[] = {&parents->value.template View<-1u>()..., nullptr};
+    TFlat* flat_grads[] = {(parents->requires_grad ? &parents->grad.template View<-1u>() : nullptr)..., nullptr};
+    const auto& flat_grad = grad.template View<-1u>();
+    for (size_t i = 0; i < T::TotalElements; ++i) {
+      typename TExpression::TCache cache;
+      expression.template Eval<0>(i, flat_values, cache);
+      expression.template Backward<0>(i, flat_grad[i].Data(), cache, flat_grads);
+    }
+  }
+
+  TExpression expression;
+};
+
+template<class TExpression, class TIndices = std::make_index_sequence<TExpression::VariableCount>>
+struct TFusedSum;
+
+template<class TExpression, size_t... I>
+struct TFusedSum<TExpression, std::index_sequence<I...>> {
+  using T = typename TExpression::TLazyTensor;
+  using TData = typename T::TData;
+  using TFlat = TFlatTensor<T>;
+
+  template<size_t>
+  using TSame = T;
+
+  TTensor<TData> Forward(const TSame<I>&... values) {
+    const TFlat* flat_values[] = {&values.template View<-1u>()..., nullptr};
+    TData sum = 0;
+    for (size_t i = 0; i < T::TotalElements; ++i) {
+      typename TExpression::TCache cache;
+      sum += expression.template Eval<0>(i, flat_values, cache);
+    }
+    return sum;
+  }
+
+  void Backward(const TTensor<TData>& grad, TVariable<TSame<I>>&... parents) {
+    const TFlat* flat_values[] = {&parents->value.template View<-1u>()..., nullptr};
+    TFlat* flat_grads[] = {(parents->requires_grad ? &parents->grad.template View<-1u>() : nullptr)..., nullptr};
+    for (size_t i = 0; i < T::TotalElements; ++i) {
+      typename TExpression::TCache cache;
+      expression.template Eval<0>(i, flat_values, cache);
+      expression.template Backward<0>(i, grad.Data(), cache, flat_grads);
+    }
+  }
+
+  TExpression expression;
+};
+
+}  // namespace helpers
+
+template<CTensor T>
+TLazyVariable<T> Lazy(const TVariable<T>& variable) {
+  return {variable};
+}
+
+//  Materializes the expression as a single node
+template<helpers::CLazyExpression TExpression>
+TVariable<typename TExpression::TLazyTensor> Evaluate(const TExpression& expression) {
+  return std::apply([&expression](const auto&... variables) {
+    return MakeOperation(helpers::TFusedElementwise<TExpression>{expression}, variables...);
+  }, expression.GetVariables());
+}
+
+//  Sum of the expression without materializing the elementwise result
+template<helpers::CLazyExpression TExpression>
+auto Sum(const TExpression& expression) {
+  return std::apply([&expression](const auto&... variables) {
+    return MakeOperation(helpers::TFusedSum<TExpression>{expression}, variables...);
+  }, expression.GetVariables());
+}
+
+template<class TLeft, class TRight> requires helpers::CLazyOperands<TLeft, TRight>
+auto operator+(const TLeft& l, const TRight& r) {
+  return helpers::MakeLazyBinary<helpers::TLazyAdd>(l, r);
+}
+
+template<class TLeft, class TRight> requires helpers::CLazyOperands<TLeft, TRight>
+auto operator-(const TLeft& l, const TRight& r) {
+  return helpers::MakeLazyBinary<helpers::TLazySub>(l, r);
+}
+
+template<class TLeft, class TRight> requires helpers::CLazyOperands<TLeft, TRight>
+auto operator*(const TLeft& l, const TRight& r) {
+  return helpers::MakeLazyBinary<helpers::TLazyMul>(l, r);
+}
+
+template<class TLeft, class TRight> requires helpers::CLazyOperands<TLeft, TRight>
+auto operator/(const TLeft& l, const TRight& r) {
+  return helpers::MakeLazyBinary<helpers::TLazyDiv>(l, r);
+}
+
+template<helpers::CLazyExpression TExpression>
+auto operator-(const TExpression& expression) {
+  return TLazyUnary<helpers::TLazyNeg, TExpression>{expression};
+}
+
+template<helpers::CLazyExpression TExpression>
+auto Exp(const TExpression& expression) {
+  return TLazyUnary<helpers::TLazyExp, TExpression>{expression};
+}
+
+template<helpers::CLazyExpression TExpression>
+auto Log(const TExpression& expression) {
+  return TLazyUnary<helpers::TLazyLog, TExpression>{expression};
+}
+
+template<helpers::CLazyExpression TExpression>
+auto Tanh(const TExpression& expression) {
+  return TLazyUnary<helpers::TLazyTanh, TExpression>{expression};
+}
+
+template<helpers::CLazyExpression TExpression>
+auto Sigmoid(const TExpression& expression) {
+  return TLazyUnary<helpers::TLazySigmoid, TExpression>{expression};
+}
+
+}  // namespace dllib
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <dllib/tensor.hpp>
+#include <dllib/autograd.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace dllib {
+
+//  How the terms of a loss are combined: averaged over the samples (over all elements for the
+//  elementwise losses) or summed
+enum class EReduction {
+  Mean,
+  Sum,
+};
+
+namespace helpers {
+
+//  A loss is a single node. Forward computes the value and, in the same pass, the gradient of the value
+//  w.r.t. the prediction, which is the only thing kept for Backward
+template<class T>
+struct TFusedLoss {
+  using TData = typename T::TData;
+
+  void Backward(TData grad, T* prediction, T* target) {
+    if (prediction) {
+      *prediction += prediction_grad_ * grad;
+    }
+    if (target) {
+      *target -= prediction_grad_ * grad;
+    }
+  }
+
+  T prediction_grad_;
+};
+
+template<class T>
+typename T::TData ReductionScale(EReduction reduction) {
+  return reduction == EReduction::Mean ? typename T::TData(1) / T::TotalElements : typename T::TData(1);
+}
+
+template<class T>
+struct TMeanSquaredError : TFusedLoss<T> {
+  using typename TFusedLoss<T>::TData;
+  using TFusedLoss<T>::prediction_grad_;
+
+  TTensor<TData> Forward(const T& prediction, const T& target) {
+    const auto& p = prediction.template View<-1u>();
+    const auto& t = target.template View<-1u>();
+    auto& g = prediction_grad_.template View<-1u>();
+    TData sum = 0;
+    for (size_t i = 0; i < T::TotalElements; ++i) {
+      TData diff = p[i] - t[i];
+      sum += diff * diff;
+      g[i] = 2 * scale_ * diff;
+    }
+    return sum * scale_;
+  }
+
+  TData scale_;
+};
+
+template<class T>
+struct THuber : TFusedLoss<T> {
+  using typename TFusedLoss<T>::TData;
+  using TFusedLoss<T>::prediction_grad_;
+
+  TTensor<TData> Forward(const T& prediction, const T& target) {
+    const auto& p = prediction.template View<-1u>();
+    const auto& t = target.template View<-1u>();
+    auto& g = prediction_grad_.template View<-1u>();
+    TData sum = 0;
+    for (size_t i = 0; i < T::TotalElements; ++i) {
+      TData diff = p[i] - t[i];
+      TData clipped = std::clamp(diff, -delta_, delta_);
+      //  Quadratic inside [-delta, delta], linear with the same slope outside
+      sum += clipped * (diff - clipped / 2);
+      g[i] = scale_ * clipped;
+    }
+    return sum * scale_;
+  }
+
+  TData scale_;
+  TData delta_;
+};
+
+//  Log-softmax over the classes of every sample followed by the negative log likelihood of the label.
+//  The largest logit is subtracted before exponentiation, so the sum of exponents can't overflow and
+//  the log of it is taken from a sum which is at least 1
+template<class TData, size_t Batch, size_t Classes>
+struct TSoftmaxCrossEntropy {
+  using TLogits = TTensor<TData, Batch, Classes>;
+
+  TTensor<TData> Forward(const TLogits& logits) {
+    TData total = 0;
+    for (size_t b = 0; b < Batch; ++b) {
+      const auto& row = logits[b];
+      auto& probabilities = logits_grad_[b];
+      TData max = *std::max_element(row.begin(), row.end(), [](const auto& l, const auto& r) {
+        return TData(l) < TData(r);
+      });
+      TData exp_sum = 0;
+      for (size_t c = 0; c < Classes; ++c) {
+        exp_sum += probabilities[c] = std::exp(row[c] - max);
+      }
+      size_t label = labels_[b];
+      total += max + std::log(exp_sum) - row[label];
+
+      //  Gradient of the sample term: softmax minus one-hot of the label
+      for (size_t c = 0; c < Classes; ++c) {
+        probabilities[c] = probabilities[c] / exp_sum * scale_;
+      }
+      probabilities[label] -= scale_;
+    }
+    return total * scale_;
+  }
+
+  void Backward(TData grad, TLogits* logits) {
+    if (logits) {
+      *logits += logits_grad_ * grad;
+    }
+  }
+
+  TTensor<size_t, Batch> labels_;
+  TData scale_;
+  TLogits logits_grad_;
+};
+
+}  // namespace helpers
+
+//  Cross-entropy of the softmax of `logits` (a batch of unnormalized class scores) and the class
+//  indices `labels`, stable for logits of any magnitude
+template<class TData, size_t Batch, size_t Classes>
+TVariable<TTensor<TData>> SoftmaxCrossEntropy(
+  const TVariable<TTensor<TData, Batch, Classes>>& logits,
+  const TTensor<size_t, Batch>& labels,
+  EReduction reduction = EReduction::Mean) {
+
+  for (size_t b = 0; b < Batch; ++b) {
+    if (labels[b] >= Classes) {
+      throw std::runtime_error(
+        "Label " + std::to_string(size_t(labels[b])) + " is out of range for " + std::to_string(Classes) + " classes");
+    }
+  }
+  TData scale = reduction == EReduction::Mean ? TData(1) / Batch : TData(1);
+  return MakeOperation(helpers::TSoftmaxCrossEntropy<TData, Batch, Classes>{labels, scale, {}}, logits);
+}
+
+//  Squared difference of `prediction` and `target`, averaged over all elements by default
+template<CTensor T>
+TVariable<TTensor<typename T::TData>> MeanSquaredError(
+  const TVariable<T>& prediction,
+  const TVariable<T>& target,
+  EReduction reduction = EReduction::Mean) {
+
+  return MakeOperation(helpers::TMeanSquaredError<T>{{}, helpers::ReductionScale<T>(reduction)}, prediction, target);
+}
+
+template<CTensor T>
+TVariable<TTensor<typename T::TData>> MeanSquaredError(
+  const TVariable<T>& prediction,
+  const T& target,
+  EReduction reduction = EReduction::Mean) {
+
+  return MeanSquaredError(prediction, TVariable<T>(target, false), reduction);
+}
+
+//  Half squared difference where it's at most `delta` in absolute value and linear beyond, so that
+//  outliers pull with a bounded gradient. `delta` has to be positive
+template<CTensor T>
+TVariable<TTensor<typename T::TData>> Huber(
+  const TVariable<T>& prediction,
+  const TVariable<T>& target,
+  typename T::TData delta = 1,
+  EReduction reduction = EReduction::Mean) {
+
+  if (!(delta > 0)) {
+    throw std::runtime_error("Delta of the Huber loss has to be positive");
+  }
+  return MakeOperation(helpers::THuber<T>{{}, helpers::ReductionScale<T>(reduction), delta}, prediction, target);
+}
+
+template<CTensor T>
+TVariable<TTensor<typename T::TData>> Huber(
+  const TVariable<T>& prediction,
+  const T& target,
+  typename T::TData delta = 1,
+  EReduction reduction = EReduction::Mean) {
+
+  return Huber(prediction, TVariable<T>(target, false), delta, reduction);
+}
+
+}  // namespace dllib
@@ -0,0 +1,260 @@
+#pragma once
+
+#include <dllib/tensor.hpp>
+#include <dllib/autograd.hpp>
+#include <dllib/layer.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace dllib {
+
+namespace helpers {
+
+//  Row-major matrix of doubles, the factorization works in double whatever the layer type is
+struct TDenseMatrix {
+  TDenseMatrix(size_t rows, size_t columns) : rows(rows), columns(columns), values(rows * columns, 0.) {
+  }
+
+  double& operator()(size_t i, size_t j) {
+    return values[i * columns + j];
+  }
+
+  double operator()(size_t i, size_t j) const {
+    return values[i * columns + j];
+  }
+
+  size_t rows;
+  size_t columns;
+  std::vector<double> values;
+};
+
+//  transpose_left ? left^T * right : left * right
+inline TDenseMatrix Multiply(const TDenseMatrix& left, const TDenseMatrix& right, bool transpose_left = false) {
+  size_t rows = transpose_left ? left.columns : left.rows;
+  size_t inner = transpose_left ? left.rows : left.columns;
+  TDenseMatrix result(rows, right.columns);
+  for (size_t i = 0; i < rows; ++i) {
+    for (size_t k = 0; k < inner; ++k) {
+      double a = transpose_left ? left(k, i) : left(i, k);
+      for (size_t j = 0; j < right.columns; ++j) {
+        result(i, j) += a * right(k, j);
+      }
+    }
+  }
+  return result;
+}
+
+//  Modified Gram-Schmidt on the columns, run twice to stay orthogonal in floating point. Columns which turn
+//  out to be dependent on the previous ones are set to zero
+inline void OrthonormalizeColumns(TDenseMatrix& m) {
+  for (size_t pass = 0; pass < 2; ++pass) {
+    for (size_t j = 0; j < m.columns; ++j) {
+      for (size_t prev = 0; prev < j; ++prev) {
+        double dot = 0;
+        for (size_t i = 0; i < m.rows; ++i) {
+          dot += m(i, j) * m(i, prev);
+        }
+        for (size_t i = 0; i < m.rows; ++i) {
+          m(i, j) -= dot * m(i, prev);
+        }
+      }
+      double norm = 0;
+      for (size_t i = 0; i < m.rows; ++i) {
+        norm += m(i, j) * m(i, j);
+      }
+      norm = std::sqrt(norm);
+      for (size_t i = 0; i < m.rows; ++i) {
+        m(i, j) = norm > 1e-150 ? m(i, j) / norm : 0.;
+      }
+    }
+  }
+}
+
+//  Cyclic Jacobi rotations for a small symmetric matrix: eigenvalues in decreasing order and the matching
+//  eigenvectors as columns
+inline std::pair<std::vector<double>, TDenseMatrix> SymmetricEigen(TDenseMatrix a) {
+  size_t n = a.rows;
+  TDenseMatrix vectors(n, n);
+  for (size_t i = 0; i < n; ++i) {
+    vectors(i, i) = 1;
+  }
+  for (size_t sweep = 0; sweep < 100; ++sweep) {
+    double off_diagonal = 0, diagonal = 0;
+    for (size_t i = 0; i < n; ++i) {
+      diagonal += a(i, i) * a(i, i);
+      for (size_t j = i + 1; j < n; ++j) {
+        off_diagonal += a(i, j) * a(i, j);
+      }
+    }
+    if (off_diagonal <= 1e-30 * diagonal) {
+      break;
+    }
+    for (size_t p = 0; p < n; ++p) {
+      for (size_t q = p + 1; q < n; ++q) {
+        if (a(p, q) == 0) {
+          continue;
+        }
+        double theta = (a(q, q) - a(p, p)) / (2 * a(p, q));
+        double t = (theta >= 0 ? 1. : -1.) / (std::abs(theta) + std::sqrt(theta * theta + 1));
+        double c = 1 / std::sqrt(t * t + 1), s = t * c;
+        for (size_t k = 0; k < n; ++k) {
+          double kp = a(k, p), kq = a(k, q);
+          a(k, p) = c * kp - s * kq;
+          a(k, q) = s * kp + c * kq;
+        }
+        for (size_t k = 0; k < n; ++k) {
+          double pk = a(p, k), qk = a(q, k);
+          a(p, k) = c * pk - s * qk;
+          a(q, k) = s * pk + c * qk;
+        }
+        for (size_t k = 0; k < n; ++k) {
+          double kp = vectors(k, p), kq = vectors(k, q);
+          vectors(k, p) = c * kp - s * kq;
+          vectors(k, q) = s * kp + c * kq;
+        }
+      }
+    }
+  }
+
+  std::vector<size_t> order(n);
+  std::iota(order.begin(), order.end(), size_t(0));
+  std::sort(order.begin(), order.end(), [&a](size_t l, size_t r) {
+    return a(l, l) > a(r, r);
+  });
+  std::vector<double> values(n);
+  TDenseMatrix sorted(n, n);
+  for (size_t j = 0; j < n; ++j) {
+    values[j] = a(order[j], order[j]);
+    for (size_t i = 0; i < n; ++i) {
+      sorted(i, j) = vectors(i, order[j]);
+    }
+  }
+  return {std::move(values), std::move(sorted)};
+}
+
+//  Best rank `rank` approximation left * right of `w` by randomized subspace iteration with a few extra
+//  directions, followed by an exact SVD of the small projected matrix. The singular values are split evenly
+//  between the factors: left = U * sqrt(S), right = sqrt(S) * V^T
+inline std::pair<TDenseMatrix, TDenseMatrix> TruncatedSvd(const TDenseMatrix& w, size_t rank, size_t iterations) {
+  size_t width = std::min(rank + 8, std::min(w.rows, w.columns));
+  std::mt19937 gen(0);
+  std::normal_distribution<double> dist;
+  TDenseMatrix basis(w.rows, width);
+  TDenseMatrix test(w.columns, width);
+  for (auto& x : test.values) {
+    x = dist(gen);
+  }
+  for (size_t i = 0; i <= iterations; ++i) {
+    basis = Multiply(w, test);
+    OrthonormalizeColumns(basis);
+    if (i < iterations) {
+      test = Multiply(w, basis, true);
+      OrthonormalizeColumns(test);
+    }
+  }
+
+  //  w ~ basis * projected, and projected * projected^T = P * S^2 * P^T
+  TDenseMatrix projected = Multiply(basis, w, true);
+  TDenseMatrix gram(width, width);
+  for (size_t i = 0; i < width; ++i) {
+    for (size_t j = 0; j < width; ++j) {
+      for (size_t k = 0; k < w.columns; ++k) {
+        gram(i, j) += projected(i, k) * projected(j, k);
+      }
+    }
+  }
+  auto [squares, rotation] = SymmetricEigen(std::move(gram));
+  TDenseMatrix rotated_basis = Multiply(basis, rotation);
+  TDenseMatrix rotated_projected = Multiply(rotation, projected, true);
+
+  TDenseMatrix left(w.rows, rank), right(rank, w.columns);
+  for (size_t r = 0; r < std::min(rank, width); ++r) {
+    double singular = std::sqrt(std::max(squares[r], 0.));
+    if (singular <= 1e-150) {
+      continue;
+    }
+    double root = std::sqrt(singular);
+    for (size_t i = 0; i < w.rows; ++i) {
+      left(i, r) = rotated_basis(i, r) * root;
+    }
+    for (size_t j = 0; j < w.columns; ++j) {
+      right(r, j) = rotated_projected(r, j) / root;
+    }
+  }
+  return {std::move(left), std::move(right)};
+}
+
+}  // namespace helpers
+
+//  FullyConnected with the From x To weights stored as a From x Rank and a Rank x To factor. The input is
+//  multiplied by them one after another, so a batch costs Batch * Rank * (From + To) multiplications
+//  instead of Batch * From * To, and the full matrix is never formed
+template<class TData, size_t From, size_t Rank, size_t To>
+class LowRankFullyConnected {
+  static_assert(Rank > 0 && Rank <= std::min(From, To), "Rank should be in [1, min(From, To)]");
+
+ public:
+  LowRankFullyConnected() : LowRankFullyConnected(helpers::GetNormalGenerator<TData>()) {}
+
+  template<class TGen>
+  explicit LowRankFullyConnected(TGen gen) : bias(gen) {
+    for (auto& x : left->value.template View<-1u>()) {
+      x = gen();
+    }
+    for (auto& x : right->value.template View<-1u>()) {
+      x = gen();
+    }
+  }
+
+  //  The best rank Rank approximation of a trained layer by truncated SVD, the bias is copied. More
+  //  iterations help when the leading singular values are close to each other
+  explicit LowRankFullyConnected(FullyConnected<TData, From, To>& dense, size_t iterations = 8) {
+    auto [weights, dense_bias] = dense.GetParameters();
+    helpers::TDenseMatrix w(From, To);
+    for (size_t i = 0; i < From; ++i) {
+      for (size_t j = 0; j < To; ++j) {
+        w(i, j) = double(TData(weights->value[i][j]));
+      }
+    }
+    auto [left_factor, right_factor] = helpers::TruncatedSvd(w, Rank, iterations);
+    for (size_t i = 0; i < From; ++i) {
+      for (size_t r = 0; r < Rank; ++r) {
+        left->value[i][r] = TData(left_factor(i, r));
+      }
+    }
+    for (size_t r = 0; r < Rank; ++r) {
+      for (size_t j = 0; j < To; ++j) {
+        right->value[r][j] = TData(right_factor(r, j));
+      }
+    }
+    std::get<0>(bias.GetParameters())->value = std::get<0>(dense_bias.GetParameters())->value;
+  }
+
+  auto operator()(const auto& value) {
+    if constexpr (VIsTensor<decltype(value)>) {
+      return bias(MatrixProduct(MatrixProduct(value, left->value), right->value));
+    } else {
+      return bias(MatrixProduct(MatrixProduct(value, left), right));
+    }
+  }
+
+  auto GetParameters() {
+    return std::tie(left, right, bias);
+  }
+
+  auto GetSerializationFields() const {
+    return std::tie(left, right, bias);
+  }
+
+ private:
+  TVariable<TTensor<TData, From, Rank>> left{true};
+  TVariable<TTensor<TData, Rank, To>> right{true};
+  Bias<TData, To> bias;
+};
+
+}  // namespace dllib
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+namespace dllib {
+
+enum class EMemoryCategory {
+  Parameters,
+  Activations,
+  Gradients,
+  OptimizerState,
+};
+
+inline constexpr size_t VMemoryCategoryCount = 4;
+
+namespace helpers {
+
+class TLeafValueCharge;
+
+}  // namespace helpers
+
+//  Live and peak bytes held by the graph and the optimizers, by category, when the library is compiled
+//  with DLLIB_MEMORY_TRACKING defined. Values of leaves requiring gradients are parameters, values of
+//  other leaves and of operation nodes (with the state of the operation, e.g. dropout masks) are
+//  activations, every variable owns a gradient. The arena of a planned graph (see TPlannedGraph) holds
+//  the values and gradients of its nodes and counts as activations as a whole. Temporaries outside of
+//  the graph are not tracked. A leaf whose requires_grad changes moves to its new category by the next
+//  query.
+//  Without DLLIB_MEMORY_TRACKING nothing is recorded and all queries return zeros
+class TMemoryTracker {
+ public:
+  static TMemoryTracker& Get() {
+    static TMemoryTracker tracker;
+    return tracker;
+  }
+
+  void Allocate(EMemoryCategory category, size_t bytes) {
+    Add(category, bytes);
+  }
+
+  void Release(EMemoryCategory category, size_t bytes) {
+    Subtract(category, bytes);
+  }
+
+  [[nodiscard]] size_t GetLiveBytes(EMemoryCategory category) const {
+    SettleLeaves();
+    return counters_[size_t(category)].live.load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] size_t GetPeakBytes(EMemoryCategory category) const {
+    SettleLeaves();
+    return counters_[size_t(category)].peak.load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] size_t GetLiveBytes() const {
+    return total_.live.load(std::memory_order_relaxed);
+  }
+
+  //  Peak of the sum over all categories, which may be less than the sum of the peaks
+  [[nodiscard]] size_t GetPeakBytes() const {
+    return total_.peak.load(std::memory_order_relaxed);
+  }
+
+  //  Drops the peaks to the current live bytes
+  void ResetPeak() {
+    SettleLeaves();
+    for (auto& counter : counters_) {
+      counter.peak.store(counter.live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    total_.peak.store(total_.live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  }
+
+  //  Runs `function` and returns how many bytes above the live level before the call it held at most,
+  //  e.g. to find the largest batch size of a training step fitting into a memory budget
+  template<class TFunction>
+  size_t MeasurePeak(TFunction&& function) {
+    size_t before = GetLiveBytes();
+    ResetPeak();
+    function();
+    return GetPeakBytes() - before;
+  }
+
+ private:
+  friend class helpers::TLeafValueCharge;
+
+  struct TCounter {
+    std::atomic<size_t> live = 0;
+    std::atomic<size_t> peak = 0;
+  };
+
+  static void UpdatePeak(std::atomic<size_t>& peak, size_t value) {
+    size_t current = peak.load(std::memory_order_relaxed);
+    while (current < value && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  void Add(EMemoryCategory category, size_t bytes) const {
+    auto& counter = counters_[size_t(category)];
+    UpdatePeak(counter.peak, counter.live.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+    UpdatePeak(total_.peak, total_.live.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+  }
+
+  void Subtract(EMemoryCategory category, size_t bytes) const {
+    counters_[size_t(category)].live.fetch_sub(bytes, std::memory_order_relaxed);
+    total_.live.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  //  Moves the values of the leaves whose requires_grad has changed to their current category
+  void SettleLeaves() const;
+
+  //  Mutable as the queries settle the categories of the leaves first
+  mutable std::array<TCounter, VMemoryCategoryCount> counters_;
+  mutable TCounter total_;
+
+  //  Live leaf charges, linked through the charges themselves
+  mutable std::mutex leaves_mutex_;
+  helpers::TLeafValueCharge* leaves_ = nullptr;
+};
+
+namespace helpers {
+
+#ifdef DLLIB_MEMORY_TRACKING
+
+//  Accounts `bytes` of the given category for as long as the owning object lives
+class TMemoryCharge {
+ public:
+  TMemoryCharge(EMemoryCategory category, size_t bytes) : category_(category), bytes_(bytes) {
+    TMemoryTracker::Get().Allocate(category_, bytes_);
+  }
+
+  TMemoryCharge(const TMemoryCharge& other) : TMemoryCharge(other.category_, other.bytes_) {
+  }
+
+  TMemoryCharge& operator=(const TMemoryCharge& other) {
+    TMemoryTracker::Get().Release(category_, bytes_);
+    category_ = other.category_;
+    bytes_ = other.bytes_;
+    TMemoryTracker::Get().Allocate(category_, bytes_);
+    return *this;
+  }
+
+  ~TMemoryCharge() {
+    TMemoryTracker::Get().Release(category_, bytes_);
+  }
+
+  //  Accounts only the difference, so growing a charge doesn't count the old bytes twice
+  void Resize(size_t bytes) {
+    if (bytes > bytes_) {
+      TMemoryTracker::Get().Allocate(category_, bytes - bytes_);
+    } else {
+      TMemoryTracker::Get().Release(category_, bytes_ - bytes);
+    }
+    bytes_ = bytes;
+  }
+
+ private:
+  EMemoryCategory category_;
+  size_t bytes_;
+};
+
+//  Charge of the value of a leaf: parameters while `requires_grad` is set, activations otherwise. The
+//  flag may change after construction, so the tracker keeps the charge to re-check it on queries
+class TLeafValueCharge {
+ public:
+  TLeafValueCharge(const bool& requires_grad, size_t bytes)
+    : requires_grad_(&requires_grad), bytes_(bytes), category_(GetCategory()) {
+
+    auto& tracker = TMemoryTracker::Get();
+    std::lock_guard lock(tracker.leaves_mutex_);
+    tracker.Add(category_, bytes_);
+    next_ = tracker.leaves_;
+    if (next_) {
+      next_->previous_ = this;
+    }
+    tracker.leaves_ = this;
+  }
+
+  TLeafValueCharge(const TLeafValueCharge&) = delete;
+  TLeafValueCharge& operator=(const TLeafValueCharge&) = delete;
+
+  ~TLeafValueCharge() {
+    auto& tracker = TMemoryTracker::Get();
+    std::lock_guard lock(tracker.leaves_mutex_);
+    tracker.Subtract(category_, bytes_);
+    (previous_ ? previous_->next_ : tracker.leaves_) = next_;
+    if (next_) {
+      next_->previous_ = previous_;
+    }
+  }
+
+ private:
+  friend class dllib::TMemoryTracker;
+
+  [[nodiscard]] EMemoryCategory GetCategory() const {
+    return *requires_grad_ ? EMemoryCategory::Parameters : EMemoryCategory::Activations;
+  }
+
+  const bool* requires_grad_;
+  size_t bytes_;
+  EMemoryCategory category_;
+  TLeafValueCharge* previous_ = nullptr;
+  TLeafValueCharge* next_ = nullptr;
+};
+
+#else
+
+class TMemoryCharge {
+ public:
+  constexpr TMemoryCharge(EMemoryCategory, size_t) {
+  }
+
+  constexpr void Resize(size_t) {
+  }
+};
+
+class TLeafValueCharge {
+ public:
+  constexpr TLeafValueCharge(const bool&, size_t) {
+  }
+};
+
+#endif
+
+}  // namespace helpers
+
+inline void TMemoryTracker::SettleLeaves() const {
+#ifdef DLLIB_MEMORY_TRACKING
+  std::lock_guard lock(leaves_mutex_);
+  for (auto* leaf = leaves_; leaf; leaf = leaf->next_) {
+    auto category = leaf->GetCategory();
+    if (category != leaf->category_) {
+      Subtract(leaf->category_, leaf->bytes_);
+      Add(category, leaf->bytes_);
+      leaf->category_ = category;
+    }
+  }
+#endif
+}
+
+}  // namespace dllib
@@ -0,0 +1,421 @@
+#pragma once
+
+#include <dllib/autograd.hpp>
+#include <dllib/graph.hpp>
+#include <dllib/layer.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace dllib {
+
+//  Assignment of values and gradients of the intermediate nodes of a captured graph to offsets in a
+//  single arena. Buffers whose lifetimes don't overlap share memory, so `planned_bytes` is close to
+//  the true working set `peak_live_bytes`, while `naive_bytes` is what separate allocations take
+struct TMemoryPlan {
+  static constexpr size_t Alignment = 64;
+
+  struct TBuffer {
+    IArbitraryVariable* node;
+    bool is_gradient;
+    size_t bytes;
+    //  Inclusive range of steps, forward steps go first and backward steps follow them
+    size_t first_use;
+    size_t last_use;
+    size_t offset = 0;
+  };
+
+  std::vector<TBuffer> buffers;
+  size_t step_count = 0;
+  size_t naive_bytes = 0;
+  size_t planned_bytes = 0;
+  size_t peak_live_bytes = 0;
+};
+
+namespace helpers {
+
+inline size_t AlignUp(size_t bytes, size_t alignment) {
+  return (bytes + alignment - 1) / alignment * alignment;
+}
+
+//  Greedy best-fit by size: the largest buffers are placed first at the lowest offset which doesn't
+//  collide with any already placed buffer alive at the same time
+inline void AssignOffsets(TMemoryPlan& plan) {
+  std::vector<TMemoryPlan::TBuffer*> by_size;
+  for (auto& buffer : plan.buffers) {
+    by_size.push_back(&buffer);
+  }
+  std::stable_sort(by_size.begin(), by_size.end(), [](auto* lhs, auto* rhs) {
+    return lhs->bytes > rhs->bytes;
+  });
+
+  std::vector<TMemoryPlan::TBuffer*> placed;
+  std::vector<TMemoryPlan::TBuffer*> conflicts;
+  for (auto* buffer : by_size) {
+    conflicts.clear();
+    for (auto* other : placed) {
+      if (other->first_use <= buffer->last_use && buffer->first_use <= other->last_use) {
+        conflicts.push_back(other);
+      }
+    }
+    std::sort(conflicts.begin(), conflicts.end(), [](auto* lhs, auto* rhs) {
+      return lhs->offset < rhs->offset;
+    });
+
+    size_t offset = 0;
+    for (auto* other : conflicts) {
+      if (offset + buffer->bytes <= other->offset) {
+        break;
+      }
+      offset = std::max(offset, AlignUp(other->offset + other->bytes, TMemoryPlan::Alignment));
+    }
+    buffer->offset = offset;
+    plan.planned_bytes = std::max(plan.planned_bytes, offset + buffer->bytes);
+    placed.push_back(buffer);
+  }
+}
+
+}  // namespace helpers
+
+//  Analyses liveness of the nodes of `forward`, recomputed in this order and followed by PushGradient
+//  calls in the order of `backward`, which starts with the root. A value is alive from the step
+//  computing it to the last step of its consumers (forward or backward) or its own backward step,
+//  whichever is later; the value of the root stays alive to the end. A gradient is alive from the
+//  first backward step of a consumer writing to it to its own backward step. Leaves own their storage
+//  across steps and are not planned
+inline TMemoryPlan PlanMemory(
+  const std::vector<IArbitraryVariable*>& forward,
+  const std::vector<IArbitraryVariable*>& backward) {
+
+  TMemoryPlan plan;
+  plan.step_count = forward.size() + backward.size();
+
+  std::unordered_map<IArbitraryVariable*, size_t> forward_step;
+  std::unordered_map<IArbitraryVariable*, size_t> backward_step;
+  for (size_t i = 0; i < forward.size(); ++i) {
+    forward_step[forward[i]] = i;
+  }
+  for (size_t i = 0; i < backward.size(); ++i) {
+    backward_step[backward[i]] = forward.size() + i;
+  }
+
+  std::unordered_map<IArbitraryVariable*, size_t> value_last_use;
+  std::unordered_map<IArbitraryVariable*, size_t> grad_first_use;
+  for (auto* node : forward) {
+    value_last_use[node] = forward_step[node];
+  }
+  for (auto* node : forward) {
+    auto backward_it = backward_step.find(node);
+    if (backward_it != backward_step.end()) {
+      value_last_use[node] = std::max(value_last_use[node], backward_it->second);
+    }
+    for (auto* child : node->GetChildren()) {
+      auto it = value_last_use.find(child);
+      if (it == value_last_use.end()) {
+        continue;
+      }
+      it->second = std::max(it->second, forward_step[node]);
+      if (backward_it != backward_step.end()) {
+        it->second = std::max(it->second, backward_it->second);
+        if (child->requires_grad) {
+          auto [grad_it, inserted] = grad_first_use.try_emplace(child, backward_it->second);
+          grad_it->second = std::min(grad_it->second, backward_it->second);
+        }
+      }
+    }
+  }
+  auto* root = backward.front();
+  value_last_use[root] = plan.step_count - 1;
+  grad_first_use[root] = backward_step[root];
+
+  for (auto* node : forward) {
+    plan.buffers.push_back({node, false, node->ValueBytes(), forward_step[node], value_last_use[node]});
+    auto it = grad_first_use.find(node);
+    if (it != grad_first_use.end()) {
+      plan.buffers.push_back({node, true, node->ValueBytes(), it->second, backward_step[node]});
+    }
+    plan.naive_bytes += 2 * node->ValueBytes();
+  }
+
+  std::vector<size_t> live_bytes(plan.step_count);
+  for (const auto& buffer : plan.buffers) {
+    for (size_t step = buffer.first_use; step <= buffer.last_use; ++step) {
+      live_bytes[step] += buffer.bytes;
+    }
+  }
+  plan.peak_live_bytes = *std::max_element(live_bytes.begin(), live_bytes.end());
+
+  helpers::AssignOffsets(plan);
+  return plan;
+}
+
+//  Plan over one Replay of a captured graph
+inline TMemoryPlan PlanMemory(const TStaticGraph& graph) {
+  if (!graph.IsCaptured()) {
+    throw std::runtime_error("Memory can only be planned for a captured graph");
+  }
+  return PlanMemory(graph.GetNodes(), graph.GetBackwardOrder());
+}
+
+//  Captured graph whose intermediate values and gradients live in a single arena laid out by
+//  PlanMemory, so between steps it holds `planned_bytes` of the plan instead of two tensors per node.
+//  Capture runs `build` twice: the graph of the first run is planned and released, the second run makes
+//  the nodes again with their storage bound to the arena. The first run draws from a copy of
+//  helpers::entropy and runs with helpers::checkpoint_recompute_enabled, so only the second one advances
+//  the generator and updates the running statistics of BatchNorm. Nodes made outside of `build` and
+//  nodes the root doesn't depend on keep their own storage.
+//
+//  Slots are reused within a step, so after Replay only the leaves and the value of the root are
+//  meaningful. `build` has to make the same graph on both runs, and the returned root must not outlive
+//  the graph or its next Capture. Like TStaticGraph::Replay, Replay does no heap allocation
+class TPlannedGraph : private helpers::INodeStorage {
+ public:
+  TPlannedGraph() = default;
+
+  TPlannedGraph(const TPlannedGraph&) = delete;
+  TPlannedGraph& operator=(const TPlannedGraph&) = delete;
+
+  ~TPlannedGraph() = default;
+
+  //  Runs `build` eagerly with the nodes in the arena, recording the graph of the scalar variable it
+  //  returns, and runs Backward
+  template<class TBuild>
+  auto Capture(TBuild&& build) {
+    Reset();
+    {
+      auto entropy = helpers::entropy;
+      helpers::TEntropySwapGuard entropy_guard(entropy);
+      helpers::TCheckpointRecomputeGuard recompute_guard;
+      helpers::TNodeStorageScope scope(this);
+      graph_.Record(build);
+    }
+    auto plan = PlanMemory(GetPlannedNodes(), graph_.GetBackwardOrder());
+    AssignSlots(plan);
+    graph_.Reset();
+    made_.clear();
+
+    auto root = [this, &build] {
+      helpers::TNodeStorageScope scope(this);
+      return graph_.Record(build);
+    }();
+    using TLoss = typename decltype(root)::TUnderlying;
+    seed_ = [](IArbitraryVariable* v) {
+      static_cast<IVariable<TLoss>*>(v)->grad = 1;
+    };
+
+    auto planned = GetPlannedNodes();
+    plan_ = PlanMemory(planned, graph_.GetBackwardOrder());
+    if (plan_.buffers.size() != plan.buffers.size() || next_slot_ != slots_.size()) {
+      throw std::runtime_error("The build function of a planned graph made a different graph on the second run");
+    }
+    for (size_t i = 0; i < plan.buffers.size(); ++i) {
+      if (plan_.buffers[i].offset != plan.buffers[i].offset || plan_.buffers[i].bytes != plan.buffers[i].bytes) {
+        throw std::runtime_error("The build function of a planned graph made a different graph on the second run");
+      }
+    }
+    BuildSteps(planned);
+    Backward();
+    return root;
+  }
+
+  //  Recomputes every node of the captured graph from the current values of the leaves and runs Backward
+  void Replay() {
+    if (!IsCaptured()) {
+      throw std::runtime_error("Replay of a planned graph which hasn't been captured");
+    }
+    for (auto* node : forward_order_) {
+      node->Recompute();
+    }
+    Backward();
+  }
+
+  [[nodiscard]] bool IsCaptured() const {
+    return graph_.IsCaptured();
+  }
+
+  [[nodiscard]] const TMemoryPlan& GetPlan() const {
+    return plan_;
+  }
+
+  //  Bytes of the arena, the planned bytes and the slot for gradients nobody writes
+  [[nodiscard]] size_t GetArenaBytes() const {
+    return arena_.size() * sizeof(TArenaBlock);
+  }
+
+  void Reset() {
+    graph_.Reset();
+    made_.clear();
+    slots_.clear();
+    next_slot_ = 0;
+    arena_ = {};
+    arena_charge_ = helpers::TMemoryCharge(EMemoryCategory::Activations, 0);
+    plan_ = {};
+    forward_order_.clear();
+    zero_before_.clear();
+  }
+
+ private:
+  static constexpr size_t NoSlot = -1;
+
+  struct alignas(TMemoryPlan::Alignment) TArenaBlock {
+    std::byte bytes[TMemoryPlan::Alignment];
+  };
+
+  struct TSlot {
+    size_t bytes;
+    size_t value = NoSlot;
+    size_t grad = NoSlot;
+  };
+
+  struct TRange {
+    size_t offset;
+    size_t bytes;
+  };
+
+  TSlots Next(size_t bytes) override {
+    size_t index = next_slot_++;
+    if (arena_.empty()) {
+      slots_.push_back({bytes});
+      return {nullptr, nullptr};
+    }
+    if (index >= slots_.size() || slots_[index].bytes != bytes) {
+      throw std::runtime_error("The build function of a planned graph made a different graph on the second run");
+    }
+    if (slots_[index].value == NoSlot) {
+      return {nullptr, nullptr};
+    }
+    return {GetArena() + slots_[index].value, GetArena() + slots_[index].grad};
+  }
+
+  void Made(IArbitraryVariable* node) override {
+    made_.push_back(node);
+  }
+
+  std::byte* GetArena() {
+    return arena_.front().bytes;
+  }
+
+  //  Index of every node made by `build` in `made_`. A node freed during `build` may leave its address
+  //  to a later one, so the last index of an address is the one of the live node
+  [[nodiscard]] std::unordered_map<IArbitraryVariable*, size_t> GetMadeIndices() const {
+    std::unordered_map<IArbitraryVariable*, size_t> indices;
+    for (size_t i = 0; i < made_.size(); ++i) {
+      indices[made_[i]] = i;
+    }
+    return indices;
+  }
+
+  //  Nodes of the graph made by `build`, in the order they were made, which is the order the eager run
+  //  computed them in
+  [[nodiscard]] std::vector<IArbitraryVariable*> GetPlannedNodes() const {
+    auto indices = GetMadeIndices();
+    std::vector<bool> in_graph(made_.size());
+    for (auto* node : graph_.GetNodes()) {
+      if (auto it = indices.find(node); it != indices.end()) {
+        in_graph[it->second] = true;
+      }
+    }
+    std::vector<IArbitraryVariable*> planned;
+    for (size_t i = 0; i < made_.size(); ++i) {
+      if (in_graph[i]) {
+        planned.push_back(made_[i]);
+      }
+    }
+    return planned;
+  }
+
+  //  Values and gradients of the nodes of the first run by the index they were made with. Nodes without
+  //  a gradient buffer share a scratch slot after the planned bytes
+  void AssignSlots(const TMemoryPlan& plan) {
+    auto indices = GetMadeIndices();
+    for (const auto& buffer : plan.buffers) {
+      auto& slot = slots_[indices.at(buffer.node)];
+      (buffer.is_gradient ? slot.grad : slot.value) = buffer.offset;
+    }
+
+    size_t scratch = helpers::AlignUp(plan.planned_bytes, TMemoryPlan::Alignment);
+    size_t scratch_bytes = 0;
+    for (auto& slot : slots_) {
+      if (slot.value != NoSlot && slot.grad == NoSlot) {
+        slot.grad = scratch;
+        scratch_bytes = std::max(scratch_bytes, slot.bytes);
+      }
+    }
+
+    size_t bytes = std::max<size_t>(scratch + scratch_bytes, 1);
+    arena_.resize((bytes + sizeof(TArenaBlock) - 1) / sizeof(TArenaBlock));
+    arena_charge_ = helpers::TMemoryCharge(EMemoryCategory::Activations, GetArenaBytes());
+    next_slot_ = 0;
+  }
+
+  //  Nodes made outside of `build` are recomputed first, their values don't depend on the planned ones
+  void BuildSteps(const std::vector<IArbitraryVariable*>& planned) {
+    std::unordered_set<IArbitraryVariable*> planned_set(planned.begin(), planned.end());
+    for (auto* node : graph_.GetNodes()) {
+      if (!planned_set.contains(node)) {
+        forward_order_.push_back(node);
+      }
+    }
+    forward_order_.insert(forward_order_.end(), planned.begin(), planned.end());
+
+    const auto& backward = graph_.GetBackwardOrder();
+    zero_before_.assign(backward.size(), {});
+    for (const auto& buffer : plan_.buffers) {
+      if (buffer.is_gradient && buffer.node != backward.front()) {
+        zero_before_[buffer.first_use - planned.size()].push_back({buffer.offset, buffer.bytes});
+      }
+    }
+  }
+
+  //  Gradient slots may hold anything before the first consumer writes to them, so they are zeroed
+  //  right before that
+  void Backward() {
+    const auto& backward = graph_.GetBackwardOrder();
+    seed_(backward.front());
+    for (size_t i = 0; i < backward.size(); ++i) {
+      for (const auto& range : zero_before_[i]) {
+        std::memset(GetArena() + range.offset, 0, range.bytes);
+      }
+      backward[i]->PushGradient();
+    }
+  }
+
+  //  Declared before the graph, so the nodes bound to the arena are released first
+  std::vector<TArenaBlock> arena_;
+  [[no_unique_address]] helpers::TMemoryCharge arena_charge_{EMemoryCategory::Activations, 0};
+  TStaticGraph graph_;
+  TMemoryPlan plan_;
+
+  //  Nodes made by `build` in the current run and the slots recorded by the first run to hand out to
+  //  the second one
+  std::vector<IArbitraryVariable*> made_;
+  std::vector<TSlot> slots_;
+  size_t next_slot_ = 0;
+
+  void (*seed_)(IArbitraryVariable*) = nullptr;
+  std::vector<IArbitraryVariable*> forward_order_;
+  //  Gradient slots to zero before every backward step
+  std::vector<std::vector<TRange>> zero_before_;
+};
+
+inline std::ostream& operator<<(std::ostream& out, const TMemoryPlan& plan) {
+  size_t values = 0;
+  size_t grads = 0;
+  for (const auto& buffer : plan.buffers) {
+    ++(buffer.is_gradient ? grads : values);
+  }
+  out << "Memory plan: " << values << " values, " << grads << " gradients over " << plan.step_count
+      << " steps\n";
+  out << "  naive:   " << plan.naive_bytes << " bytes\n";
+  out << "  planned: " << plan.planned_bytes << " bytes\n";
+  out << "  peak:    " << plan.peak_live_bytes << " bytes live at once\n";
+  return out;
+}
+
+}  // namespace dllib
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <dllib/tensor.hpp>
+#include <dllib/autograd.hpp>
+#include <dllib/bfloat16.hpp>
+#include <dllib/optimizer.hpp>
+#include <dllib/serialization.hpp>
+
+namespace dllib {
+
+//  Optimizer units for a model with low precision parameters (e.g. TBFloat16): the unit keeps a float
+//  copy of the parameter, the master weights, and makes the steps of `TOptimizer` on it. After every step
+//  the parameter is set to the master weights rounded, so updates smaller than the precision of the
+//  parameter accumulate instead of being lost. Used in place of an ordinary unit, e.g.
+//  MakeOptimizerManager<TMixedPrecision<TAdamOptimizerUnit>::TUnit>(lr)
+template<template<CTensor T> class TOptimizer>
+struct TMixedPrecision {
+  template<CTensor T>
+  class TUnit final : public IArbitraryOptimizerUnit {
+   private:
+    using TMaster = TMakeTensor<float, T::Dimensions>;
+
+   public:
+    template<class... TArgs>
+    explicit TUnit(TVariable<T>& var, TArgs&&... args)
+      : variable_(var),
+        master_(var->value.template To<float>(), true),
+        optimizer_(master_, std::forward<TArgs>(args)...) {
+    }
+
+    void ZeroGrad() final {
+      variable_->ZeroGrad();
+    }
+
+    void Dump(std::ostream& out) const final {
+      dllib::Dump(out, master_->value);
+      optimizer_.Dump(out);
+    }
+
+    void Load(std::istream& in) final {
+      dllib::Load(in, master_->value);
+      optimizer_.Load(in);
+      variable_->value = master_->value.template To<typename T::TData>();
+    }
+
+    [[nodiscard]] bool HasFiniteGradient() const final {
+      for (auto& x : variable_->grad.template View<T::TotalElements>()) {
+        if (!helpers::IsFinite(x.Data())) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    //  Applied in float on the way to the master gradient, dividing by a large loss scale in the
+    //  precision of the parameter would flush small gradients to zero
+    void ScaleGradient(float factor) final {
+      scale_ *= factor;
+    }
+
+    [[nodiscard]] const TVariable<TMaster>& GetMasterWeights() const {
+      return master_;
+    }
+
+   protected:
+    void StepImpl() final {
+      auto& master_grad = master_->grad.template View<T::TotalElements>();
+      const auto& grad = variable_->grad.template View<T::TotalElements>();
+      for (size_t i = 0; i < T::TotalElements; ++i) {
+        master_grad[i] = float(grad[i].Data()) * scale_;
+      }
+      scale_ = 1;
+
+      optimizer_.Step();
+      variable_->value = master_->value.template To<typename T::TData>();
+    }
+
+   private:
+    TVariable<T>& variable_;
+    TVariable<TMaster> master_;
+    TOptimizer<TMaster> optimizer_;
+    float scale_ = 1;
+  };
+};
+
+//  Dynamic loss scaling for training in low precision. Backward multiplies the gradient of the loss by
+//  Scale() so that small gradients aren't flushed to zero, and Step divides the gradients by it again
+//  before the optimizer step. A step with an Inf or NaN in some gradient is skipped (gradients are just
+//  zeroed) and the scale is multiplied by `backoff_factor`; every `growth_interval` successful steps in a
+//  row it's multiplied by `growth_factor`. Powers of two keep the scaling itself exact
+class TDynamicLossScaler {
+ public:
+  explicit TDynamicLossScaler(
+    float initial_scale = 1 << 16,
+    size_t growth_interval = 2000,
+    float growth_factor = 2,
+    float backoff_factor = 0.5)
+    : scale_(initial_scale),
+      growth_interval_(growth_interval),
+      growth_factor_(growth_factor),
+      backoff_factor_(backoff_factor) {
+  }
+
+  template<CTensor T>
+  void Backward(const TVariable<T>& loss) const {
+    static_assert(T::DimensionCount == 0, "Backward without an explicit gradient requires a scalar");
+    loss->Backward(T(scale_));
+  }
+
+  //  Makes the step of `optimizer` (a TOptimizerManager) unless some gradient overflowed, returns whether
+  //  it was made
+  template<class TOptimizer>
+  bool Step(TOptimizer& optimizer) {
+    if (!optimizer.HasFiniteGradients()) {
+      optimizer.ZeroGrad();
+      scale_ *= backoff_factor_;
+      good_steps_ = 0;
+      ++skipped_steps_;
+      return false;
+    }
+
+    optimizer.ScaleGradients(1 / scale_);
+    optimizer.Step();
+    if (++good_steps_ == growth_interval_) {
+      scale_ *= growth_factor_;
+      good_steps_ = 0;
+    }
+    return true;
+  }
+
+  [[nodiscard]] float Scale() const {
+    return scale_;
+  }
+
+  [[nodiscard]] size_t SkippedSteps() const {
+    return skipped_steps_;
+  }
+
+  void Dump(std::ostream& out) const {
+    dllib::Dump(out, scale_);
+    dllib::Dump(out, good_steps_);
+  }
+
+  void Load(std::istream& in) {
+    dllib::Load(in, scale_);
+    dllib::Load(in, good_steps_);
+  }
+
+ private:
+  float scale_;
+  const size_t growth_interval_;
+  const float growth_factor_;
+  const float backoff_factor_;
+  size_t good_steps_ = 0;
+  size_t skipped_steps_ = 0;
+};
+
+}  // namespace dllib
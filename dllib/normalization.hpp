@@ -0,0 +1,337 @@
+#pragma once
+
+#include <dllib/tensor.hpp>
+#include <dllib/autograd.hpp>
+
+#include <cmath>
+
+namespace dllib {
+
+namespace helpers {
+
+//  Running mean and sum of squared deviations in one pass (Welford), without the cancellation of
+//  E[x^2] - E[x]^2
+template<class TData>
+struct TWelford {
+  void Add(TData x) {
+    ++count;
+    TData delta = x - mean;
+    mean += delta / TData(count);
+    squares += delta * (x - mean);
+  }
+
+  TData Variance() const {
+    return squares / TData(count);
+  }
+
+  TData UnbiasedVariance() const {
+    return squares / TData(count > 1 ? count - 1 : 1);
+  }
+
+  size_t count = 0;
+  TData mean = 0;
+  TData squares = 0;
+};
+
+//  Gradient of the input of a normalization from the gradient of its normalized values `normalized_grad`:
+//  inv_std * (dy - mean(dy) - x_hat * mean(dy * x_hat)) along the normalized axis
+template<class TData>
+TData NormalizationGrad(TData normalized_grad, TData normalized, TData inv_std, TData grad_mean, TData product_mean) {
+  return inv_std * (normalized_grad - grad_mean - normalized * product_mean);
+}
+
+//  Normalizes every sample over its features, then scales and shifts each feature. Forward keeps the
+//  normalized values and the inverse standard deviations, backward is one pass per sample
+template<class TData, size_t Batch, size_t Features>
+struct TLayerNorm {
+  using T = TTensor<TData, Batch, Features>;
+  using TAffine = TTensor<TData, Features>;
+
+  T Forward(const T& x, const TAffine& scale, const TAffine& shift) {
+    T result;
+    for (size_t b = 0; b < Batch; ++b) {
+      TWelford<TData> moments;
+      for (size_t j = 0; j < Features; ++j) {
+        moments.Add(x[b][j]);
+      }
+      TData inv_std = inv_std_[b] = 1 / std::sqrt(moments.Variance() + epsilon_);
+      for (size_t j = 0; j < Features; ++j) {
+        TData normalized = normalized_[b][j] = (x[b][j] - moments.mean) * inv_std;
+        result[b][j] = normalized * scale[j] + shift[j];
+      }
+    }
+    return result;
+  }
+
+  void Backward(const T& grad, TVariable<T>& x, TVariable<TAffine>& scale, TVariable<TAffine>& shift) {
+    AccumulateGradients(
+      grad,
+      scale->value,
+      GetGradientPointerIfRequired(x),
+      GetGradientPointerIfRequired(scale),
+      GetGradientPointerIfRequired(shift));
+  }
+
+  //  Adds the gradients to the non-null ones of `x_grad`, `scale_grad` and `shift_grad`
+  void AccumulateGradients(const T& grad, const TAffine& scale, T* x_grad, TAffine* scale_grad, TAffine* shift_grad) {
+    for (size_t b = 0; b < Batch; ++b) {
+      TData grad_sum = 0, product_sum = 0;
+      for (size_t j = 0; j < Features; ++j) {
+        TData normalized_grad = grad[b][j] * scale[j];
+        grad_sum += normalized_grad;
+        product_sum += normalized_grad * normalized_[b][j];
+        if (scale_grad) {
+          (*scale_grad)[j] += grad[b][j] * normalized_[b][j];
+        }
+        if (shift_grad) {
+          (*shift_grad)[j] += grad[b][j];
+        }
+      }
+      if (x_grad) {
+        for (size_t j = 0; j < Features; ++j) {
+          (*x_grad)[b][j] += NormalizationGrad<TData>(
+            grad[b][j] * scale[j], normalized_[b][j], inv_std_[b], grad_sum / Features, product_sum / Features);
+        }
+      }
+    }
+  }
+
+  TData epsilon_;
+  T normalized_;
+  TTensor<TData, Batch> inv_std_;
+};
+
+//  Normalizes every feature over the batch, then scales and shifts it. The batch statistics are also
+//  folded into the running ones, which are held by the layer and shared with the node, except when
+//  Checkpoint recomputes the node
+template<class TData, size_t Batch, size_t Features>
+struct TBatchNorm {
+  using T = TTensor<TData, Batch, Features>;
+  using TAffine = TTensor<TData, Features>;
+
+  T Forward(const T& x, const TAffine& scale, const TAffine& shift) {
+    TWelford<TData> moments[Features];
+    for (size_t b = 0; b < Batch; ++b) {
+      for (size_t j = 0; j < Features; ++j) {
+        moments[j].Add(x[b][j]);
+      }
+    }
+    for (size_t j = 0; j < Features; ++j) {
+      inv_std_[j] = 1 / std::sqrt(moments[j].Variance() + epsilon_);
+      if (checkpoint_recompute_enabled) {
+        continue;
+      }
+      auto& mean = running_mean_->value[j];
+      auto& variance = running_variance_->value[j];
+      mean = (1 - momentum_) * mean + momentum_ * moments[j].mean;
+      variance = (1 - momentum_) * variance + momentum_ * moments[j].UnbiasedVariance();
+    }
+
+    T result;
+    for (size_t b = 0; b < Batch; ++b) {
+      for (size_t j = 0; j < Features; ++j) {
+        TData normalized = normalized_[b][j] = (x[b][j] - moments[j].mean) * inv_std_[j];
+        result[b][j] = normalized * scale[j] + shift[j];
+      }
+    }
+    return result;
+  }
+
+  void Backward(const T& grad, TVariable<T>& x, TVariable<TAffine>& scale, TVariable<TAffine>& shift) {
+    AccumulateGradients(
+      grad,
+      scale->value,
+      GetGradientPointerIfRequired(x),
+      GetGradientPointerIfRequired(scale),
+      GetGradientPointerIfRequired(shift));
+  }
+
+  //  Adds the gradients to the non-null ones of `x_grad`, `scale_grad` and `shift_grad`
+  void AccumulateGradients(const T& grad, const TAffine& scale, T* x_grad, TAffine* scale_grad, TAffine* shift_grad) {
+    TAffine grad_sum(0), product_sum(0);
+    for (size_t b = 0; b < Batch; ++b) {
+      for (size_t j = 0; j < Features; ++j) {
+        grad_sum[j] += grad[b][j];
+        product_sum[j] += grad[b][j] * normalized_[b][j];
+      }
+    }
+    if (scale_grad) {
+      *scale_grad += product_sum;
+    }
+    if (shift_grad) {
+      *shift_grad += grad_sum;
+    }
+    if (x_grad) {
+      for (size_t b = 0; b < Batch; ++b) {
+        for (size_t j = 0; j < Features; ++j) {
+          TData s = scale[j];
+          (*x_grad)[b][j] += NormalizationGrad<TData>(
+            grad[b][j] * s, normalized_[b][j], inv_std_[j], grad_sum[j] * s / Batch, product_sum[j] * s / Batch);
+        }
+      }
+    }
+  }
+
+  TVariable<TAffine> running_mean_;
+  TVariable<TAffine> running_variance_;
+  TData momentum_;
+  TData epsilon_;
+  T normalized_;
+  TAffine inv_std_;
+};
+
+//  LayerNorm without anything kept for backward
+template<class TData, size_t Batch, size_t Features>
+TTensor<TData, Batch, Features> LayerNormalize(
+  const TTensor<TData, Batch, Features>& x,
+  const TTensor<TData, Features>& scale,
+  const TTensor<TData, Features>& shift,
+  TData epsilon) {
+
+  TTensor<TData, Batch, Features> result;
+  for (size_t b = 0; b < Batch; ++b) {
+    TWelford<TData> moments;
+    for (size_t j = 0; j < Features; ++j) {
+      moments.Add(x[b][j]);
+    }
+    TData inv_std = 1 / std::sqrt(moments.Variance() + epsilon);
+    for (size_t j = 0; j < Features; ++j) {
+      result[b][j] = (x[b][j] - moments.mean) * inv_std * scale[j] + shift[j];
+    }
+  }
+  return result;
+}
+
+//  Normalization of every feature with fixed statistics, as BatchNorm does at inference
+template<class TData, size_t Batch, size_t Features>
+TTensor<TData, Batch, Features> NormalizeWithStatistics(
+  const TTensor<TData, Batch, Features>& x,
+  const TTensor<TData, Features>& scale,
+  const TTensor<TData, Features>& shift,
+  const TTensor<TData, Features>& mean,
+  const TTensor<TData, Features>& variance,
+  TData epsilon) {
+
+  TTensor<TData, Features> multiplier, offset;
+  for (size_t j = 0; j < Features; ++j) {
+    multiplier[j] = scale[j] / std::sqrt(variance[j] + epsilon);
+    offset[j] = shift[j] - mean[j] * multiplier[j];
+  }
+  TTensor<TData, Batch, Features> result;
+  for (size_t b = 0; b < Batch; ++b) {
+    for (size_t j = 0; j < Features; ++j) {
+      result[b][j] = x[b][j] * multiplier[j] + offset[j];
+    }
+  }
+  return result;
+}
+
+}  // namespace helpers
+
+//  Layer normalization over the features of every sample, with a learned per-feature scale and shift
+template<class TData, size_t Features>
+class LayerNorm {
+ public:
+  explicit LayerNorm(TData epsilon = 1e-5) : epsilon_(epsilon) {
+    scale->value = TTensor<TData, Features>(1);
+    shift->value = TTensor<TData, Features>(0);
+  }
+
+  template<size_t Batch>
+  TTensor<TData, Batch, Features> operator()(const TTensor<TData, Batch, Features>& x) {
+    return GetOperation<Batch>().Forward(x, scale->value, shift->value);
+  }
+
+  template<size_t Batch>
+  TVariable<TTensor<TData, Batch, Features>> operator()(const TVariable<TTensor<TData, Batch, Features>>& x) {
+    return MakeOperation(GetOperation<Batch>(), x, scale, shift);
+  }
+
+  //  The node the layer records for a batch, applied to the parameters (see Sequential)
+  template<size_t Batch>
+  helpers::TLayerNorm<TData, Batch, Features> GetOperation() const {
+    return {epsilon_, {}, {}};
+  }
+
+  TData GetEpsilon() const {
+    return epsilon_;
+  }
+
+  auto GetParameters() {
+    return std::tie(scale, shift);
+  }
+
+  auto GetSerializationFields() const {
+    return std::tie(scale, shift);
+  }
+
+ private:
+  TData epsilon_;
+  TVariable<TTensor<TData, Features>> scale{true};
+  TVariable<TTensor<TData, Features>> shift{true};
+};
+
+//  Batch normalization of every feature, with a learned per-feature scale and shift. Variables are
+//  normalized with the statistics of the batch, which also update the running mean and (unbiased)
+//  variance by `momentum`. Plain tensors, and variables while gradients are disabled (see TNoGradGuard),
+//  are normalized with the running statistics
+template<class TData, size_t Features>
+class BatchNorm {
+ public:
+  explicit BatchNorm(TData momentum = 0.1, TData epsilon = 1e-5) : momentum_(momentum), epsilon_(epsilon) {
+    scale->value = TTensor<TData, Features>(1);
+    shift->value = TTensor<TData, Features>(0);
+    running_mean->value = TTensor<TData, Features>(0);
+    running_variance->value = TTensor<TData, Features>(1);
+  }
+
+  template<size_t Batch>
+  TTensor<TData, Batch, Features> operator()(const TTensor<TData, Batch, Features>& x) {
+    return helpers::NormalizeWithStatistics(
+      x, scale->value, shift->value, running_mean->value, running_variance->value, epsilon_);
+  }
+
+  template<size_t Batch>
+  TVariable<TTensor<TData, Batch, Features>> operator()(const TVariable<TTensor<TData, Batch, Features>>& x) {
+    if (!IsGradEnabled()) {
+      return TVariable<TTensor<TData, Batch, Features>>((*this)(x->value), false);
+    }
+    return MakeOperation(GetOperation<Batch>(), x, scale, shift);
+  }
+
+  //  The node the layer records for a batch, applied to the parameters (see Sequential)
+  template<size_t Batch>
+  helpers::TBatchNorm<TData, Batch, Features> GetOperation() const {
+    return {running_mean, running_variance, momentum_, epsilon_, {}, {}};
+  }
+
+  TData GetEpsilon() const {
+    return epsilon_;
+  }
+
+  const TTensor<TData, Features>& GetRunningMean() const {
+    return running_mean->value;
+  }
+
+  const TTensor<TData, Features>& GetRunningVariance() const {
+    return running_variance->value;
+  }
+
+  auto GetParameters() {
+    return std::tie(scale, shift);
+  }
+
+  auto GetSerializationFields() const {
+    return std::tie(scale, shift, running_mean, running_variance);
+  }
+
+ private:
+  TData momentum_;
+  TData epsilon_;
+  TVariable<TTensor<TData, Features>> scale{true};
+  TVariable<TTensor<TData, Features>> shift{true};
+  TVariable<TTensor<TData, Features>> running_mean{false};
+  TVariable<TTensor<TData, Features>> running_variance{false};
+};
+
+}  // namespace dllib
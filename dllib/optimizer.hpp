@@ -4,8 +4,32 @@
 #include <dllib/autograd.hpp>
 #include <dllib/serialization.hpp>
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
 namespace dllib {
 
+namespace helpers {
+
+//  Checks the exponent bits, the build uses -ffast-math which lets std::isfinite assume the answer
+template<class TData>
+bool IsFinite(TData x) {
+  if constexpr (std::is_same_v<TData, double>) {
+    constexpr uint64_t exponent = 0x7ff0000000000000;
+    return (std::bit_cast<uint64_t>(x) & exponent) != exponent;
+  } else {
+    constexpr uint32_t exponent = 0x7f800000;
+    return (std::bit_cast<uint32_t>(float(x)) & exponent) != exponent;
+  }
+}
+
+}  // namespace helpers
+
 class IArbitraryOptimizerUnit {
  public:
   virtual void ZeroGrad() = 0;
@@ -19,6 +43,12 @@ class IArbitraryOptimizerUnit {
 
   virtual void Load(std::istream&) = 0;
 
+  //  For loss scaling (see TDynamicLossScaler): whether the gradient has no Inf or NaN, and multiplying
+  //  the gradient by `factor` before the next step
+  [[nodiscard]] virtual bool HasFiniteGradient() const = 0;
+
+  virtual void ScaleGradient(float factor) = 0;
+
   virtual ~IArbitraryOptimizerUnit() {}
 
  protected:
@@ -34,6 +64,21 @@ class IOptimizerUnit : public IArbitraryOptimizerUnit {
     variable->ZeroGrad();
   }
 
+  [[nodiscard]] bool HasFiniteGradient() const final {
+    for (auto& x : variable->grad.template View<T::TotalElements>()) {
+      if (!helpers::IsFinite(x.Data())) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void ScaleGradient(float factor) final {
+    for (auto& x : variable->grad.template View<T::TotalElements>()) {
+      x.Data() *= factor;
+    }
+  }
+
  protected:
   TVariable<T>& variable;
 };
@@ -93,6 +138,7 @@ class TMomentumOptimizerUnit final : public IOptimizerUnit<T> {
   const TData lr_;
   const TData alpha_;
   T momentum_;
+  [[no_unique_address]] helpers::TMemoryCharge state_charge_{EMemoryCategory::OptimizerState, sizeof(T)};
 };
 
 template<CTensor T>
@@ -161,6 +207,229 @@ class TAdamOptimizerUnit final : public IOptimizerUnit<T> {
 
   const TData eps_;
   T m_, v_;
+  [[no_unique_address]] helpers::TMemoryCharge state_charge_{EMemoryCategory::OptimizerState, 2 * sizeof(T)};
+};
+
+namespace helpers {
+
+//  Optimizer state of Size elements in 8 bits each. Blocks of BlockSize elements share a scale, the largest
+//  magnitude in the block, and an element keeps the code round(127 * (|x| / scale)^(1/4)) with its sign, or
+//  round(255 * ...) if the state is never negative. The fourth root spreads the codes over eight orders of
+//  magnitude, where linear codes would round everything but the largest values of a block to zero
+template<size_t Size, bool Signed>
+class TQuantizedState {
+ public:
+  static constexpr size_t BlockSize = 64;
+  static constexpr size_t BlockCount = (Size + BlockSize - 1) / BlockSize;
+
+  TQuantizedState() {
+    codes_.fill(0);
+    scales_.fill(0);
+  }
+
+  //  Elements past Size are zero
+  template<class TData>
+  void LoadBlock(size_t block, TData (&values)[BlockSize]) const {
+    const auto* codes = codes_.data() + block * BlockSize;
+    TData scale = scales_[block];
+    for (size_t i = 0; i < BlockSize; ++i) {
+      TData root = TData(codes[i]) / Levels;
+      TData square = root * root;
+      values[i] = scale * square * square * TData(Signed && root < 0 ? -1 : 1);
+    }
+  }
+
+  //  Elements past Size should be zero. A positive value of an unsigned state never gets code 0, so Adam
+  //  doesn't divide by its epsilon alone where the second moment is small but not zero
+  template<class TData>
+  void StoreBlock(size_t block, const TData (&values)[BlockSize]) {
+    TData scale = 0;
+    for (size_t i = 0; i < BlockSize; ++i) {
+      scale = std::max(scale, std::abs(values[i]));
+    }
+    //  A double block max may underflow float, the block is then stored as zeros
+    scales_[block] = float(scale);
+    TData inv_scale = scales_[block] > 0 ? 1 / TData(scales_[block]) : 0;
+    auto* codes = codes_.data() + block * BlockSize;
+    for (size_t i = 0; i < BlockSize; ++i) {
+      TData magnitude = std::min(TData(1), std::abs(values[i]) * inv_scale);
+      int code = int(std::sqrt(std::sqrt(magnitude)) * Levels + TData(0.5));
+      if constexpr (Signed) {
+        codes[i] = TCode(values[i] < 0 ? -code : code);
+      } else {
+        codes[i] = TCode(std::max(code, values[i] > 0 ? 1 : 0));
+      }
+    }
+  }
+
+  void Dump(std::ostream& out) const {
+    for (auto scale : scales_) {
+      dllib::Dump(out, scale);
+    }
+    for (auto code : codes_) {
+      dllib::Dump(out, code);
+    }
+  }
+
+  void Load(std::istream& in) {
+    for (auto& scale : scales_) {
+      dllib::Load(in, scale);
+    }
+    for (auto& code : codes_) {
+      dllib::Load(in, code);
+    }
+  }
+
+ private:
+  using TCode = std::conditional_t<Signed, int8_t, uint8_t>;
+  static constexpr int Levels = Signed ? 127 : 255;
+
+  std::array<TCode, BlockCount * BlockSize> codes_;
+  std::array<float, BlockCount> scales_;
+};
+
+//  Calls `update(block, value, grad)` for blocks of BlockSize elements of the variable, copied to local
+//  arrays with zeros past the end, and writes the values back
+template<size_t BlockSize, CTensor T, class TFunction>
+void ForEachParameterBlock(TVariable<T>& variable, TFunction&& update) {
+  using TData = typename T::TData;
+  auto& values = variable->value.template View<T::TotalElements>();
+  auto& grads = variable->grad.template View<T::TotalElements>();
+  for (size_t block = 0; block * BlockSize < T::TotalElements; ++block) {
+    size_t begin = block * BlockSize;
+    size_t n = std::min(BlockSize, T::TotalElements - begin);
+    TData value[BlockSize] = {}, grad[BlockSize] = {};
+    for (size_t i = 0; i < n; ++i) {
+      value[i] = values[begin + i].Data();
+      grad[i] = grads[begin + i].Data();
+    }
+    update(block, value, grad);
+    for (size_t i = 0; i < n; ++i) {
+      values[begin + i].Data() = value[i];
+    }
+  }
+}
+
+}  // namespace helpers
+
+//  TMomentumOptimizerUnit keeping the momentum in 8 bits per element (see helpers::TQuantizedState), it's
+//  decoded and encoded again block by block inside the step
+template<CTensor T>
+class TQuantizedMomentumOptimizerUnit final : public IOptimizerUnit<T> {
+ private:
+  using TData = typename T::TData;
+  using TState = helpers::TQuantizedState<T::TotalElements, true>;
+  static constexpr size_t BlockSize = TState::BlockSize;
+
+ public:
+  TQuantizedMomentumOptimizerUnit(TVariable<T>& var, TData lr, TData alpha)
+    : IOptimizerUnit<T>(var),
+      lr_(lr),
+      alpha_(alpha) {
+  }
+
+  void Dump(std::ostream& out) const final {
+    dllib::Dump(out, momentum_);
+  }
+
+  void Load(std::istream& in) final {
+    dllib::Load(in, momentum_);
+  }
+
+ protected:
+  void StepImpl() final {
+    helpers::ForEachParameterBlock<BlockSize>(variable, [this](size_t block, auto& value, const auto& grad) {
+      TData momentum[BlockSize];
+      momentum_.LoadBlock(block, momentum);
+      for (size_t i = 0; i < BlockSize; ++i) {
+        momentum[i] = momentum[i] * alpha_ + grad[i];
+        value[i] -= momentum[i] * lr_;
+      }
+      momentum_.StoreBlock(block, momentum);
+    });
+  }
+
+  using IOptimizerUnit<T>::variable;
+
+  const TData lr_;
+  const TData alpha_;
+  TState momentum_;
+  [[no_unique_address]] helpers::TMemoryCharge state_charge_{EMemoryCategory::OptimizerState, sizeof(TState)};
+};
+
+//  TAdamOptimizerUnit keeping both moments in 8 bits per element (see helpers::TQuantizedState), they are
+//  decoded and encoded again block by block inside the step
+template<CTensor T>
+class TQuantizedAdamOptimizerUnit final : public IOptimizerUnit<T> {
+ private:
+  using TData = typename T::TData;
+  using TFirstMoment = helpers::TQuantizedState<T::TotalElements, true>;
+  using TSecondMoment = helpers::TQuantizedState<T::TotalElements, false>;
+  static constexpr size_t BlockSize = TFirstMoment::BlockSize;
+
+ public:
+  TQuantizedAdamOptimizerUnit(
+    TVariable<T>& var,
+    TData lr,
+    TData beta1 = 0.9,
+    TData beta2 = 0.999,
+    TData eps = 1e-8)
+    : IOptimizerUnit<T>(var),
+      lr_(lr),
+      beta1_(beta1),
+      beta2_(beta2),
+      eps_(eps) {
+  }
+
+  void Dump(std::ostream& out) const final {
+    dllib::Dump(out, beta1_power_);
+    dllib::Dump(out, beta2_power_);
+    dllib::Dump(out, m_);
+    dllib::Dump(out, v_);
+  }
+
+  void Load(std::istream& in) final {
+    dllib::Load(in, beta1_power_);
+    dllib::Load(in, beta2_power_);
+    dllib::Load(in, m_);
+    dllib::Load(in, v_);
+  }
+
+ protected:
+  void StepImpl() final {
+    beta1_power_ *= beta1_;
+    beta2_power_ *= beta2_;
+    TData m_scale = 1 / (1 - beta1_power_), v_scale = 1 / (1 - beta2_power_);
+
+    helpers::ForEachParameterBlock<BlockSize>(variable, [&](size_t block, auto& value, const auto& grad) {
+      TData m[BlockSize], v[BlockSize];
+      m_.LoadBlock(block, m);
+      v_.LoadBlock(block, v);
+      for (size_t i = 0; i < BlockSize; ++i) {
+        m[i] = m[i] * beta1_ + grad[i] * (1 - beta1_);
+        v[i] = v[i] * beta2_ + grad[i] * grad[i] * (1 - beta2_);
+        value[i] -= m[i] * m_scale / (std::sqrt(v[i] * v_scale) + eps_) * lr_;
+      }
+      m_.StoreBlock(block, m);
+      v_.StoreBlock(block, v);
+    });
+  }
+
+  using IOptimizerUnit<T>::variable;
+
+  const TData lr_;
+
+  const TData beta1_;
+  TData beta1_power_ = 1;
+
+  const TData beta2_;
+  TData beta2_power_ = 1;
+
+  const TData eps_;
+  TFirstMoment m_;
+  TSecondMoment v_;
+  [[no_unique_address]] helpers::TMemoryCharge state_charge_{
+    EMemoryCategory::OptimizerState, sizeof(TFirstMoment) + sizeof(TSecondMoment)};
 };
 
 namespace helpers {
@@ -172,6 +441,40 @@ concept HasParameters = requires(T val) {
 
 }  // namespace helpers
 
+//  Calls `function` on every parameter of `models`, recursing into GetParameters(). With several models
+//  of the same type, `function` gets the corresponding parameters of all of them at once
+template<class TFunction, class... TModels>
+void ForEachParameter(TFunction&& function, TModels&... models) {
+  if constexpr ((helpers::HasParameters<TModels> && ...)) {
+    auto parameters = std::make_tuple(models.GetParameters()...);
+    using TFirst = std::remove_cvref_t<decltype(get<0>(parameters))>;
+    auto visit = [&function, &parameters]<size_t i>(std::integral_constant<size_t, i>) {
+      std::apply([&function](auto&... params) {
+        ForEachParameter(function, get<i>(params)...);
+      }, parameters);
+    };
+    [&visit]<size_t... i>(std::index_sequence<i...>) {
+      (visit(std::integral_constant<size_t, i>{}), ...);
+    }(std::make_index_sequence<std::tuple_size_v<TFirst>>());
+  } else {
+    function(models...);
+  }
+}
+
+namespace helpers {
+
+//  Copy of a model with its own parameter leaves
+template<class TModel>
+TModel MakeReplica(TModel& model) {
+  TModel replica = model;
+  ForEachParameter([](auto& var) {
+    var = var.Copy();
+  }, replica);
+  return replica;
+}
+
+}  // namespace helpers
+
 template<template<CTensor T> class TOptimizer, class... TParams>
 class TOptimizerManager {
  public:
@@ -226,11 +529,37 @@ class TOptimizerManager {
     for (auto& opt : optimizers_) {
       opt->Step();
     }
+    ++steps_;
+    for (auto& hook : step_hooks_) {
+      hook(steps_);
+    }
+  }
+
+  //  Called after every Step with the number of steps made so far, e.g. to prune weights on a schedule
+  void AddStepHook(std::function<void(size_t)> hook) {
+    step_hooks_.push_back(std::move(hook));
+  }
+
+  [[nodiscard]] bool HasFiniteGradients() const {
+    for (auto& opt : optimizers_) {
+      if (!opt->HasFiniteGradient()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void ScaleGradients(float factor) {
+    for (auto& opt : optimizers_) {
+      opt->ScaleGradient(factor);
+    }
   }
 
  private:
   std::vector<std::unique_ptr<IArbitraryOptimizerUnit>> optimizers_;
   std::tuple<TParams...> constructor_parameters_;
+  std::vector<std::function<void(size_t)>> step_hooks_;
+  size_t steps_ = 0;
 };
 
 //  This is necessary because C++ can't deduce only first argument of class
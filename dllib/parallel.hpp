@@ -0,0 +1,318 @@
+#pragma once
+
+#include <dllib/tensor.hpp>
+#include <dllib/autograd.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace dllib {
+
+//  Thread pool with a task deque per worker. A worker takes tasks from the back of its own deque and,
+//  when it runs out of them, steals from the front of the others. Tasks submitted from a worker go to
+//  its own deque, so task trees are mostly processed depth-first by the thread which spawned them.
+//  The first exception thrown by a task is kept and rethrown by Wait; the tasks left until then are
+//  dropped without running.
+class TThreadPool {
+ public:
+  explicit TThreadPool(size_t threads = std::max(1u, std::thread::hardware_concurrency()))
+    : queues_(threads) {
+
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+      workers_.emplace_back([this, i] {
+        WorkerLoop(i);
+      });
+    }
+  }
+
+  TThreadPool(const TThreadPool&) = delete;
+  TThreadPool& operator=(const TThreadPool&) = delete;
+
+  ~TThreadPool() {
+    {
+      std::lock_guard guard(sleep_mutex_);
+      stop_ = true;
+    }
+    wake_up_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  void Submit(std::function<void()> task) {
+    pending_.fetch_add(1, std::memory_order_relaxed);
+
+    size_t queue_index = current_pool_ == this
+      ? current_worker_
+      : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    {
+      auto& queue = queues_[queue_index];
+      std::lock_guard guard(queue.mutex);
+      queue.tasks.push_back(std::move(task));
+    }
+
+    {
+      std::lock_guard guard(sleep_mutex_);
+      ++queued_;
+    }
+    wake_up_.notify_one();
+  }
+
+  //  Blocks until all submitted tasks, including the ones they've submitted, are done, and rethrows the
+  //  first exception thrown by them. Must not be called from inside of a task
+  void Wait() {
+    std::exception_ptr error;
+    {
+      std::unique_lock lock(sleep_mutex_);
+      all_done_.wait(lock, [this] {
+        return pending_.load(std::memory_order_acquire) == 0;
+      });
+      error = std::exchange(error_, nullptr);
+      failed_.store(false, std::memory_order_relaxed);
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  [[nodiscard]] size_t Size() const {
+    return workers_.size();
+  }
+
+ private:
+  struct TWorkerQueue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  bool TryPop(size_t index, std::function<void()>& task) {
+    for (size_t i = 0; i < queues_.size(); ++i) {
+      auto& queue = queues_[(index + i) % queues_.size()];
+      std::lock_guard guard(queue.mutex);
+      if (queue.tasks.empty()) {
+        continue;
+      }
+      if (i == 0) {
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+      } else {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+      }
+      return true;
+    }
+    return false;
+  }
+
+  void WorkerLoop(size_t index) {
+    current_pool_ = this;
+    current_worker_ = index;
+
+    std::function<void()> task;
+    while (true) {
+      {
+        std::unique_lock lock(sleep_mutex_);
+        wake_up_.wait(lock, [this] {
+          return stop_ || queued_ > 0;
+        });
+        if (queued_ == 0) {
+          return;
+        }
+        --queued_;
+      }
+
+      //  Every reservation is backed by a task in one of the queues, but the scan may miss it
+      //  while other workers are popping theirs
+      while (!TryPop(index, task)) {
+        std::this_thread::yield();
+      }
+      if (!failed_.load(std::memory_order_relaxed)) {
+        try {
+          task();
+        } catch (...) {
+          std::lock_guard guard(sleep_mutex_);
+          if (!error_) {
+            error_ = std::current_exception();
+          }
+          failed_.store(true, std::memory_order_relaxed);
+        }
+      }
+      task = nullptr;
+
+      if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard guard(sleep_mutex_);
+        all_done_.notify_all();
+      }
+    }
+  }
+
+  std::vector<TWorkerQueue> queues_;
+  std::vector<std::thread> workers_;
+
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_up_;
+  std::condition_variable all_done_;
+  size_t queued_ = 0;
+  bool stop_ = false;
+  std::exception_ptr error_;
+  std::atomic<bool> failed_ = false;
+
+  std::atomic<size_t> pending_ = 0;
+  std::atomic<size_t> next_queue_ = 0;
+
+  static inline thread_local TThreadPool* current_pool_ = nullptr;
+  static inline thread_local size_t current_worker_ = 0;
+};
+
+namespace helpers {
+
+//  Schedules PushGradient of every node as soon as all of the nodes it gets gradient from are done.
+//  Gradients flowing into the same node are serialized by a small table of striped mutexes, so
+//  unrelated nodes never wait for each other. Nodes writing gradients outside their children (checkpoints,
+//  whole models as a node) lock all of the stripes
+class TParallelBackwardExecutor {
+ public:
+  explicit TParallelBackwardExecutor(TThreadPool& pool) : pool_(pool) {
+  }
+
+  void Run(IArbitraryVariable* root) {
+    Collect(root);
+    Schedule(root);
+    pool_.Wait();
+  }
+
+ private:
+  static constexpr size_t StripeCount = 64;
+
+  struct TNodeInfo {
+    std::vector<IArbitraryVariable*> children;
+    std::vector<size_t> stripes;
+    std::atomic<size_t> in_degree = 0;
+    bool is_leaf = false;
+  };
+
+  static size_t StripeOf(IArbitraryVariable* node) {
+    return std::hash<IArbitraryVariable*>{}(node) % StripeCount;
+  }
+
+  void Collect(IArbitraryVariable* root) {
+    std::vector<IArbitraryVariable*> stack = {root};
+    nodes_[root];
+    while (!stack.empty()) {
+      auto* v = stack.back();
+      stack.pop_back();
+
+      auto all_children = v->GetChildren();
+      auto& info = nodes_[v];
+      info.is_leaf = all_children.empty();
+      for (auto* child : all_children) {
+        if (child->requires_grad) {
+          info.children.push_back(child);
+        }
+      }
+      std::sort(info.children.begin(), info.children.end());
+      info.children.erase(std::unique(info.children.begin(), info.children.end()), info.children.end());
+
+      for (auto* child : info.children) {
+        info.stripes.push_back(StripeOf(child));
+        auto [it, inserted] = nodes_.try_emplace(child);
+        it->second.in_degree.fetch_add(1, std::memory_order_relaxed);
+        if (inserted) {
+          stack.push_back(child);
+        }
+      }
+      std::sort(info.stripes.begin(), info.stripes.end());
+      info.stripes.erase(std::unique(info.stripes.begin(), info.stripes.end()), info.stripes.end());
+
+      //  The gradients such a node writes are unknown, so it holds every stripe and runs alone
+      if (v->WritesOutsideChildren()) {
+        info.stripes.resize(StripeCount);
+        std::iota(info.stripes.begin(), info.stripes.end(), 0);
+      }
+    }
+  }
+
+  void Schedule(IArbitraryVariable* node) {
+    if (nodes_.at(node).is_leaf) {
+      return;
+    }
+    pool_.Submit([this, node] {
+      Process(node);
+    });
+  }
+
+  //  Keeps the stripes of a node locked, also when PushGradient throws
+  class TStripesLock {
+   public:
+    TStripesLock(std::array<std::mutex, StripeCount>& stripes, const std::vector<size_t>& indices)
+      : stripes_(stripes),
+        indices_(indices) {
+
+      for (auto stripe : indices_) {
+        stripes_[stripe].lock();
+      }
+    }
+
+    TStripesLock(const TStripesLock&) = delete;
+    TStripesLock& operator=(const TStripesLock&) = delete;
+
+    ~TStripesLock() {
+      for (auto stripe : indices_) {
+        stripes_[stripe].unlock();
+      }
+    }
+
+   private:
+    std::array<std::mutex, StripeCount>& stripes_;
+    const std::vector<size_t>& indices_;
+  };
+
+  void Process(IArbitraryVariable* node) {
+    auto& info = nodes_.at(node);
+    {
+      TStripesLock lock(stripes_, info.stripes);
+      node->PushGradient();
+    }
+
+    for (auto* child : info.children) {
+      if (nodes_.at(child).in_degree.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        Schedule(child);
+      }
+    }
+  }
+
+  TThreadPool& pool_;
+  std::unordered_map<IArbitraryVariable*, TNodeInfo> nodes_;
+  std::array<std::mutex, StripeCount> stripes_;
+};
+
+}  // namespace helpers
+
+//  Same as IVariable::Backward, but independent branches of the graph are processed concurrently
+//  by the threads of `pool`. Results match the serial order up to floating point summation order.
+//  An exception thrown by an operation stops the pass and is rethrown here once the running ones finish.
+//  Operations writing gradients which are not their arguments (WritesOutsideArguments) are run one at a time
+template<CTensor T>
+void ParallelBackward(const TVariable<T>& root, const T& output_grad, TThreadPool& pool) {
+  root->grad = output_grad;
+  helpers::TParallelBackwardExecutor(pool).Run(root.get());
+}
+
+template<CTensor T>
+void ParallelBackward(const TVariable<T>& root, TThreadPool& pool) {
+  static_assert(T::DimensionCount == 0, "Backward without an explicit gradient requires a scalar");
+  ParallelBackward(root, T(1), pool);
+}
+
+}  // namespace dllib
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <dllib/tensor.hpp>
+#include <dllib/autograd.hpp>
+#include <dllib/layer.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace dllib {
+
+//  Gradients of the loss terms of every sample of a batch w.r.t. the parameters of FullyConnected,
+//  already clipped to the requested norm. `norms` holds the norms before clipping
+template<class TData, size_t BatchSize, size_t From, size_t To>
+struct TPerSampleGradients {
+  TTensor<TData, BatchSize, From, To> weights;
+  TTensor<TData, BatchSize, To> bias;
+  TTensor<TData, BatchSize> norms;
+};
+
+//  Same for a standalone Bias
+template<class TData, size_t BatchSize, size_t Dim>
+struct TPerSampleBiasGradients {
+  TTensor<TData, BatchSize, Dim> bias;
+  TTensor<TData, BatchSize> norms;
+};
+
+namespace helpers {
+
+template<class TInput>
+auto AsVariable(const TInput& input) {
+  if constexpr (VIsTensor<TInput>) {
+    return TVariable<TInput>(input, false);
+  } else {
+    return input;
+  }
+}
+
+template<class TData>
+TData ClipScale(TData norm, TData max_norm) {
+  return norm > max_norm ? max_norm / norm : TData(1);
+}
+
+//  x * weights + bias computed from the values of the layer parameters. The parameters are not
+//  arguments of the node, so Backward leaves their gradients alone and saves the gradient of the
+//  output instead, the per-sample gradients are recovered from it and the input
+template<class TData, size_t BatchSize, size_t From, size_t To, bool WithWeights>
+struct TPerSampleLinear {
+  using TIn = TTensor<TData, BatchSize, From>;
+  using TOut = TTensor<TData, BatchSize, To>;
+
+  static constexpr bool AlwaysRequiresGrad() {
+    return true;
+  }
+
+  static constexpr bool WritesOutsideArguments() {
+    return true;
+  }
+
+  TOut Forward(const TIn& x) {
+    if constexpr (WithWeights) {
+      return AddBias(MatrixProduct(x, *weights_), *bias_);
+    } else {
+      return AddBias(x, *bias_);
+    }
+  }
+
+  void Backward(const TOut& grad, TIn* parent) {
+    *output_grad_ += grad;
+    if (!parent) {
+      return;
+    }
+    if constexpr (WithWeights) {
+      MatrixProduct(grad, weights_->T(), *parent);
+    } else {
+      *parent += grad;
+    }
+  }
+
+  const TTensor<TData, From, To>* weights_;
+  const TTensor<TData, To>* bias_;
+  TOut* output_grad_;
+};
+
+template<bool WithWeights, class TData, size_t BatchSize, size_t From, size_t To, class TLoss>
+TTensor<TData, BatchSize, To> OutputGradient(
+  const TVariable<TTensor<TData, BatchSize, From>>& input,
+  const TTensor<TData, From, To>* weights,
+  const TTensor<TData, To>& bias,
+  TLoss&& loss) {
+
+  if (!IsGradEnabled()) {
+    throw std::runtime_error("Per-sample gradients can't be computed while gradients are disabled");
+  }
+
+  TTensor<TData, BatchSize, To> output_grad(0);
+  using TOp = TPerSampleLinear<TData, BatchSize, From, To, WithWeights>;
+  TVariable<TTensor<TData, BatchSize, To>> output = MakeOperation(TOp{weights, &bias, &output_grad}, input);
+  loss(output)->Backward();
+  return output_grad;
+}
+
+}  // namespace helpers
+
+//  Runs `loss` on the output of `layer` applied to `input` and returns the gradient of every sample's
+//  loss terms w.r.t. the layer parameters, computed from one batched backward pass: the gradient of
+//  sample b is the outer product of its input and the gradient of its output. Each per-sample gradient
+//  is scaled down to the norm of at most `max_norm` while it is written, the norms are known upfront
+//  since |x g^T|^2 + |g|^2 = |g|^2 (|x|^2 + 1).
+//
+//  `loss` must map the output TVariable to a scalar one without mixing samples (e.g. a sum or a mean of
+//  per-sample terms). Gradients still flow to `input` and to any other leaf of the loss, but not to the
+//  parameters of `layer`, use AccumulateGradients for that
+template<class TData, size_t From, size_t To, class TInput, class TLoss>
+auto PerSampleGradients(
+  FullyConnected<TData, From, To>& layer,
+  const TInput& input,
+  TLoss&& loss,
+  TData max_norm = std::numeric_limits<TData>::infinity()) {
+
+  auto x = helpers::AsVariable(input);
+  constexpr size_t batch_size = decltype(x)::TUnderlying::Dimensions[0];
+
+  auto [weights, bias_layer] = layer.GetParameters();
+  auto& bias = get<0>(bias_layer.GetParameters());
+  auto output_grad = helpers::OutputGradient<true>(x, &weights->value, bias->value, std::forward<TLoss>(loss));
+
+  TPerSampleGradients<TData, batch_size, From, To> result;
+  for (size_t b = 0; b < batch_size; ++b) {
+    const auto& xb = x->value[b];
+    const auto& gb = output_grad[b];
+    TData grad_norm = Sum(gb * gb);
+    TData norm = std::sqrt(grad_norm * (Sum(xb * xb) + 1));
+    TData scale = helpers::ClipScale(norm, max_norm);
+    result.norms[b] = norm;
+
+    for (size_t j = 0; j < To; ++j) {
+      result.bias[b][j] = scale * gb[j];
+    }
+    for (size_t i = 0; i < From; ++i) {
+      TData scaled_input = scale * xb[i];
+      for (size_t j = 0; j < To; ++j) {
+        result.weights[b][i][j] = scaled_input * gb[j];
+      }
+    }
+  }
+  return result;
+}
+
+template<class TData, size_t Dim, class TInput, class TLoss>
+auto PerSampleGradients(
+  Bias<TData, Dim>& layer,
+  const TInput& input,
+  TLoss&& loss,
+  TData max_norm = std::numeric_limits<TData>::infinity()) {
+
+  auto x = helpers::AsVariable(input);
+  constexpr size_t batch_size = decltype(x)::TUnderlying::Dimensions[0];
+
+  auto& bias = get<0>(layer.GetParameters());
+  auto output_grad = helpers::OutputGradient<false>(
+    x, static_cast<const TTensor<TData, Dim, Dim>*>(nullptr), bias->value, std::forward<TLoss>(loss));
+
+  TPerSampleBiasGradients<TData, batch_size, Dim> result;
+  for (size_t b = 0; b < batch_size; ++b) {
+    TData norm = std::sqrt(Sum(output_grad[b] * output_grad[b]));
+    TData scale = helpers::ClipScale(norm, max_norm);
+    result.norms[b] = norm;
+    for (size_t j = 0; j < Dim; ++j) {
+      result.bias[b][j] = scale * output_grad[b][j];
+    }
+  }
+  return result;
+}
+
+//  Adds the sum of the per-sample gradients to the gradients of the layer parameters, so the usual
+//  optimizers can make the step (e.g. after adding noise for differential privacy)
+template<class TData, size_t BatchSize, size_t From, size_t To>
+void AccumulateGradients(FullyConnected<TData, From, To>& layer, const TPerSampleGradients<TData, BatchSize, From, To>& grads) {
+  auto [weights, bias_layer] = layer.GetParameters();
+  auto& bias = get<0>(bias_layer.GetParameters());
+  for (size_t b = 0; b < BatchSize; ++b) {
+    weights->grad += grads.weights[b];
+    bias->grad += grads.bias[b];
+  }
+}
+
+template<class TData, size_t BatchSize, size_t Dim>
+void AccumulateGradients(Bias<TData, Dim>& layer, const TPerSampleBiasGradients<TData, BatchSize, Dim>& grads) {
+  auto& bias = get<0>(layer.GetParameters());
+  for (size_t b = 0; b < BatchSize; ++b) {
+    bias->grad += grads.bias[b];
+  }
+}
+
+//  Same as AccumulateGradients(layer, PerSampleGradients(layer, input, loss, max_norm)), but per-sample
+//  gradients are never materialized, the scaled outer products go straight into the gradients of the
+//  parameters. Returns the norms of the per-sample gradients before clipping
+template<class TData, size_t From, size_t To, class TInput, class TLoss>
+auto AccumulateClippedGradients(
+  FullyConnected<TData, From, To>& layer,
+  const TInput& input,
+  TLoss&& loss,
+  TData max_norm) {
+
+  auto x = helpers::AsVariable(input);
+  constexpr size_t batch_size = decltype(x)::TUnderlying::Dimensions[0];
+
+  auto [weights, bias_layer] = layer.GetParameters();
+  auto& bias = get<0>(bias_layer.GetParameters());
+  auto output_grad = helpers::OutputGradient<true>(x, &weights->value, bias->value, std::forward<TLoss>(loss));
+
+  auto& weights_grad = weights->grad;
+  auto& bias_grad = bias->grad;
+  TTensor<TData, batch_size> norms;
+  for (size_t b = 0; b < batch_size; ++b) {
+    const auto& xb = x->value[b];
+    const auto& gb = output_grad[b];
+    TData norm = std::sqrt(Sum(gb * gb) * (Sum(xb * xb) + 1));
+    TData scale = helpers::ClipScale(norm, max_norm);
+    norms[b] = norm;
+
+    for (size_t j = 0; j < To; ++j) {
+      bias_grad[j] += scale * gb[j];
+    }
+    for (size_t i = 0; i < From; ++i) {
+      TData scaled_input = scale * xb[i];
+      for (size_t j = 0; j < To; ++j) {
+        weights_grad[i][j] += scaled_input * gb[j];
+      }
+    }
+  }
+  return norms;
+}
+
+}  // namespace dllib
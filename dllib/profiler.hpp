@@ -0,0 +1,283 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <typeinfo>
+#include <vector>
+
+#if defined(DLLIB_PROFILE) && __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+
+namespace dllib {
+
+//  Records every forward and backward invocation of TOperationNode when the library is compiled with
+//  DLLIB_PROFILE defined and the profiler is started. Without DLLIB_PROFILE the hooks in autograd are
+//  empty and the profiler never gets any events, the interface is kept so the calling code compiles
+class TProfiler {
+ public:
+  enum class EPhase {
+    Forward,
+    Backward,
+  };
+
+  //  Static description of an operation type, shared by all of its events
+  struct TOperationInfo {
+    std::string name;
+    std::string shapes;
+  };
+
+  struct TEvent {
+    const TOperationInfo* operation;
+    EPhase phase;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    //  Estimate from the shapes: forward reads the arguments and writes the result, backward also
+    //  reads the gradient of the result and writes the gradients of the arguments
+    size_t bytes;
+    size_t thread;
+  };
+
+  static TProfiler& Get() {
+    static TProfiler profiler;
+    return profiler;
+  }
+
+  void Start() {
+    enabled_.store(true, std::memory_order_relaxed);
+  }
+
+  void Stop() {
+    enabled_.store(false, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] bool IsEnabled() const {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  void Clear() {
+    std::lock_guard guard(mutex_);
+    events_.clear();
+  }
+
+  void Record(const TEvent& event) {
+    std::lock_guard guard(mutex_);
+    events_.push_back(event);
+  }
+
+  [[nodiscard]] std::vector<TEvent> GetEvents() const {
+    std::lock_guard guard(mutex_);
+    return events_;
+  }
+
+  //  JSON in the Trace Event Format, to be opened in chrome://tracing or Perfetto
+  void WriteChromeTrace(std::ostream& out) const {
+    auto events = GetEvents();
+    out << "{\"traceEvents\":[";
+    for (size_t i = 0; i < events.size(); ++i) {
+      const auto& event = events[i];
+      out << (i ? ",\n" : "\n");
+      out << "{\"name\":";
+      WriteJsonString(out, event.operation->name);
+      out << ",\"cat\":\"" << PhaseName(event.phase) << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread
+          << std::fixed << std::setprecision(3)
+          << ",\"ts\":" << double(event.start_ns) / 1000 << ",\"dur\":" << double(event.duration_ns) / 1000
+          << std::defaultfloat
+          << ",\"args\":{\"shapes\":";
+      WriteJsonString(out, event.operation->shapes);
+      out << ",\"bytes\":" << event.bytes << "}}";
+    }
+    out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+  }
+
+  //  Table of per-operation totals, sorted by total time
+  void WriteSummary(std::ostream& out) const {
+    struct TTotal {
+      std::string_view name;
+      std::string_view shapes;
+      EPhase phase;
+      size_t calls = 0;
+      uint64_t duration_ns = 0;
+      size_t bytes = 0;
+    };
+
+    std::map<std::pair<const TOperationInfo*, EPhase>, TTotal> totals;
+    for (const auto& event : GetEvents()) {
+      auto& total = totals[{event.operation, event.phase}];
+      total.name = event.operation->name;
+      total.shapes = event.operation->shapes;
+      total.phase = event.phase;
+      ++total.calls;
+      total.duration_ns += event.duration_ns;
+      total.bytes += event.bytes;
+    }
+
+    std::vector<TTotal> rows;
+    for (const auto& [key, total] : totals) {
+      rows.push_back(total);
+    }
+    std::sort(rows.begin(), rows.end(), [](const auto& lhs, const auto& rhs) {
+      return lhs.duration_ns > rhs.duration_ns;
+    });
+
+    out << std::left << std::setw(24) << "operation" << std::setw(10) << "phase" << std::right
+        << std::setw(8) << "calls" << std::setw(12) << "total ms" << std::setw(12) << "mean us"
+        << std::setw(10) << "GB/s" << "  shapes\n";
+    for (const auto& row : rows) {
+      double seconds = double(row.duration_ns) / 1e9;
+      out << std::left << std::setw(24) << row.name << std::setw(10) << PhaseName(row.phase) << std::right
+          << std::setw(8) << row.calls << std::fixed << std::setprecision(3)
+          << std::setw(12) << seconds * 1e3
+          << std::setw(12) << seconds * 1e6 / row.calls
+          << std::setw(10) << (seconds > 0 ? double(row.bytes) / seconds / 1e9 : 0.)
+          << std::defaultfloat << "  " << row.shapes << "\n";
+    }
+  }
+
+  static uint64_t NowNS() {
+    static const auto origin = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+  }
+
+  static size_t ThreadIndex() {
+    static std::atomic<size_t> next = 0;
+    thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed);
+    return index;
+  }
+
+ private:
+  static const char* PhaseName(EPhase phase) {
+    return phase == EPhase::Forward ? "forward" : "backward";
+  }
+
+  //  Control characters aren't allowed in JSON strings, so they are written as \uXXXX
+  static void WriteJsonString(std::ostream& out, std::string_view s) {
+    static constexpr char Hex[] = "0123456789abcdef";
+    out << '"';
+    for (char c : s) {
+      auto code = static_cast<unsigned char>(c);
+      if (c == '"' || c == '\\') {
+        out << '\\' << c;
+      } else if (code < 0x20) {
+        out << "\\u00" << Hex[code >> 4] << Hex[code & 0xf];
+      } else {
+        out << c;
+      }
+    }
+    out << '"';
+  }
+
+  std::atomic<bool> enabled_ = false;
+  mutable std::mutex mutex_;
+  std::vector<TEvent> events_;
+};
+
+namespace helpers {
+
+//  Name of a type without namespaces and enclosing functions, e.g. "TAddition" for the local struct
+//  of operator+
+inline std::string ShortTypeName(const std::type_info& type) {
+  std::string name = type.name();
+#if defined(DLLIB_PROFILE) && __has_include(<cxxabi.h>)
+  int status = 0;
+  char* demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+  if (status == 0 && demangled) {
+    name = demangled;
+  }
+  std::free(demangled);
+#endif
+
+  size_t depth = 0;
+  size_t start = 0;
+  for (size_t i = 0; i + 1 < name.size(); ++i) {
+    if (name[i] == '<' || name[i] == '(') {
+      ++depth;
+    } else if ((name[i] == '>' || name[i] == ')') && depth > 0) {
+      --depth;
+    } else if (depth == 0 && name[i] == ':' && name[i + 1] == ':') {
+      start = i + 2;
+    }
+  }
+  return name.substr(start);
+}
+
+template<class T>
+std::string ShapeString() {
+  std::string result = "[";
+  for (size_t i = 0; i < T::DimensionCount; ++i) {
+    result += (i ? ", " : "") + std::to_string(T::Dimensions[i]);
+  }
+  return result + "]";
+}
+
+template<class TOperation, class TValue, class... TArgs>
+const TProfiler::TOperationInfo& GetOperationInfo() {
+  static const TProfiler::TOperationInfo info = [] {
+    std::string shapes;
+    ((shapes += (shapes.empty() ? "" : ", ") + ShapeString<TArgs>()), ...);
+    return TProfiler::TOperationInfo{ShortTypeName(typeid(TOperation)), shapes + " -> " + ShapeString<TValue>()};
+  }();
+  return info;
+}
+
+#ifdef DLLIB_PROFILE
+
+//  Times the enclosing scope if the profiler is started
+template<class TOperation, class TValue, class... TArgs>
+class TOperationScope {
+ public:
+  explicit TOperationScope(TProfiler::EPhase phase)
+    : phase_(phase),
+      start_ns_(TProfiler::Get().IsEnabled() ? TProfiler::NowNS() : NotStarted) {
+  }
+
+  TOperationScope(const TOperationScope&) = delete;
+  TOperationScope& operator=(const TOperationScope&) = delete;
+
+  ~TOperationScope() {
+    if (start_ns_ == NotStarted) {
+      return;
+    }
+    size_t bytes = sizeof(TValue) + (sizeof(TArgs) + ... + 0);
+    if (phase_ == TProfiler::EPhase::Backward) {
+      bytes += sizeof(TValue) + (sizeof(TArgs) + ... + 0);
+    }
+    TProfiler::Get().Record({
+      &GetOperationInfo<TOperation, TValue, TArgs...>(),
+      phase_,
+      start_ns_,
+      TProfiler::NowNS() - start_ns_,
+      bytes,
+      TProfiler::ThreadIndex()});
+  }
+
+ private:
+  static constexpr uint64_t NotStarted = ~uint64_t(0);
+
+  TProfiler::EPhase phase_;
+  uint64_t start_ns_;
+};
+
+#else
+
+template<class TOperation, class TValue, class... TArgs>
+class TOperationScope {
+ public:
+  explicit constexpr TOperationScope(TProfiler::EPhase) {
+  }
+};
+
+#endif
+
+}  // namespace helpers
+
+}  // namespace dllib
@@ -0,0 +1,363 @@
+#pragma once
+
+#include <dllib/tensor.hpp>
+#include <dllib/autograd.hpp>
+#include <dllib/layer.hpp>
+
+#include <cmath>
+
+namespace dllib {
+
+namespace helpers {
+
+template<class TData>
+TData SigmoidOf(TData x) {
+  return 1 / (1 + std::exp(-x));
+}
+
+//  One LSTM step as a single node. The gate pre-activations of all four gates come from one GEMM of the
+//  concatenated [x, h] with the stacked weights, the rest is one elementwise pass. Forward keeps what
+//  backward needs: the concatenated input, the gate activations and tanh of the new cell state
+template<class TData, size_t Batch, size_t In, size_t Hidden>
+struct TLSTMCell {
+  using TInput = TTensor<TData, Batch, In>;
+  using TState = TTensor<TData, Batch, 2 * Hidden>;
+  using TWeights = TTensor<TData, In + Hidden, 4 * Hidden>;
+  using TBias = TTensor<TData, 4 * Hidden>;
+
+  //  Gates are stored in the order input, forget, cell, output
+  TState Forward(const TInput& x, const TState& state, const TWeights& weights, const TBias& bias) {
+    for (size_t b = 0; b < Batch; ++b) {
+      for (size_t k = 0; k < In; ++k) {
+        xh_[b][k] = x[b][k];
+      }
+      for (size_t j = 0; j < Hidden; ++j) {
+        xh_[b][In + j] = state[b][j];
+      }
+    }
+    gates_ = AddBias(MatrixProduct(xh_, weights), bias);
+
+    TState result;
+    for (size_t b = 0; b < Batch; ++b) {
+      auto& gates = gates_[b];
+      for (size_t j = 0; j < Hidden; ++j) {
+        TData i = gates[j] = SigmoidOf<TData>(gates[j]);
+        TData f = gates[Hidden + j] = SigmoidOf<TData>(gates[Hidden + j]);
+        TData g = gates[2 * Hidden + j] = std::tanh(TData(gates[2 * Hidden + j]));
+        TData o = gates[3 * Hidden + j] = SigmoidOf<TData>(gates[3 * Hidden + j]);
+
+        TData c = f * state[b][Hidden + j] + i * g;
+        TData tanh_c = tanh_c_[b][j] = std::tanh(c);
+        result[b][j] = o * tanh_c;
+        result[b][Hidden + j] = c;
+      }
+    }
+    return result;
+  }
+
+  void Backward(
+    const TState& grad,
+    TVariable<TInput>& x,
+    TVariable<TState>& state,
+    TVariable<TWeights>& weights,
+    TVariable<TBias>& bias) {
+
+    TTensor<TData, Batch, 4 * Hidden> gates_grad;
+    for (size_t b = 0; b < Batch; ++b) {
+      const auto& gates = gates_[b];
+      for (size_t j = 0; j < Hidden; ++j) {
+        TData i = gates[j];
+        TData f = gates[Hidden + j];
+        TData g = gates[2 * Hidden + j];
+        TData o = gates[3 * Hidden + j];
+        TData tanh_c = tanh_c_[b][j];
+
+        TData h_grad = grad[b][j];
+        TData c_grad = grad[b][Hidden + j] + h_grad * o * (1 - tanh_c * tanh_c);
+        gates_grad[b][j] = c_grad * g * i * (1 - i);
+        gates_grad[b][Hidden + j] = c_grad * state->value[b][Hidden + j] * f * (1 - f);
+        gates_grad[b][2 * Hidden + j] = c_grad * i * (1 - g * g);
+        gates_grad[b][3 * Hidden + j] = h_grad * tanh_c * o * (1 - o);
+
+        if (state->requires_grad) {
+          state->grad[b][Hidden + j] += c_grad * f;
+        }
+      }
+    }
+
+    if (weights->requires_grad) {
+      TransposedMatrixProduct(xh_, gates_grad, weights->grad);
+    }
+    if (bias->requires_grad) {
+      for (size_t b = 0; b < Batch; ++b) {
+        bias->grad += gates_grad[b];
+      }
+    }
+    if (x->requires_grad || state->requires_grad) {
+      auto xh_grad = MatrixProductTransposed(gates_grad, weights->value);
+      for (size_t b = 0; b < Batch; ++b) {
+        if (x->requires_grad) {
+          for (size_t k = 0; k < In; ++k) {
+            x->grad[b][k] += xh_grad[b][k];
+          }
+        }
+        if (state->requires_grad) {
+          for (size_t j = 0; j < Hidden; ++j) {
+            state->grad[b][j] += xh_grad[b][In + j];
+          }
+        }
+      }
+    }
+  }
+
+  TTensor<TData, Batch, In + Hidden> xh_;
+  TTensor<TData, Batch, 4 * Hidden> gates_;
+  TTensor<TData, Batch, Hidden> tanh_c_;
+};
+
+//  One GRU step as a single node: one GEMM for the three gates of the input and one for the three gates
+//  of the hidden state (the reset gate multiplies the hidden part of the candidate, so the two can't be
+//  merged into a single product), then one elementwise pass
+template<class TData, size_t Batch, size_t In, size_t Hidden>
+struct TGRUCell {
+  using TInput = TTensor<TData, Batch, In>;
+  using TState = TTensor<TData, Batch, Hidden>;
+  using TInputWeights = TTensor<TData, In, 3 * Hidden>;
+  using TStateWeights = TTensor<TData, Hidden, 3 * Hidden>;
+  using TBias = TTensor<TData, 3 * Hidden>;
+
+  //  Gates are stored in the order reset, update, candidate
+  TState Forward(
+    const TInput& x,
+    const TState& h,
+    const TInputWeights& input_weights,
+    const TStateWeights& state_weights,
+    const TBias& input_bias,
+    const TBias& state_bias) {
+
+    gates_ = AddBias(MatrixProduct(x, input_weights), input_bias);
+    auto state_gates = AddBias(MatrixProduct(h, state_weights), state_bias);
+
+    TState result;
+    for (size_t b = 0; b < Batch; ++b) {
+      auto& gates = gates_[b];
+      for (size_t j = 0; j < Hidden; ++j) {
+        TData r = gates[j] = SigmoidOf<TData>(gates[j] + state_gates[b][j]);
+        TData z = gates[Hidden + j] = SigmoidOf<TData>(gates[Hidden + j] + state_gates[b][Hidden + j]);
+        TData candidate_state = state_candidate_[b][j] = state_gates[b][2 * Hidden + j];
+        TData n = gates[2 * Hidden + j] = std::tanh(gates[2 * Hidden + j] + r * candidate_state);
+        result[b][j] = (1 - z) * n + z * h[b][j];
+      }
+    }
+    return result;
+  }
+
+  void Backward(
+    const TState& grad,
+    TVariable<TInput>& x,
+    TVariable<TState>& h,
+    TVariable<TInputWeights>& input_weights,
+    TVariable<TStateWeights>& state_weights,
+    TVariable<TBias>& input_bias,
+    TVariable<TBias>& state_bias) {
+
+    TTensor<TData, Batch, 3 * Hidden> input_gates_grad;
+    TTensor<TData, Batch, 3 * Hidden> state_gates_grad;
+    for (size_t b = 0; b < Batch; ++b) {
+      const auto& gates = gates_[b];
+      for (size_t j = 0; j < Hidden; ++j) {
+        TData r = gates[j];
+        TData z = gates[Hidden + j];
+        TData n = gates[2 * Hidden + j];
+        TData h_grad = grad[b][j];
+
+        TData n_grad = h_grad * (1 - z) * (1 - n * n);
+        TData r_grad = n_grad * state_candidate_[b][j] * r * (1 - r);
+        TData z_grad = h_grad * (h->value[b][j] - n) * z * (1 - z);
+
+        input_gates_grad[b][j] = state_gates_grad[b][j] = r_grad;
+        input_gates_grad[b][Hidden + j] = state_gates_grad[b][Hidden + j] = z_grad;
+        input_gates_grad[b][2 * Hidden + j] = n_grad;
+        state_gates_grad[b][2 * Hidden + j] = n_grad * r;
+
+        if (h->requires_grad) {
+          h->grad[b][j] += h_grad * z;
+        }
+      }
+    }
+
+    if (input_weights->requires_grad) {
+      TransposedMatrixProduct(x->value, input_gates_grad, input_weights->grad);
+    }
+    if (state_weights->requires_grad) {
+      TransposedMatrixProduct(h->value, state_gates_grad, state_weights->grad);
+    }
+    for (size_t b = 0; b < Batch; ++b) {
+      if (input_bias->requires_grad) {
+        input_bias->grad += input_gates_grad[b];
+      }
+      if (state_bias->requires_grad) {
+        state_bias->grad += state_gates_grad[b];
+      }
+    }
+    if (x->requires_grad) {
+      MatrixProductTransposed(input_gates_grad, input_weights->value, x->grad);
+    }
+    if (h->requires_grad) {
+      MatrixProductTransposed(state_gates_grad, state_weights->value, h->grad);
+    }
+  }
+
+  TTensor<TData, Batch, 3 * Hidden> gates_;
+  TTensor<TData, Batch, Hidden> state_candidate_;
+};
+
+//  The hidden half of a stacked LSTM state
+template<class TData, size_t Batch, size_t Hidden>
+struct THiddenOfState {
+  using TState = TTensor<TData, Batch, 2 * Hidden>;
+  using THidden = TTensor<TData, Batch, Hidden>;
+
+  THidden Forward(const TState& state) {
+    return SplitAlong<1, Hidden>(state).first;
+  }
+
+  void Backward(const THidden& grad, TState* state) {
+    if (state) {
+      for (size_t b = 0; b < Batch; ++b) {
+        for (size_t j = 0; j < Hidden; ++j) {
+          (*state)[b][j] += grad[b][j];
+        }
+      }
+    }
+  }
+};
+
+}  // namespace helpers
+
+//  Long short-term memory cell. The state of a batch is a single tensor holding the hidden state
+//  followed by the cell state, GetHidden() extracts the former as the output of a step:
+//
+//    auto state = cell.InitialState<Batch>();
+//    for (auto& x : sequence) {
+//      state = cell(x, state);
+//    }
+//    auto output = LSTMCell<...>::GetHidden(state);
+template<class TData, size_t In, size_t Hidden>
+class LSTMCell {
+ public:
+  template<size_t Batch>
+  using TState = TTensor<TData, Batch, 2 * Hidden>;
+
+  LSTMCell() : LSTMCell(helpers::GetNormalGenerator<TData>()) {}
+
+  template<class TGen>
+  explicit LSTMCell(TGen gen) {
+    for (auto& x : weights->value.template View<-1u>()) {
+      x = gen();
+    }
+    for (auto& x : bias->value) {
+      x = gen();
+    }
+  }
+
+  template<size_t Batch>
+  static TVariable<TState<Batch>> InitialState() {
+    return TVariable<TState<Batch>>(TState<Batch>(0), false);
+  }
+
+  template<size_t Batch>
+  TState<Batch> operator()(const TTensor<TData, Batch, In>& x, const TState<Batch>& state) {
+    return helpers::TLSTMCell<TData, Batch, In, Hidden>{}.Forward(x, state, weights->value, bias->value);
+  }
+
+  template<size_t Batch>
+  TVariable<TState<Batch>> operator()(
+    const TVariable<TTensor<TData, Batch, In>>& x,
+    const TVariable<TState<Batch>>& state) {
+
+    return MakeOperation(helpers::TLSTMCell<TData, Batch, In, Hidden>{}, x, state, weights, bias);
+  }
+
+  template<size_t Batch>
+  static TVariable<TTensor<TData, Batch, Hidden>> GetHidden(const TVariable<TState<Batch>>& state) {
+    return MakeOperation(helpers::THiddenOfState<TData, Batch, Hidden>{}, state);
+  }
+
+  auto GetParameters() {
+    return std::tie(weights, bias);
+  }
+
+  auto GetSerializationFields() const {
+    return std::tie(weights, bias);
+  }
+
+ private:
+  //  Rows are the input followed by the hidden state, columns are the four gates one after another
+  TVariable<TTensor<TData, In + Hidden, 4 * Hidden>> weights{true};
+  TVariable<TTensor<TData, 4 * Hidden>> bias{true};
+};
+
+//  Gated recurrent unit cell, the state of a batch is the hidden state
+template<class TData, size_t In, size_t Hidden>
+class GRUCell {
+ public:
+  template<size_t Batch>
+  using TState = TTensor<TData, Batch, Hidden>;
+
+  GRUCell() : GRUCell(helpers::GetNormalGenerator<TData>()) {}
+
+  template<class TGen>
+  explicit GRUCell(TGen gen) {
+    for (auto& x : input_weights->value.template View<-1u>()) {
+      x = gen();
+    }
+    for (auto& x : state_weights->value.template View<-1u>()) {
+      x = gen();
+    }
+    for (auto& x : input_bias->value) {
+      x = gen();
+    }
+    for (auto& x : state_bias->value) {
+      x = gen();
+    }
+  }
+
+  template<size_t Batch>
+  static TVariable<TState<Batch>> InitialState() {
+    return TVariable<TState<Batch>>(TState<Batch>(0), false);
+  }
+
+  template<size_t Batch>
+  TState<Batch> operator()(const TTensor<TData, Batch, In>& x, const TState<Batch>& state) {
+    return helpers::TGRUCell<TData, Batch, In, Hidden>{}.Forward(
+      x, state, input_weights->value, state_weights->value, input_bias->value, state_bias->value);
+  }
+
+  template<size_t Batch>
+  TVariable<TState<Batch>> operator()(
+    const TVariable<TTensor<TData, Batch, In>>& x,
+    const TVariable<TState<Batch>>& state) {
+
+    return MakeOperation(
+      helpers::TGRUCell<TData, Batch, In, Hidden>{},
+      x, state, input_weights, state_weights, input_bias, state_bias);
+  }
+
+  auto GetParameters() {
+    return std::tie(input_weights, state_weights, input_bias, state_bias);
+  }
+
+  auto GetSerializationFields() const {
+    return std::tie(input_weights, state_weights, input_bias, state_bias);
+  }
+
+ private:
+  //  Columns are the three gates one after another
+  TVariable<TTensor<TData, In, 3 * Hidden>> input_weights{true};
+  TVariable<TTensor<TData, Hidden, 3 * Hidden>> state_weights{true};
+  TVariable<TTensor<TData, 3 * Hidden>> input_bias{true};
+  TVariable<TTensor<TData, 3 * Hidden>> state_bias{true};
+};
+
+}  // namespace dllib
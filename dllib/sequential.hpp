@@ -0,0 +1,307 @@
+#pragma once
+
+#include <dllib/tensor.hpp>
+#include <dllib/autograd.hpp>
+#include <dllib/layer.hpp>
+#include <dllib/normalization.hpp>
+
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+
+namespace dllib {
+
+namespace helpers {
+
+//  How a layer runs inside Sequential on a batch of TInput: the type of its result, and Forward and
+//  Backward writing into buffers owned by the container. Backward adds to the gradients of the parameters
+//  and overwrites the gradient of the input unless `x_grad` is null. Anything else backward needs is kept
+//  in the step
+template<class TLayer, class TInput>
+struct TSequentialStep;
+
+template<class TData, size_t Batch, size_t From, size_t To>
+struct TSequentialStep<FullyConnected<TData, From, To>, TTensor<TData, Batch, From>> {
+  using TLayer = FullyConnected<TData, From, To>;
+  using TInput = TTensor<TData, Batch, From>;
+  using TOutput = TTensor<TData, Batch, To>;
+
+  explicit TSequentialStep(const TLayer&) {
+  }
+
+  void Forward(TLayer& layer, const TInput& x, TOutput& result) {
+    auto [weights, bias_layer] = layer.GetParameters();
+    auto [bias] = bias_layer.GetParameters();
+    for (size_t b = 0; b < Batch; ++b) {
+      result[b] = bias->value;
+    }
+    MatrixProduct(x, weights->value, result);
+  }
+
+  void Backward(TLayer& layer, const TInput& x, const TOutput&, const TOutput& grad, TInput* x_grad) {
+    auto [weights, bias_layer] = layer.GetParameters();
+    auto [bias] = bias_layer.GetParameters();
+    if (weights->requires_grad) {
+      TransposedMatrixProduct(x, grad, weights->grad);
+    }
+    if (bias->requires_grad) {
+      for (size_t b = 0; b < Batch; ++b) {
+        bias->grad += grad[b];
+      }
+    }
+    if (x_grad) {
+      *x_grad = TInput(0);
+      MatrixProductTransposed(grad, weights->value, *x_grad);
+    }
+  }
+};
+
+template<class TFunction, CTensor TInput>
+struct TSequentialStep<Activation<TFunction>, TInput> {
+  using TLayer = Activation<TFunction>;
+  using TOutput = TInput;
+  using TData = typename TInput::TData;
+
+  explicit TSequentialStep(const TLayer&) {
+  }
+
+  void Forward(TLayer&, const TInput& x, TOutput& result) {
+    const auto& from = x.template View<-1u>();
+    auto& to = result.template View<-1u>();
+    for (size_t i = 0; i < TInput::TotalElements; ++i) {
+      to[i] = TFunction::Apply(TData(from[i]));
+    }
+  }
+
+  void Backward(TLayer&, const TInput&, const TOutput& result, const TOutput& grad, TInput* x_grad) {
+    if (!x_grad) {
+      return;
+    }
+    const auto& y = result.template View<-1u>();
+    const auto& from = grad.template View<-1u>();
+    auto& to = x_grad->template View<-1u>();
+    for (size_t i = 0; i < TInput::TotalElements; ++i) {
+      to[i] = from[i] * TFunction::DerivativeOfResult(TData(y[i]));
+    }
+  }
+};
+
+//  The layer's own node (see LayerNorm::GetOperation) is kept in the step and run on the tensors directly
+template<class TLayer, class TOperation>
+struct TNormalizationStep {
+  using TInput = typename TOperation::T;
+  using TOutput = TInput;
+
+  explicit TNormalizationStep(const TLayer& layer)
+    : operation_(layer.template GetOperation<TInput::Dimensions[0]>()) {
+  }
+
+  void Forward(TLayer& layer, const TInput& x, TOutput& result) {
+    auto [scale, shift] = layer.GetParameters();
+    result = operation_.Forward(x, scale->value, shift->value);
+  }
+
+  void Backward(TLayer& layer, const TInput&, const TOutput&, const TOutput& grad, TInput* x_grad) {
+    auto [scale, shift] = layer.GetParameters();
+    if (x_grad) {
+      *x_grad = TInput(0);
+    }
+    operation_.AccumulateGradients(
+      grad, scale->value, x_grad, GetGradientPointerIfRequired(scale), GetGradientPointerIfRequired(shift));
+  }
+
+  TOperation operation_;
+};
+
+template<class TData, size_t Batch, size_t Features>
+struct TSequentialStep<LayerNorm<TData, Features>, TTensor<TData, Batch, Features>>
+  : TNormalizationStep<LayerNorm<TData, Features>, TLayerNorm<TData, Batch, Features>> {
+
+  using TNormalizationStep<LayerNorm<TData, Features>, TLayerNorm<TData, Batch, Features>>::TNormalizationStep;
+};
+
+template<class TData, size_t Batch, size_t Features>
+struct TSequentialStep<BatchNorm<TData, Features>, TTensor<TData, Batch, Features>>
+  : TNormalizationStep<BatchNorm<TData, Features>, TBatchNorm<TData, Batch, Features>> {
+
+  using TNormalizationStep<BatchNorm<TData, Features>, TBatchNorm<TData, Batch, Features>>::TNormalizationStep;
+};
+
+//  Steps of the layers and the types of their inputs, derived from the input of the first layer. The steps
+//  are TSequentialStep for training and TFrozenStep for FrozenSequential
+template<template<class, class> class TStepTemplate, CTensor TInput, class... TLayers>
+struct TSequentialShapes {
+  using TSteps = std::tuple<>;
+  using TInputs = std::tuple<>;
+  using TOutput = TInput;
+};
+
+template<template<class, class> class TStepTemplate, CTensor TInput, class TLayer, class... TRest>
+struct TSequentialShapes<TStepTemplate, TInput, TLayer, TRest...> {
+  using TStep = TStepTemplate<TLayer, TInput>;
+  using TNext = TSequentialShapes<TStepTemplate, typename TStep::TOutput, TRest...>;
+
+  using TSteps = decltype(std::tuple_cat(std::declval<std::tuple<TStep>>(), std::declval<typename TNext::TSteps>()));
+  using TInputs = decltype(std::tuple_cat(std::declval<std::tuple<TInput>>(), std::declval<typename TNext::TInputs>()));
+  using TOutput = typename TNext::TOutput;
+};
+
+}  // namespace helpers
+
+//  Layers applied one after another to batches of TInput. The shape between every two layers is derived at
+//  compile time and gets its own activation and gradient buffer, which Forward and Backward reuse on every
+//  call, so a training step on tensors doesn't allocate. Supported layers are FullyConnected, Activation,
+//  LayerNorm and BatchNorm
+template<CTensor TInput, class... TLayers>
+class Sequential {
+  static_assert(sizeof...(TLayers) > 0, "Sequential needs at least one layer");
+
+  using TShapes = helpers::TSequentialShapes<helpers::TSequentialStep, TInput, TLayers...>;
+  using TSteps = typename TShapes::TSteps;
+  using TInputs = typename TShapes::TInputs;
+
+  static constexpr size_t LayerCount = sizeof...(TLayers);
+
+ public:
+  using TOutput = typename TShapes::TOutput;
+
+  Sequential() : Sequential(TLayers()...) {
+  }
+
+  explicit Sequential(TLayers... layers)
+    : layers_(std::move(layers)...),
+      steps_([this]<size_t... i>(std::index_sequence<i...>) {
+        return TSteps(std::tuple_element_t<i, TSteps>(get<i>(layers_))...);
+      }(std::make_index_sequence<LayerCount>())) {
+  }
+
+  //  Nodes made by operator() point to the model, so it stays in place
+  Sequential(const Sequential&) = delete;
+  Sequential& operator=(const Sequential&) = delete;
+
+  ~Sequential() {
+    *self_ = nullptr;
+  }
+
+  //  Training pass: keeps the activations of every layer, BatchNorm uses (and updates) the batch statistics.
+  //  The result stays valid until the next call
+  const TOutput& Forward(const TInput& x) {
+    get<0>(inputs_) = x;
+    [this]<size_t... i>(std::index_sequence<i...>) {
+      (get<i>(steps_).Forward(get<i>(layers_), get<i>(inputs_), Output<i>()), ...);
+    }(std::make_index_sequence<LayerCount>());
+    ++generation_;
+    return output_;
+  }
+
+  //  Adds the gradients of the parameters for `grad` of the result of the last Forward, and the gradient of
+  //  its input to `x_grad` if given. Without it the input gradient of the first layer isn't computed at all
+  void Backward(const TOutput& grad, TInput* x_grad = nullptr) {
+    BackwardFrom<LayerCount - 1>(grad, x_grad != nullptr);
+    if (x_grad) {
+      *x_grad += get<0>(input_grads_);
+    }
+  }
+
+  //  Inference, the same as calling the layers one by one
+  TOutput operator()(const TInput& x) {
+    return Apply<0>(x);
+  }
+
+  //  The whole model as a single node. Only the result of the latest call can be backpropagated, since
+  //  the activations are overwritten by every call. The model has to outlive the node: Backward of a node
+  //  whose model has been destroyed throws
+  TVariable<TOutput> operator()(const TVariable<TInput>& x) {
+    if (!IsGradEnabled()) {
+      return TVariable<TOutput>((*this)(x->value), false);
+    }
+    return MakeOperation(TOperation{self_, 0}, x);
+  }
+
+  template<size_t i>
+  auto& GetLayer() {
+    return get<i>(layers_);
+  }
+
+  template<size_t i>
+  const auto& GetLayer() const {
+    return get<i>(layers_);
+  }
+
+  auto GetParameters() {
+    return std::apply([](auto&... layers) {
+      return std::tie(layers...);
+    }, layers_);
+  }
+
+  auto GetSerializationFields() const {
+    return std::apply([](const auto&... layers) {
+      return std::tie(layers...);
+    }, layers_);
+  }
+
+ private:
+  struct TOperation {
+    static constexpr bool WritesOutsideArguments() {
+      return true;
+    }
+
+    TOutput Forward(const TInput& x) {
+      const auto& result = (*model_)->Forward(x);
+      generation_ = (*model_)->generation_;
+      return result;
+    }
+
+    void Backward(const TOutput& grad, TInput* x) {
+      Sequential* model = *model_;
+      if (!model) {
+        throw std::runtime_error("The model of a Sequential node has been destroyed");
+      }
+      if (generation_ != model->generation_) {
+        throw std::runtime_error("The activations of a Sequential node have been overwritten by a later call");
+      }
+      model->Backward(grad, x);
+    }
+
+    //  Reset to null by the destructor of the model
+    std::shared_ptr<Sequential*> model_;
+    size_t generation_;
+  };
+
+  template<size_t i>
+  auto& Output() {
+    if constexpr (i + 1 == LayerCount) {
+      return output_;
+    } else {
+      return get<i + 1>(inputs_);
+    }
+  }
+
+  template<size_t i>
+  void BackwardFrom(const typename std::tuple_element_t<i, TSteps>::TOutput& grad, bool input_grad) {
+    auto* x_grad = i > 0 || input_grad ? &get<i>(input_grads_) : nullptr;
+    get<i>(steps_).Backward(get<i>(layers_), get<i>(inputs_), Output<i>(), grad, x_grad);
+    if constexpr (i > 0) {
+      BackwardFrom<i - 1>(get<i>(input_grads_), input_grad);
+    }
+  }
+
+  template<size_t i, CTensor T>
+  auto Apply(const T& x) {
+    if constexpr (i + 1 == LayerCount) {
+      return get<i>(layers_)(x);
+    } else {
+      return Apply<i + 1>(get<i>(layers_)(x));
+    }
+  }
+
+  std::tuple<TLayers...> layers_;
+  TSteps steps_;
+  TInputs inputs_;
+  TInputs input_grads_;
+  TOutput output_;
+  size_t generation_ = 0;
+  std::shared_ptr<Sequential*> self_ = std::make_shared<Sequential*>(this);
+};
+
+}  // namespace dllib
@@ -0,0 +1,288 @@
+#pragma once
+
+#include <dllib/tensor.hpp>
+#include <dllib/autograd.hpp>
+#include <dllib/layer.hpp>
+#include <dllib/serialization.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+namespace dllib {
+
+namespace helpers {
+
+//  Nonzero blocks of a weight matrix in block compressed sparse row form: the block columns of block row
+//  `r` are columns[offsets[r]] ... columns[offsets[r + 1] - 1]
+struct TBlockIndex {
+  std::vector<size_t> offsets;
+  std::vector<size_t> columns;
+  std::vector<bool> active;
+};
+
+//  x * weights as a single node, touching only the blocks of `weights` listed in the index. Each block is
+//  copied to a local tile once and applied to the whole batch. The index is shared with the layer and
+//  replaced rather than modified, so pruning between Forward and Backward doesn't affect the node
+template<class TData, size_t Batch, size_t From, size_t To, size_t BlockRows, size_t BlockColumns>
+struct TBlockSparseProduct {
+  using TInput = TTensor<TData, Batch, From>;
+  using TWeights = TTensor<TData, From, To>;
+  using TResult = TTensor<TData, Batch, To>;
+
+  TResult Forward(const TInput& x, const TWeights& weights) {
+    TResult result(0);
+    ForEachBlock([&x, &weights, &result](size_t from, size_t to) {
+      TData block[BlockRows][BlockColumns];
+      for (size_t r = 0; r < BlockRows; ++r) {
+        for (size_t c = 0; c < BlockColumns; ++c) {
+          block[r][c] = weights[from + r][to + c];
+        }
+      }
+      for (size_t b = 0; b < Batch; ++b) {
+        TData sums[BlockColumns] = {};
+        for (size_t r = 0; r < BlockRows; ++r) {
+          TData a = x[b][from + r];
+          for (size_t c = 0; c < BlockColumns; ++c) {
+            sums[c] += a * block[r][c];
+          }
+        }
+        for (size_t c = 0; c < BlockColumns; ++c) {
+          result[b][to + c] += sums[c];
+        }
+      }
+    });
+    return result;
+  }
+
+  void Backward(const TResult& grad, TVariable<TInput>& x, TVariable<TWeights>& weights) {
+    ForEachBlock([&grad, &x, &weights](size_t from, size_t to) {
+      if (x->requires_grad) {
+        TData block[BlockRows][BlockColumns];
+        for (size_t r = 0; r < BlockRows; ++r) {
+          for (size_t c = 0; c < BlockColumns; ++c) {
+            block[r][c] = weights->value[from + r][to + c];
+          }
+        }
+        for (size_t b = 0; b < Batch; ++b) {
+          TData sums[BlockRows] = {};
+          for (size_t r = 0; r < BlockRows; ++r) {
+            for (size_t c = 0; c < BlockColumns; ++c) {
+              sums[r] += TData(grad[b][to + c]) * block[r][c];
+            }
+          }
+          for (size_t r = 0; r < BlockRows; ++r) {
+            x->grad[b][from + r] += sums[r];
+          }
+        }
+      }
+      if (weights->requires_grad) {
+        TData sums[BlockRows][BlockColumns] = {};
+        for (size_t b = 0; b < Batch; ++b) {
+          for (size_t r = 0; r < BlockRows; ++r) {
+            TData a = x->value[b][from + r];
+            for (size_t c = 0; c < BlockColumns; ++c) {
+              sums[r][c] += a * TData(grad[b][to + c]);
+            }
+          }
+        }
+        for (size_t r = 0; r < BlockRows; ++r) {
+          for (size_t c = 0; c < BlockColumns; ++c) {
+            weights->grad[from + r][to + c] += sums[r][c];
+          }
+        }
+      }
+    });
+  }
+
+  //  Calls `function` with the first row and column of every active block
+  template<class TFunction>
+  void ForEachBlock(TFunction&& function) const {
+    for (size_t block_row = 0; block_row < From / BlockRows; ++block_row) {
+      for (size_t i = index_->offsets[block_row]; i < index_->offsets[block_row + 1]; ++i) {
+        function(block_row * BlockRows, index_->columns[i] * BlockColumns);
+      }
+    }
+  }
+
+  std::shared_ptr<const TBlockIndex> index_;
+};
+
+}  // namespace helpers
+
+//  Gradual magnitude pruning: between `begin_step` and `end_step` the sparsity goes from `initial_sparsity`
+//  to `final_sparsity` as final + (initial - final) * (1 - progress)^3, every `frequency` steps. Most blocks
+//  are removed early, while the rest of the network can still adapt
+struct TPruningSchedule {
+  double SparsityAt(size_t step) const {
+    if (step <= begin_step) {
+      return initial_sparsity;
+    }
+    if (step >= end_step) {
+      return final_sparsity;
+    }
+    double remaining = 1 - double(step - begin_step) / double(end_step - begin_step);
+    return final_sparsity + (initial_sparsity - final_sparsity) * remaining * remaining * remaining;
+  }
+
+  bool IsPruningStep(size_t step) const {
+    return step >= begin_step && step <= end_step && (step - begin_step) % frequency == 0;
+  }
+
+  double initial_sparsity = 0;
+  double final_sparsity = 0.9;
+  size_t begin_step = 0;
+  size_t end_step = 10'000;
+  size_t frequency = 100;
+};
+
+//  FullyConnected whose weights are split into BlockRows x BlockColumns blocks, of which only the nonzero
+//  ones take part in the products. The weights are kept dense, so the optimizers work on them as usual and
+//  the serialized form is the same as FullyConnected's. Blocks are made zero by Prune
+template<class TData, size_t From, size_t To, size_t BlockRows = 4, size_t BlockColumns = 4>
+class BlockSparseFullyConnected {
+  static_assert(From % BlockRows == 0 && To % BlockColumns == 0, "Blocks should tile the weight matrix");
+
+ public:
+  static constexpr size_t RowBlocks = From / BlockRows;
+  static constexpr size_t ColumnBlocks = To / BlockColumns;
+
+  BlockSparseFullyConnected() : BlockSparseFullyConnected(helpers::GetNormalGenerator<TData>()) {}
+
+  template<class TGen>
+  explicit BlockSparseFullyConnected(TGen gen) : bias(gen) {
+    for (auto& x : var->value.template View<-1u>()) {
+      x = gen();
+    }
+    RebuildIndex();
+  }
+
+  //  Copies the parameters of a dense layer, its zero blocks are skipped right away
+  explicit BlockSparseFullyConnected(FullyConnected<TData, From, To>& dense) {
+    auto [weights, dense_bias] = dense.GetParameters();
+    var->value = weights->value;
+    std::get<0>(bias.GetParameters())->value = std::get<0>(dense_bias.GetParameters())->value;
+    RebuildIndex();
+  }
+
+  template<size_t Batch>
+  TTensor<TData, Batch, To> operator()(const TTensor<TData, Batch, From>& value) {
+    return bias(GetOperation<Batch>().Forward(value, var->value));
+  }
+
+  template<size_t Batch>
+  TVariable<TTensor<TData, Batch, To>> operator()(const TVariable<TTensor<TData, Batch, From>>& value) {
+    return bias(MakeOperation(GetOperation<Batch>(), value, var));
+  }
+
+  //  Zeroes the blocks with the smallest Frobenius norm, so that at least `sparsity` of all blocks are zero
+  void Prune(double sparsity) {
+    std::vector<TData> norms(RowBlocks * ColumnBlocks, TData(0));
+    for (size_t i = 0; i < From; ++i) {
+      for (size_t j = 0; j < To; ++j) {
+        TData x = var->value[i][j];
+        norms[i / BlockRows * ColumnBlocks + j / BlockColumns] += x * x;
+      }
+    }
+    std::vector<size_t> order(norms.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    size_t pruned = std::min(order.size(), size_t(std::ceil(sparsity * double(order.size()) - 1e-9)));
+    std::nth_element(order.begin(), order.begin() + pruned, order.end(), [&norms](size_t l, size_t r) {
+      return norms[l] < norms[r];
+    });
+    for (size_t i = 0; i < pruned; ++i) {
+      ZeroBlock(order[i] / ColumnBlocks, order[i] % ColumnBlocks);
+    }
+    RebuildIndex();
+  }
+
+  //  Zeroes the weights of the pruned blocks again, an optimizer with momentum moves them after a step
+  void ApplyMask() {
+    for (size_t block_row = 0; block_row < RowBlocks; ++block_row) {
+      for (size_t block_column = 0; block_column < ColumnBlocks; ++block_column) {
+        if (!index_->active[block_row * ColumnBlocks + block_column]) {
+          ZeroBlock(block_row, block_column);
+        }
+      }
+    }
+  }
+
+  //  Fraction of the blocks which are skipped
+  double Sparsity() const {
+    return 1 - double(index_->columns.size()) / double(RowBlocks * ColumnBlocks);
+  }
+
+  auto GetParameters() {
+    return std::tie(var, bias);
+  }
+
+  void Dump(std::ostream& out) const {
+    dllib::Dump(out, var);
+    dllib::Dump(out, bias);
+  }
+
+  void Load(std::istream& in) {
+    dllib::Load(in, var);
+    dllib::Load(in, bias);
+    RebuildIndex();
+  }
+
+ private:
+  template<size_t Batch>
+  helpers::TBlockSparseProduct<TData, Batch, From, To, BlockRows, BlockColumns> GetOperation() const {
+    return {index_};
+  }
+
+  void ZeroBlock(size_t block_row, size_t block_column) {
+    for (size_t r = 0; r < BlockRows; ++r) {
+      for (size_t c = 0; c < BlockColumns; ++c) {
+        var->value[block_row * BlockRows + r][block_column * BlockColumns + c] = 0;
+      }
+    }
+  }
+
+  //  A block is active unless all of its weights are zero
+  void RebuildIndex() {
+    auto index = std::make_shared<helpers::TBlockIndex>();
+    index->offsets.reserve(RowBlocks + 1);
+    index->active.resize(RowBlocks * ColumnBlocks);
+    index->offsets.push_back(0);
+    for (size_t block_row = 0; block_row < RowBlocks; ++block_row) {
+      for (size_t block_column = 0; block_column < ColumnBlocks; ++block_column) {
+        bool active = false;
+        for (size_t r = 0; r < BlockRows && !active; ++r) {
+          for (size_t c = 0; c < BlockColumns && !active; ++c) {
+            active = TData(var->value[block_row * BlockRows + r][block_column * BlockColumns + c]) != TData(0);
+          }
+        }
+        if (active) {
+          index->columns.push_back(block_column);
+          index->active[block_row * ColumnBlocks + block_column] = true;
+        }
+      }
+      index->offsets.push_back(index->columns.size());
+    }
+    index_ = std::move(index);
+  }
+
+  TVariable<TTensor<TData, From, To>> var{true};
+  Bias<TData, To> bias;
+  std::shared_ptr<const helpers::TBlockIndex> index_;
+};
+
+//  Prunes `layer` after the optimizer steps chosen by `schedule` and keeps the pruned blocks at zero after
+//  the others. The hook refers to `layer`, which should outlive `optimizer`
+template<class TOptimizerManager, class TLayer>
+void AddPruning(TOptimizerManager& optimizer, TLayer& layer, TPruningSchedule schedule) {
+  optimizer.AddStepHook([&layer, schedule](size_t step) {
+    if (schedule.IsPruningStep(step)) {
+      layer.Prune(schedule.SparsityAt(step));
+    } else {
+      layer.ApplyMask();
+    }
+  });
+}
+
+}  // namespace dllib
@@ -227,6 +227,13 @@ class TTensor<TDataType> {
     return *this;
   }
 
+  //  Element conversion for To(), also between types that only convert through float (see TBFloat16)
+  template<class TOtherData> requires (!std::is_same_v<TOtherData, TDataType>)
+  constexpr TTensor& operator=(const TTensor<TOtherData>& other) {
+    data_ = TDataType(other.Data());
+    return *this;
+  }
+
   template<size_t... NewDims>
   const TTensor<TDataType, NewDims...>& View() const {
     static_assert(TTensor<TDataType, NewDims...>::TotalElements == TotalElements);
@@ -266,7 +273,43 @@ class TTensor<TDataType> {
 
   constexpr bool operator==(const TTensor&) const = default;
 
+  //  Arithmetic element types get the compound assignments as built-ins through the conversion to
+  //  TDataType&, class types (see TBFloat16) need them here
+
+  template<class TOther> requires std::is_class_v<TDataType>
+  constexpr TTensor& operator+=(const TOther& other) {
+    data_ += Unwrap(other);
+    return *this;
+  }
+
+  template<class TOther> requires std::is_class_v<TDataType>
+  constexpr TTensor& operator-=(const TOther& other) {
+    data_ -= Unwrap(other);
+    return *this;
+  }
+
+  template<class TOther> requires std::is_class_v<TDataType>
+  constexpr TTensor& operator*=(const TOther& other) {
+    data_ *= Unwrap(other);
+    return *this;
+  }
+
+  template<class TOther> requires std::is_class_v<TDataType>
+  constexpr TTensor& operator/=(const TOther& other) {
+    data_ /= Unwrap(other);
+    return *this;
+  }
+
  private:
+  template<class TOther>
+  static constexpr decltype(auto) Unwrap(const TOther& other) {
+    if constexpr (VIsTensor<TOther>) {
+      return other.Data();
+    } else {
+      return (other);
+    }
+  }
+
   TDataType data_;
 };
 
@@ -691,16 +734,41 @@ constexpr bool AllOf(const TTensor<bool, Dims...>& t) {
   }
 }
 
+namespace helpers {
+
+//  Type the products below accumulate in. Storage types like TBFloat16 sum in float, so a long dot product
+//  doesn't lose the bits rounding every partial sum would, and are rounded once when the result is stored
+template<class TData>
+using TAccumulator = std::conditional_t<std::is_class_v<TData> && std::is_convertible_v<TData, float>, float, TData>;
+
+//  Columns of a row of a product summed in the local buffer at a time, so the buffer stays a few
+//  kilobytes on the stack however wide the result is
+constexpr size_t ProductRowTile = 256;
+
+}  // namespace helpers
+
+//  Adds the product to `result`. A row of it is accumulated in a local buffer first: the buffer can't alias
+//  the arguments, so the inner loop vectorizes even when the compiler can't tell `result` apart from them
 template<class TData, size_t Dim1, size_t Dim2, size_t Dim3>
 void MatrixProduct(
   const TTensor<TData, Dim1, Dim2>& matrix1,
   const TTensor<TData, Dim2, Dim3>& matrix2,
   TTensor<TData, Dim1, Dim3>& result) {
 
+  using TSum = helpers::TAccumulator<TData>;
+  constexpr size_t Tile = std::min(Dim3, helpers::ProductRowTile);
   for (size_t i = 0; i < Dim1; ++i) {
-    for (size_t j = 0; j < Dim2; ++j) {
-      for (size_t k = 0; k < Dim3; ++k) {
-        result[i][k] += matrix1[i][j] * matrix2[j][k];
+    for (size_t begin = 0; begin < Dim3; begin += Tile) {
+      size_t width = std::min(Tile, Dim3 - begin);
+      TSum row[Tile] = {};
+      for (size_t j = 0; j < Dim2; ++j) {
+        TSum a = TData(matrix1[i][j]);
+        for (size_t k = 0; k < width; ++k) {
+          row[k] += a * TSum(TData(matrix2[j][begin + k]));
+        }
+      }
+      for (size_t k = 0; k < width; ++k) {
+        result[i][begin + k] += row[k];
       }
     }
   }
@@ -722,11 +790,14 @@ void MatrixProductTransposed(
   const TTensor<TData, Dim3, Dim2>& matrix2_T,
   TTensor<TData, Dim1, Dim3>& result) {
 
+  using TSum = helpers::TAccumulator<TData>;
   for (size_t i = 0; i < Dim1; ++i) {
     for (size_t j = 0; j < Dim3; ++j) {
+      TSum sum = 0;
       for (size_t k = 0; k < Dim2; ++k) {
-        result[i][j] += matrix1[i][k] * matrix2_T[j][k];
+        sum += TSum(TData(matrix1[i][k])) * TSum(TData(matrix2_T[j][k]));
       }
+      result[i][j] += sum;
     }
   }
 }
@@ -736,38 +807,84 @@ TTensor<TData, Dim1, Dim3> MatrixProductTransposed(
   const TTensor<TData, Dim1, Dim2>& matrix1,
   const TTensor<TData, Dim3, Dim2>& matrix2_T) {
 
-  TTensor<TData, Dim1, Dim3> result;
+  TTensor<TData, Dim1, Dim3> result(0);
   MatrixProductTransposed(matrix1, matrix2_T, result);
   return result;
 }
 
+//  Adds matrix1_T^T * matrix2 to `result`, without materializing the transpose
+template<class TData, size_t Dim1, size_t Dim2, size_t Dim3>
+void TransposedMatrixProduct(
+  const TTensor<TData, Dim2, Dim1>& matrix1_T,
+  const TTensor<TData, Dim2, Dim3>& matrix2,
+  TTensor<TData, Dim1, Dim3>& result) {
+
+  using TSum = helpers::TAccumulator<TData>;
+  constexpr size_t Tile = std::min(Dim3, helpers::ProductRowTile);
+  for (size_t i = 0; i < Dim1; ++i) {
+    for (size_t begin = 0; begin < Dim3; begin += Tile) {
+      size_t width = std::min(Tile, Dim3 - begin);
+      TSum row[Tile] = {};
+      for (size_t j = 0; j < Dim2; ++j) {
+        TSum a = TData(matrix1_T[j][i]);
+        for (size_t k = 0; k < width; ++k) {
+          row[k] += a * TSum(TData(matrix2[j][begin + k]));
+        }
+      }
+      for (size_t k = 0; k < width; ++k) {
+        result[i][begin + k] += row[k];
+      }
+    }
+  }
+}
+
+template<class TData, size_t Dim1, size_t Dim2, size_t Dim3>
+TTensor<TData, Dim1, Dim3> TransposedMatrixProduct(
+  const TTensor<TData, Dim2, Dim1>& matrix1_T,
+  const TTensor<TData, Dim2, Dim3>& matrix2) {
+
+  TTensor<TData, Dim1, Dim3> result(0);
+  TransposedMatrixProduct(matrix1_T, matrix2, result);
+  return result;
+}
+
 template<CTensor T>
 T Sqrt(T inp) {
-  ApplyFunctionInplace<T::DimensionCount>(static_cast<typename T::TData (*)(typename T::TData)>(std::sqrt), inp);
+  ApplyFunctionInplace<T::DimensionCount>([](typename T::TData x) -> typename T::TData {
+    return std::sqrt(x);
+  }, inp);
   return inp;
 }
 
 template<CTensor T>
 T Log(T inp) {
-  ApplyFunctionInplace<T::DimensionCount>(static_cast<typename T::TData (*)(typename T::TData)>(std::log), inp);
+  ApplyFunctionInplace<T::DimensionCount>([](typename T::TData x) -> typename T::TData {
+    return std::log(x);
+  }, inp);
   return inp;
 }
 
 template<CTensor T>
 T Abs(T inp) {
-  ApplyFunctionInplace<T::DimensionCount>(static_cast<typename T::TData (*)(typename T::TData)>(std::abs), inp);
+  ApplyFunctionInplace<T::DimensionCount>([](typename T::TData x) -> typename T::TData {
+    return std::abs(x);
+  }, inp);
   return inp;
 }
 
 template<CTensor T>
 T Exp(T inp) {
-  ApplyFunctionInplace<T::DimensionCount>(static_cast<typename T::TData (*)(typename T::TData)>(std::exp), inp);
+  ApplyFunctionInplace<T::DimensionCount>([](typename T::TData x) -> typename T::TData {
+    return std::exp(x);
+  }, inp);
   return inp;
 }
 
 template<CTensor T>
 T Tanh(T inp) {
-  ApplyFunctionInplace<T::DimensionCount>(static_cast<typename T::TData (*)(typename T::TData)>(std::tanh), inp);
+  ApplyFunctionInplace<T::DimensionCount>([](typename T::TData x) -> typename T::TData {
+    return std::tanh(x);
+  }, inp);
   return inp;
 }
 
@@ -22,7 +22,7 @@ void SqrtExample() {
   std::cout << var->grad << std::endl;
 }
 
-size_t Benchmark() {
+size_t Benchmark(bool inplace) {
   using TDouble = float;
   using namespace dllib;
 
@@ -46,15 +46,25 @@ size_t Benchmark() {
   auto start = clock();
   for (size_t i = 0; i < K; ++i) {
     size_t a = rnd() % M, b = rnd() % M;
-    if (rnd() % 2 == 0) {
+    if (inplace) {
+      if (rnd() % 2 == 0) {
+        AddInplace(arr[a], arr[b]);
+      } else {
+        SubInplace(arr[a], arr[b]);
+      }
+    } else if (rnd() % 2 == 0) {
       arr[a] = arr[a] + arr[b];
     } else {
-      arr[a] = arr[b] - arr[a];
+      arr[a] = arr[a] - arr[b];
     }
   }
-  auto sm = arr[0];
+  auto sm = arr[0].Copy();
   for (size_t i = 1; i < M; ++i) {
-    sm = sm + arr[i];
+    if (inplace) {
+      AddInplace(sm, arr[i]);
+    } else {
+      sm = sm + arr[i];
+    }
   }
   Sum(sm)->Backward();
   auto stop = clock();
@@ -65,9 +75,11 @@ size_t Benchmark() {
 int main() {
 //  LogExample();
 //  SqrtExample();
-  size_t total_ms = 0;
-  for (size_t i = 0; i < 20; ++i) {
-    total_ms += Benchmark();
+  for (bool inplace : {false, true}) {
+    size_t total_ms = 0;
+    for (size_t i = 0; i < 20; ++i) {
+      total_ms += Benchmark(inplace);
+    }
+    std::cout << (inplace ? "In-place: " : "Out-of-place: ") << total_ms / 20 << std::endl;
   }
-  std::cout << total_ms / 20 << std::endl;
 }
@@ -0,0 +1,77 @@
+#include <dllib/data.hpp>
+#include <dllib/layer.hpp>
+#include <dllib/optimizer.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+using namespace dllib;
+
+constexpr size_t Batch = 64, Features = 128, Samples = 1 << 16, Steps = 4096;
+
+using TModel = FullyConnected<float, Features, 1>;
+
+template<class TFunction>
+double SamplesPerSecond(TFunction&& step) {
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < Steps; ++i) {
+    step();
+  }
+  std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+  return double(Steps * Batch) / seconds.count();
+}
+
+int main() {
+  auto path = (std::filesystem::temp_directory_path() / "dllib-data-example").string();
+  {
+    TDatasetWriter<Features> writer(path);
+    auto gen = helpers::GetNormalGenerator<float>();
+    TTensor<float, Features> x;
+    for (size_t i = 0; i < Samples; ++i) {
+      std::generate(x.begin(), x.end(), gen);
+      writer.Add(x, TTensor<float, 1>{Sum(x)});
+    }
+  }
+  TMappedDataset<Features> dataset(path);
+
+  TModel model;
+  auto optimizer = MakeOptimizerManager<TSGDOptimizerUnit>(1e-4f);
+  optimizer.AddParameter(model);
+  auto train = [&model, &optimizer](const TTensor<float, Batch, Features>& x, const TTensor<float, Batch, 1>& y) {
+    auto diff = model(TVariable(x, false)) - TVariable(y, false);
+    Sum(diff * diff)->Backward();
+    optimizer.Step();
+  };
+
+  //  Shuffling and gathering on the training thread, as the examples did with generated data
+  std::vector<size_t> order(Samples);
+  std::iota(order.begin(), order.end(), size_t(0));
+  std::mt19937_64 gen(0);
+  size_t position = Samples;
+  TTensor<float, Batch, Features> x;
+  TTensor<float, Batch, 1> y;
+  auto gather = [&] {
+    for (size_t b = 0; b < Batch; ++b) {
+      if (position == Samples) {
+        std::shuffle(order.begin(), order.end(), gen);
+        position = 0;
+      }
+      x[b] = dataset.GetFeatures(order[position]);
+      y[b] = dataset.GetTargets(order[position]);
+      ++position;
+    }
+  };
+
+  TBatchLoader<Batch, Features> loader(dataset);
+  std::cout << "samples/s" << std::endl;
+  std::cout << "gather only:          " << SamplesPerSecond(gather) << std::endl;
+  std::cout << "loader only:          " << SamplesPerSecond([&loader] { loader.Next(); }) << std::endl;
+  std::cout << "gather + train step:  " << SamplesPerSecond([&] { gather(); train(x, y); }) << std::endl;
+  std::cout << "loader + train step:  " << SamplesPerSecond([&] {
+    const auto& batch = loader.Next();
+    train(batch.features, batch.targets);
+  }) << std::endl;
+
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,45 @@
+#include <dllib/fused_optimizer.hpp>
+#include <dllib/layer.hpp>
+
+#include <iostream>
+#include <memory>
+
+#include "helpers.hpp"
+
+using namespace dllib;
+
+constexpr size_t Width = 256, Steps = 200;
+
+//  Four large weight matrices and small biases, 263k parameters
+struct TModel {
+  auto GetParameters() {
+    return std::tie(first, second, third, fourth);
+  }
+
+  FullyConnected<float, Width, Width> first, second, third, fourth;
+};
+
+template<class TOptimizer>
+double MicrosecondsPerStep(TOptimizer& optimizer) {
+  return 1000 * example_helpers::MillisecondsPerStep(Steps, [&optimizer] {
+    optimizer.Step();
+  });
+}
+
+int main() {
+  auto model = std::make_unique<TModel>();
+
+  auto units = MakeOptimizerManager<TAdamOptimizerUnit>(1e-3f);
+  units.AddParameter(*model);
+  auto fused = MakeFusedOptimizer<TFusedAdam>(1e-3f);
+  fused.AddParameter(*model);
+  TThreadPool pool;
+  auto threaded = MakeFusedOptimizer<TFusedAdam>(1e-3f);
+  threaded.SetThreadPool(&pool);
+  threaded.AddParameter(*model);
+
+  std::cout << "Adam step of " << fused.Size() << " parameters, us" << std::endl;
+  std::cout << "units:           " << MicrosecondsPerStep(units) << std::endl;
+  std::cout << "fused:           " << MicrosecondsPerStep(fused) << std::endl;
+  std::cout << "fused, " << pool.Size() << " threads: " << MicrosecondsPerStep(threaded) << std::endl;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <dllib/autograd.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+
+//  Helpers shared by the examples
+
+namespace example_helpers {
+
+//  Average wall time of a call of `step` over `steps` calls
+template<class TFunction>
+double MillisecondsPerStep(size_t steps, TFunction&& step) {
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < steps; ++i) {
+    step();
+  }
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / steps;
+}
+
+//  Prints the time of forward on tensors, and of forward with backward on variables
+template<class TLayer, class TInput>
+void Measure(const char* name, TLayer& layer, const TInput& x, size_t steps) {
+  float checksum = 0;
+  auto forward = MillisecondsPerStep(steps, [&] {
+    checksum += layer(x)[0][0];
+  });
+  auto training = MillisecondsPerStep(steps, [&] {
+    Sum(layer(dllib::TVariable(x, true)))->Backward();
+  });
+  std::cout << name << forward << " ms forward, " << training << " ms forward + backward";
+  std::cout << " (checksum " << checksum << ")" << std::endl;
+}
+
+}  // namespace example_helpers
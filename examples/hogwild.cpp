@@ -0,0 +1,79 @@
+#include <dllib/hogwild.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+using namespace dllib;
+
+constexpr size_t Batch = 16, In = 64, Samples = 4096, TotalSteps = 8'000;
+
+using TInput = TTensor<float, Batch, In>;
+using TOutput = TTensor<float, Batch, 1>;
+using TModel = FullyConnected<float, In, 1>;
+
+struct TDataset {
+  std::vector<TTensor<float, In>> xs;
+  std::vector<float> ys;
+};
+
+TDataset MakeDataset() {
+  std::mt19937 gen(1);
+  std::normal_distribution<float> dist;
+  TTensor<float, In> true_weights;
+  for (auto& x : true_weights) {
+    x = dist(gen);
+  }
+
+  TDataset data{std::vector<TTensor<float, In>>(Samples), std::vector<float>(Samples)};
+  for (size_t i = 0; i < Samples; ++i) {
+    for (auto& x : data.xs[i]) {
+      x = dist(gen);
+    }
+    data.ys[i] = Sum(data.xs[i] * true_weights) + 0.1f * dist(gen);
+  }
+  return data;
+}
+
+float MeanLoss(TModel& model, const TDataset& data) {
+  TNoGradGuard guard;
+  float total = 0;
+  for (size_t i = 0; i + Batch <= Samples; i += Batch) {
+    TInput inp;
+    TOutput expected;
+    for (size_t b = 0; b < Batch; ++b) {
+      inp[b] = data.xs[i + b];
+      expected[b][0] = data.ys[i + b];
+    }
+    auto diff = model(TVariable(inp, false)) - TVariable(expected, false);
+    total += Sum(diff * diff)->value;
+  }
+  return total / Samples;
+}
+
+int main() {
+  auto data = MakeDataset();
+  auto step = [&data](TModel& model, size_t thread, size_t /* iteration */) {
+    thread_local std::mt19937 gen(thread);
+    TInput inp;
+    TOutput expected;
+    for (size_t b = 0; b < Batch; ++b) {
+      size_t sample = gen() % Samples;
+      inp[b] = data.xs[sample];
+      expected[b][0] = data.ys[sample];
+    }
+    auto diff = model(TVariable(inp, false)) - TVariable(expected, false);
+    return Sum(diff * diff);
+  };
+
+  std::cout << "threads  wall ms  final loss" << std::endl;
+  for (size_t threads : {1, 2, 4, 8}) {
+    TModel model;
+    auto start = std::chrono::steady_clock::now();
+    HogwildTrain<TSGDOptimizerUnit>(model, threads, TotalSteps / threads, step, 1e-3f);
+    auto stop = std::chrono::steady_clock::now();
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count();
+    std::cout << threads << "\t " << ms << "\t  " << MeanLoss(model, data) << std::endl;
+  }
+}
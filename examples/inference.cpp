@@ -0,0 +1,76 @@
+#include <dllib/frozen.hpp>
+#include <dllib/layer.hpp>
+
+#include <ctime>
+#include <iostream>
+
+using namespace dllib;
+
+constexpr size_t Batch = 32, In = 64, Hidden = 128, Out = 16, K = 2'000;
+
+using TInput = TTensor<float, Batch, In>;
+
+template<class TFunction>
+size_t MeasureNS(TInput& inp, TFunction&& function) {
+  float sink = function();
+  auto start = clock();
+  for (size_t i = 0; i < K; ++i) {
+    //  Keeps the compiler from hoisting pure computations out of the loop
+    inp[i % Batch][i % In] += 1e-3;
+    sink += function();
+  }
+  auto stop = clock();
+  if (sink == 42) {
+    std::cout << "";
+  }
+  return (stop - start) * size_t(1e9) / CLOCKS_PER_SEC / K;
+}
+
+int main() {
+  FullyConnected<float, In, Hidden> fc1;
+  FullyConnected<float, Hidden, Out> fc2;
+
+  TInput inp;
+  {
+    auto& data = inp.View<-1u>();
+    std::generate(data.Begin(), data.End(), helpers::GetNormalGenerator<float>());
+  }
+
+  auto& w1 = get<0>(fc1.GetParameters())->value;
+  auto& b1 = get<0>(get<1>(fc1.GetParameters()).GetParameters())->value;
+  auto& w2 = get<0>(fc2.GetParameters())->value;
+  auto& b2 = get<0>(get<1>(fc2.GetParameters()).GetParameters())->value;
+
+  auto raw = MeasureNS(inp, [&] {
+    auto hidden = Tanh(helpers::AddBias(MatrixProduct(inp, w1), b1));
+    return Sum(helpers::AddBias(MatrixProduct(hidden, w2), b2));
+  });
+
+  auto layers_on_tensors = MeasureNS(inp, [&] {
+    return Sum(fc2(DropOut(Tanh(fc1(inp)))));
+  });
+
+  auto variables_no_grad = MeasureNS(inp, [&] {
+    TNoGradGuard guard;
+    return Sum(fc2(DropOut(Tanh(fc1(TVariable(inp, false))))))->value.Data();
+  });
+
+  auto variables_with_graph = MeasureNS(inp, [&] {
+    return Sum(fc2(DropOut(Tanh(fc1(TVariable(inp, false))))))->value.Data();
+  });
+
+  //  The layers share their parameters with fc1 and fc2, the frozen copy has its own
+  Sequential<TInput, FullyConnected<float, In, Hidden>, TanhActivation, FullyConnected<float, Hidden, Out>> model(
+    fc1, {}, fc2);
+  const auto frozen = Freeze(model);
+  auto frozen_blob = MeasureNS(inp, [&] {
+    return Sum(frozen(inp));
+  });
+
+  std::cout << "Raw TTensor code:          " << raw << " ns" << std::endl;
+  std::cout << "Layers on TTensor:         " << layers_on_tensors << " ns" << std::endl;
+  std::cout << "TVariable, TNoGradGuard:   " << variables_no_grad << " ns"
+            << " (recycled leaf and reference count per layer or op)" << std::endl;
+  std::cout << "TVariable, graph recorded: " << variables_with_graph << " ns" << std::endl;
+  std::cout << "Frozen weight blob:        " << frozen_blob << " ns" << std::endl;
+}
@@ -1,4 +1,5 @@
 #include <dllib/layer.hpp>
+#include <dllib/loss.hpp>
 #include <dllib/optimizer.hpp>
 
 #include <iostream>
@@ -36,8 +37,7 @@ int main() {
 //    }
     {
       auto expected = MatrixProduct(inp, t);
-      auto diff = TVariable(expected, false) - out;
-      Sum(diff * diff)->Backward();
+      MeanSquaredError(out, expected, EReduction::Sum)->Backward();
     }
 //    std::cout << "Grad: " << get<0>(fc.GetParameters())->grad << std::endl;
     opt.Step();
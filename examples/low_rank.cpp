@@ -0,0 +1,62 @@
+#include <dllib/low_rank.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+
+#include "helpers.hpp"
+
+using namespace dllib;
+
+constexpr size_t Batch = 32, From = 512, To = 512, Rank = 32, Steps = 50;
+
+using TInput = TTensor<float, Batch, From>;
+using TDense = FullyConnected<float, From, To>;
+using TLowRank = LowRankFullyConnected<float, From, Rank, To>;
+
+using example_helpers::Measure;
+
+int main() {
+  auto gen = helpers::GetNormalGenerator<float>();
+
+  //  Weights of rank Rank with a little noise on top, like a layer which is close to low rank
+  auto dense = std::make_unique<TDense>();
+  auto [weights, bias] = dense->GetParameters();
+  auto left = std::make_unique<TTensor<float, From, Rank>>();
+  auto right = std::make_unique<TTensor<float, Rank, To>>();
+  for (auto& v : left->View<-1u>()) {
+    v = gen();
+  }
+  for (auto& v : right->View<-1u>()) {
+    v = gen();
+  }
+  weights->value = MatrixProduct(*left, *right);
+  for (auto& v : weights->value.View<-1u>()) {
+    v += 0.01f * gen();
+  }
+
+  auto x = std::make_unique<TInput>();
+  for (auto& v : x->View<-1u>()) {
+    v = gen();
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  auto low_rank = std::make_unique<TLowRank>(*dense);
+  std::chrono::duration<double> conversion = std::chrono::steady_clock::now() - start;
+
+  auto expected = (*dense)(*x);
+  auto result = (*low_rank)(*x);
+  double error = 0, norm = 0;
+  for (size_t b = 0; b < Batch; ++b) {
+    for (size_t j = 0; j < To; ++j) {
+      error += (result[b][j] - expected[b][j]) * (result[b][j] - expected[b][j]);
+      norm += expected[b][j] * expected[b][j];
+    }
+  }
+  std::cout << "conversion:  " << conversion.count() << " s, relative output error " << std::sqrt(error / norm) << std::endl;
+  std::cout << "parameters:  " << From * To << " dense, " << Rank * (From + To) << " low rank" << std::endl;
+
+  Measure("dense:       ", *dense, *x, Steps);
+  Measure("low rank:    ", *low_rank, *x, Steps);
+}
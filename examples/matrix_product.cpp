@@ -0,0 +1,74 @@
+#include <dllib/tensor.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+
+using namespace dllib;
+
+//  The kernel MatrixProduct had before: sums go straight into `result`, which the compiler can't tell
+//  apart from the arguments
+template<class TData, size_t Dim1, size_t Dim2, size_t Dim3>
+void NaiveMatrixProduct(
+  const TTensor<TData, Dim1, Dim2>& matrix1,
+  const TTensor<TData, Dim2, Dim3>& matrix2,
+  TTensor<TData, Dim1, Dim3>& result) {
+
+  for (size_t i = 0; i < Dim1; ++i) {
+    for (size_t j = 0; j < Dim2; ++j) {
+      for (size_t k = 0; k < Dim3; ++k) {
+        result[i][k] += matrix1[i][j] * matrix2[j][k];
+      }
+    }
+  }
+}
+
+template<class TFunction>
+double MicrosecondsPerCall(size_t calls, TFunction&& function) {
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < calls; ++i) {
+    function();
+  }
+  std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / calls;
+}
+
+template<size_t N>
+void Benchmark(size_t calls) {
+  using TMatrix = TTensor<float, N, N>;
+
+  std::mt19937 rnd(std::random_device{}());
+  std::normal_distribution<float> dist;
+  auto a = std::make_unique<TMatrix>(), b = std::make_unique<TMatrix>(), result = std::make_unique<TMatrix>(0);
+  for (auto& x : a->template View<-1u>()) {
+    x = dist(rnd);
+  }
+  for (auto& x : b->template View<-1u>()) {
+    x = dist(rnd);
+  }
+
+  auto naive = MicrosecondsPerCall(calls, [&] {
+    NaiveMatrixProduct(*a, *b, *result);
+  });
+  auto buffered = MicrosecondsPerCall(calls, [&] {
+    MatrixProduct(*a, *b, *result);
+  });
+  auto transpose_copy = MicrosecondsPerCall(calls, [&] {
+    MatrixProduct(a->T(), *b, *result);
+  });
+  auto transposed = MicrosecondsPerCall(calls, [&] {
+    TransposedMatrixProduct(*a, *b, *result);
+  });
+
+  std::cout << N << "x" << N << ": naive " << naive << " us, MatrixProduct " << buffered << " us, ";
+  std::cout << "A^T * B through T() " << transpose_copy << " us, TransposedMatrixProduct " << transposed << " us";
+  std::cout << " (checksum " << Sum(*result) << ")" << std::endl;
+}
+
+int main() {
+  Benchmark<16>(100'000);
+  Benchmark<64>(2'000);
+  Benchmark<128>(200);
+  Benchmark<256>(20);
+}
@@ -0,0 +1,77 @@
+#include <dllib/per_sample.hpp>
+
+#include <ctime>
+#include <iostream>
+
+using namespace dllib;
+
+constexpr size_t Batch = 128, In = 16, Out = 8, K = 200;
+constexpr float MaxNorm = 1;
+
+using TInput = TTensor<float, Batch, In>;
+using TOutput = TTensor<float, Batch, Out>;
+
+template<class TFunction>
+size_t MeasureUS(TFunction&& function) {
+  auto start = clock();
+  for (size_t i = 0; i < K; ++i) {
+    function();
+  }
+  auto stop = clock();
+  return (stop - start) * size_t(1e6) / CLOCKS_PER_SEC / K;
+}
+
+int main() {
+  FullyConnected<float, In, Out> fc;
+  auto [weights, bias_layer] = fc.GetParameters();
+  auto& bias = get<0>(bias_layer.GetParameters());
+
+  TInput inp;
+  TOutput expected;
+  auto gen = helpers::GetNormalGenerator<float>();
+  std::generate(inp.View<-1u>().Begin(), inp.View<-1u>().End(), gen);
+  std::generate(expected.View<-1u>().Begin(), expected.View<-1u>().End(), gen);
+
+  //  Batch size 1 forward/backward for every sample, clipping and summing the parameter gradients
+  auto loop = MeasureUS([&] {
+    TTensor<float, In, Out> total_weights(0);
+    TTensor<float, Out> total_bias(0);
+    for (size_t b = 0; b < Batch; ++b) {
+      TTensor<float, 1, In> sample_inp({inp[b]});
+      TTensor<float, 1, Out> sample_expected({expected[b]});
+      auto diff = TVariable(sample_expected, false) - fc(TVariable(sample_inp, false));
+      Sum(diff * diff)->Backward();
+
+      float norm = std::sqrt(Sum(weights->grad * weights->grad) + Sum(bias->grad * bias->grad));
+      float scale = helpers::ClipScale(norm, MaxNorm);
+      total_weights += weights->grad * scale;
+      total_bias += bias->grad * scale;
+      weights->ZeroGrad();
+      bias->ZeroGrad();
+    }
+    return total_weights;
+  });
+
+  auto batched = MeasureUS([&] {
+    auto grads = PerSampleGradients(fc, inp, [&expected](const auto& out) {
+      auto diff = out - TVariable(expected, false);
+      return Sum(diff * diff);
+    }, MaxNorm);
+    AccumulateGradients(fc, grads);
+    weights->ZeroGrad();
+    bias->ZeroGrad();
+  });
+
+  auto fused = MeasureUS([&] {
+    AccumulateClippedGradients(fc, inp, [&expected](const auto& out) {
+      auto diff = out - TVariable(expected, false);
+      return Sum(diff * diff);
+    }, MaxNorm);
+    weights->ZeroGrad();
+    bias->ZeroGrad();
+  });
+
+  std::cout << "Per-sample loop:            " << loop << " us" << std::endl;
+  std::cout << "PerSampleGradients:         " << batched << " us" << std::endl;
+  std::cout << "AccumulateClippedGradients: " << fused << " us" << std::endl;
+}
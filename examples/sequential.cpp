@@ -0,0 +1,60 @@
+#include <dllib/optimizer.hpp>
+#include <dllib/sequential.hpp>
+
+#include <iostream>
+#include <memory>
+
+#include "helpers.hpp"
+
+using namespace dllib;
+
+constexpr size_t Batch = 16, In = 16, Hidden = 32, Out = 4, Steps = 20000;
+
+using TInput = TTensor<float, Batch, In>;
+using TOutput = TTensor<float, Batch, Out>;
+using TModel = Sequential<
+  TInput,
+  FullyConnected<float, In, Hidden>,
+  ReLUActivation,
+  LayerNorm<float, Hidden>,
+  FullyConnected<float, Hidden, Out>>;
+
+template<class TFunction>
+double StepsPerSecond(TFunction&& step) {
+  return 1000 / example_helpers::MillisecondsPerStep(Steps, step);
+}
+
+int main() {
+  auto model = std::make_unique<TModel>();
+  auto optimizer = MakeOptimizerManager<TSGDOptimizerUnit>(1e-3f);
+  optimizer.AddParameter(*model);
+
+  auto x = std::make_unique<TInput>();
+  auto expected = std::make_unique<TOutput>(0);
+  auto gen = helpers::GetNormalGenerator<float>();
+  for (auto& v : x->View<-1u>()) {
+    v = gen();
+  }
+
+  //  A node per layer and per loss term, as the layers are chained by hand
+  auto layers = [&] {
+    auto& m = *model;
+    auto hidden = m.GetLayer<2>()(m.GetLayer<1>()(m.GetLayer<0>()(TVariable(*x, false))));
+    auto diff = m.GetLayer<3>()(hidden) - TVariable(*expected, false);
+    Sum(diff * diff)->Backward();
+    optimizer.Step();
+  };
+
+  //  Preallocated activations, the loss gradient is written by hand
+  auto grad = std::make_unique<TOutput>();
+  auto sequential = [&] {
+    const auto& result = model->Forward(*x);
+    *grad = (result - *expected) * 2.f;
+    model->Backward(*grad);
+    optimizer.Step();
+  };
+
+  std::cout << "steps/s" << std::endl;
+  std::cout << "layers:      " << StepsPerSecond(layers) << std::endl;
+  std::cout << "sequential:  " << StepsPerSecond(sequential) << std::endl;
+}
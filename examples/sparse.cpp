@@ -0,0 +1,33 @@
+#include <dllib/sparse.hpp>
+
+#include <iostream>
+#include <memory>
+
+#include "helpers.hpp"
+
+using namespace dllib;
+
+constexpr size_t Batch = 32, From = 512, To = 512, Steps = 50;
+
+using TInput = TTensor<float, Batch, From>;
+using TDense = FullyConnected<float, From, To>;
+using TSparse = BlockSparseFullyConnected<float, From, To, 4, 4>;
+
+using example_helpers::Measure;
+
+int main() {
+  auto dense = std::make_unique<TDense>();
+  auto x = std::make_unique<TInput>();
+  auto gen = helpers::GetNormalGenerator<float>();
+  for (auto& v : x->View<-1u>()) {
+    v = gen();
+  }
+
+  Measure("dense:        ", *dense, *x, Steps);
+  for (double sparsity : {0.5, 0.8, 0.9}) {
+    auto sparse = std::make_unique<TSparse>(*dense);
+    sparse->Prune(sparsity);
+    std::cout << "sparsity " << sparsity << ":  ";
+    Measure("", *sparse, *x, Steps);
+  }
+}
@@ -0,0 +1,116 @@
+#include "allocation_counter.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+//  The replacement functions live in a translation unit of their own, so the compiler can't inline
+//  them next to new-expressions and mistake the malloc and free inside for a mismatched pair
+
+namespace test_helpers {
+
+namespace {
+
+thread_local TAllocationCounter* active_counter = nullptr;
+
+//  Every block starts with a header of at least the default new alignment, its size is stored right
+//  before the pointer handed out
+constexpr size_t HeaderBytes = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+void* Allocate(size_t size, size_t header) {
+  TAllocationCounter::RecordAllocation(size);
+  size_t total = (header + size + header - 1) / header * header;
+  auto* block = static_cast<std::byte*>(header > HeaderBytes ? std::aligned_alloc(header, total) : std::malloc(total));
+  if (!block) {
+    throw std::bad_alloc();
+  }
+  auto* ptr = block + header;
+  reinterpret_cast<size_t*>(ptr)[-1] = size;
+  return ptr;
+}
+
+void Release(void* ptr, size_t header) {
+  if (!ptr) {
+    return;
+  }
+  TAllocationCounter::RecordRelease(static_cast<size_t*>(ptr)[-1]);
+  std::free(static_cast<std::byte*>(ptr) - header);
+}
+
+}  // namespace
+
+TAllocationCounter::TAllocationCounter() : previous_(active_counter) {
+  active_counter = this;
+}
+
+TAllocationCounter::~TAllocationCounter() {
+  active_counter = previous_;
+}
+
+void TAllocationCounter::RecordAllocation(size_t bytes) {
+  if (auto* counter = active_counter) {
+    ++counter->count_;
+    counter->live_bytes_ += ptrdiff_t(bytes);
+    counter->peak_bytes_ = std::max(counter->peak_bytes_, counter->live_bytes_);
+  }
+}
+
+void TAllocationCounter::RecordRelease(size_t bytes) {
+  if (auto* counter = active_counter) {
+    counter->live_bytes_ -= ptrdiff_t(bytes);
+  }
+}
+
+}  // namespace test_helpers
+
+using test_helpers::Allocate;
+using test_helpers::HeaderBytes;
+using test_helpers::Release;
+
+void* operator new(size_t size) {
+  return Allocate(size, HeaderBytes);
+}
+
+void* operator new[](size_t size) {
+  return Allocate(size, HeaderBytes);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+  return Allocate(size, std::max(static_cast<size_t>(alignment), HeaderBytes));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+  return Allocate(size, std::max(static_cast<size_t>(alignment), HeaderBytes));
+}
+
+void operator delete(void* ptr) noexcept {
+  Release(ptr, HeaderBytes);
+}
+
+void operator delete[](void* ptr) noexcept {
+  Release(ptr, HeaderBytes);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  Release(ptr, HeaderBytes);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+  Release(ptr, HeaderBytes);
+}
+
+void operator delete(void* ptr, std::align_val_t alignment) noexcept {
+  Release(ptr, std::max(static_cast<size_t>(alignment), HeaderBytes));
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept {
+  Release(ptr, std::max(static_cast<size_t>(alignment), HeaderBytes));
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t alignment) noexcept {
+  Release(ptr, std::max(static_cast<size_t>(alignment), HeaderBytes));
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t alignment) noexcept {
+  Release(ptr, std::max(static_cast<size_t>(alignment), HeaderBytes));
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+
+namespace test_helpers {
+
+//  Counts the calls of operator new made by the current thread while the counter is alive, and the bytes
+//  they hold. Counting needs the replacement operator new of allocation_counter.cpp, which is linked into
+//  the allocation tests only, so the rest of the tests run with the default allocator. Nested counters
+//  don't see the allocations made while an inner one is alive
+class TAllocationCounter {
+ public:
+  TAllocationCounter();
+  ~TAllocationCounter();
+
+  TAllocationCounter(const TAllocationCounter&) = delete;
+  TAllocationCounter& operator=(const TAllocationCounter&) = delete;
+
+  [[nodiscard]] size_t Count() const {
+    return count_;
+  }
+
+  //  Bytes allocated and not freed yet. Freeing memory allocated before the counter subtracts too, so
+  //  the balance may be negative
+  [[nodiscard]] ptrdiff_t GetLiveBytes() const {
+    return live_bytes_;
+  }
+
+  //  Maximum of the live bytes over the lifetime of the counter
+  [[nodiscard]] ptrdiff_t GetPeakBytes() const {
+    return peak_bytes_;
+  }
+
+  //  Called by the replacement operator new and operator delete
+  static void RecordAllocation(size_t bytes);
+  static void RecordRelease(size_t bytes);
+
+ private:
+  TAllocationCounter* previous_;
+  size_t count_ = 0;
+  ptrdiff_t live_bytes_ = 0;
+  ptrdiff_t peak_bytes_ = 0;
+};
+
+}  // namespace test_helpers
@@ -0,0 +1,34 @@
+#include <boost/ut.hpp>
+#include <dllib/fused_optimizer.hpp>
+#include <dllib/layer.hpp>
+
+#include <memory>
+
+#include "allocation_counter.hpp"
+
+namespace ut = boost::ut;
+
+static ut::suite fused_optimizer_allocation_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  "fused_step_does_not_allocate"_test = [] {
+    //  The weights span two chunks of the step
+    FullyConnected<float, 20, 30> layer;
+    auto optimizer = MakeFusedOptimizer<TFusedAdam>(1e-3f);
+    optimizer.AddParameter(layer);
+    auto& weights = get<0>(layer.GetParameters());
+
+    size_t allocations = 0;
+    {
+      test_helpers::TAllocationCounter counter;
+      for (size_t step = 0; step < 10; ++step) {
+        weights->grad[step % 20][step % 30] += 1.f;
+        optimizer.Step();
+      }
+      allocations = counter.Count();
+    }
+    expect(eq(allocations, 0u));
+    expect(weights->grad[1][1].Data() == 0.f);
+  };
+};
@@ -0,0 +1,34 @@
+#include <boost/ut.hpp>
+#include <dllib/graph.hpp>
+#include <dllib/layer.hpp>
+
+#include "allocation_counter.hpp"
+
+namespace ut = boost::ut;
+
+static ut::suite graph_allocation_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  "replay_does_not_allocate"_test = [] {
+    FullyConnected<float, 3, 2> fc;
+    TVariable<TTensor<float, 4, 3>> inp(false);
+    TVariable<TTensor<float, 4, 2>> expected(false);
+
+    TStaticGraph graph;
+    graph.Capture([&fc, &inp, &expected] {
+      auto diff = expected - fc(DropOut(inp));
+      return Sum(diff * diff);
+    });
+
+    inp->value = TTensor<float, 4, 3>(0.5);
+    expected->value = TTensor<float, 4, 2>(1);
+    size_t allocations = 0;
+    {
+      test_helpers::TAllocationCounter counter;
+      graph.Replay();
+      allocations = counter.Count();
+    }
+    expect(eq(allocations, 0u));
+  };
+};
@@ -0,0 +1,52 @@
+#include <boost/ut.hpp>
+#include <dllib/memory_plan.hpp>
+
+#include "allocation_counter.hpp"
+
+namespace ut = boost::ut;
+
+static ut::suite memory_plan_allocation_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  "planned_graph_holds_less"_test = [] {
+    using TMatrix = TTensor<float, 32, 32>;
+    TVariable<TMatrix> x(TMatrix(0.5f), true);
+
+    auto build = [&x] {
+      TVariable<TMatrix> y = x;
+      for (size_t i = 0; i < 16; ++i) {
+        y = Tanh(y);
+      }
+      return Sum(y);
+    };
+
+    //  Replays don't allocate, so the bytes a graph holds after capture are its peak over the steps
+    ptrdiff_t captured = 0;
+    ptrdiff_t planned = 0;
+    TStaticGraph static_graph;
+    TPlannedGraph planned_graph;
+    {
+      test_helpers::TAllocationCounter counter;
+      static_graph.Capture(build);
+      captured = counter.GetLiveBytes();
+    }
+    {
+      test_helpers::TAllocationCounter counter;
+      planned_graph.Capture(build);
+      planned = counter.GetLiveBytes();
+    }
+    {
+      test_helpers::TAllocationCounter counter;
+      planned_graph.Replay();
+      expect(eq(counter.Count(), 0u));
+    }
+
+    //  Every Tanh keeps its output for backward, but the gradients of the chain take two slots instead
+    //  of one per node, which is most of the 16 gradients saved after paying for the bookkeeping
+    expect(ge(captured, ptrdiff_t(2 * 16 * sizeof(TMatrix))));
+    expect(ge(captured - planned, ptrdiff_t(12 * sizeof(TMatrix))));
+    expect(lt(planned, captured * 2 / 3));
+    expect(ge(planned, ptrdiff_t(planned_graph.GetPlan().planned_bytes)));
+  };
+};
@@ -0,0 +1,34 @@
+#include <boost/ut.hpp>
+#include <dllib/layer.hpp>
+
+#include "allocation_counter.hpp"
+
+namespace ut = boost::ut;
+
+static ut::suite no_grad_allocation_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  "no_grad_inference_does_not_allocate"_test = [] {
+    FullyConnected<float, 3, 5> first;
+    FullyConnected<float, 5, 2> second;
+    TVariable<TTensor<float, 4, 3>> inp(TTensor<float, 4, 3>(0.5), false);
+
+    TNoGradGuard guard;
+    auto run = [&] {
+      return Sum(Tanh(second(DropOut(Sigmoid(first(inp))))))->value.Data();
+    };
+    float expected = run();
+    float result = 0;
+    size_t allocations = 0;
+    {
+      test_helpers::TAllocationCounter counter;
+      for (size_t i = 0; i < 10; ++i) {
+        result = run();
+      }
+      allocations = counter.Count();
+    }
+    expect(eq(allocations, 0u));
+    expect(eq(result, expected));
+  };
+};
@@ -0,0 +1,44 @@
+#include <boost/ut.hpp>
+#include <dllib/sequential.hpp>
+
+#include <memory>
+
+#include "allocation_counter.hpp"
+
+namespace ut = boost::ut;
+
+static ut::suite sequential_allocation_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  "sequential_steps_do_not_allocate"_test = [] {
+    using TInput = TTensor<float, 4, 3>;
+    using TModel = Sequential<
+      TInput,
+      FullyConnected<float, 3, 5>,
+      TanhActivation,
+      LayerNorm<float, 5>,
+      FullyConnected<float, 5, 4>,
+      ReLUActivation,
+      BatchNorm<float, 4>,
+      FullyConnected<float, 4, 2>,
+      SigmoidActivation>;
+
+    auto model = std::make_unique<TModel>();
+    auto x = std::make_unique<TInput>(0.5f);
+    auto x_grad = std::make_unique<TInput>(0.f);
+    auto grad = std::make_unique<TTensor<float, 4, 2>>(1.f);
+
+    size_t allocations = 0;
+    {
+      test_helpers::TAllocationCounter counter;
+      for (size_t step = 0; step < 10; ++step) {
+        (*x)[step % 4][step % 3] += 0.25f;
+        model->Forward(*x);
+        model->Backward(*grad, x_grad.get());
+      }
+      allocations = counter.Count();
+    }
+    expect(eq(allocations, 0u));
+  };
+};
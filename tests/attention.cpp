@@ -0,0 +1,124 @@
+#include <boost/ut.hpp>
+#include <dllib/attention.hpp>
+
+#include <cmath>
+#include <random>
+
+#include "helpers.hpp"
+
+namespace ut = boost::ut;
+
+using test_helpers::Randomize;
+using test_helpers::MatchesNumericGradient;
+
+namespace {
+
+constexpr size_t Batch = 2, Seq = 7, KeySeq = 5, Dim = 3, ValueDim = 4;
+
+//  The whole score matrix at once, straight from the definition
+template<class TData, size_t Batch, size_t Seq, size_t KeySeq, size_t Dim, size_t ValueDim>
+dllib::TTensor<TData, Batch, Seq, ValueDim> NaiveAttention(
+  const dllib::TTensor<TData, Batch, Seq, Dim>& q,
+  const dllib::TTensor<TData, Batch, KeySeq, Dim>& k,
+  const dllib::TTensor<TData, Batch, KeySeq, ValueDim>& v) {
+
+  dllib::TTensor<TData, Batch, Seq, ValueDim> result(0);
+  for (size_t b = 0; b < Batch; ++b) {
+    for (size_t i = 0; i < Seq; ++i) {
+      TData scores[KeySeq];
+      TData exp_sum = 0;
+      for (size_t j = 0; j < KeySeq; ++j) {
+        scores[j] = 0;
+        for (size_t d = 0; d < Dim; ++d) {
+          scores[j] += q[b][i][d] * k[b][j][d] / std::sqrt(TData(Dim));
+        }
+        exp_sum += scores[j] = std::exp(scores[j]);
+      }
+      for (size_t j = 0; j < KeySeq; ++j) {
+        for (size_t d = 0; d < ValueDim; ++d) {
+          result[b][i][d] += scores[j] / exp_sum * v[b][j][d];
+        }
+      }
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+static ut::suite attention_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  "attention_forward"_test = [] {
+    std::mt19937 gen(1);
+    TTensor<double, Batch, Seq, Dim> q;
+    TTensor<double, Batch, KeySeq, Dim> k;
+    TTensor<double, Batch, KeySeq, ValueDim> v;
+    Randomize(q, gen);
+    Randomize(k, gen);
+    Randomize(v, gen);
+
+    auto expected = NaiveAttention(q, k, v);
+    //  Tiles which don't divide the sequences, a single key tile and a single tile for everything
+    expect(AllClose(ScaledDotProductAttention<2>(q, k, v), expected, 1e-12));
+    expect(AllClose(ScaledDotProductAttention<5>(q, k, v), expected, 1e-12));
+    expect(AllClose(ScaledDotProductAttention(q, k, v), expected, 1e-12));
+    auto variable = ScaledDotProductAttention<3>(TVariable(q, false), TVariable(k, false), TVariable(v, false));
+    expect(AllClose(variable->value, expected, 1e-12));
+  };
+
+  "attention_is_stable"_test = [] {
+    //  Scores grow along the keys, so the running maximum is replaced in every tile
+    TTensor<float, 1, 1, 1> q = {{{100}}};
+    TTensor<float, 1, 4, 1> k = {{{1}, {2}, {3}, {4}}};
+    TTensor<float, 1, 4, 1> v = {{{0}, {0}, {0}, {1}}};
+    auto result = ScaledDotProductAttention<1>(q, k, v);
+    expect(lt(std::abs(result[0][0][0] - 1), 1e-6));
+  };
+
+  "attention_backward"_test = [] {
+    std::mt19937 gen(2);
+    TVariable<TTensor<double, Batch, Seq, Dim>> q(true);
+    TVariable<TTensor<double, Batch, KeySeq, Dim>> k(true);
+    TVariable<TTensor<double, Batch, KeySeq, ValueDim>> v(true);
+    TTensor<double, Batch, Seq, ValueDim> weights;
+    Randomize(q->value, gen);
+    Randomize(k->value, gen);
+    Randomize(v->value, gen);
+    Randomize(weights, gen);
+
+    auto loss = [&] {
+      return Sum(ScaledDotProductAttention<2>(q, k, v) * TVariable(weights, false));
+    };
+    auto loss_value = [&loss] {
+      TNoGradGuard guard;
+      return double(loss()->value);
+    };
+
+    loss()->Backward();
+    expect(MatchesNumericGradient(loss_value, q));
+    expect(MatchesNumericGradient(loss_value, k));
+    expect(MatchesNumericGradient(loss_value, v));
+  };
+
+  "self_attention_backward"_test = [] {
+    std::mt19937 gen(3);
+    TVariable<TTensor<double, 1, Seq, Dim>> x(true);
+    TTensor<double, 1, Seq, Dim> weights;
+    Randomize(x->value, gen);
+    Randomize(weights, gen);
+
+    //  All three arguments are the same node, their gradients add up
+    auto loss = [&] {
+      return Sum(ScaledDotProductAttention<4>(x, x, x) * TVariable(weights, false));
+    };
+    auto loss_value = [&loss] {
+      TNoGradGuard guard;
+      return double(loss()->value);
+    };
+
+    loss()->Backward();
+    expect(MatchesNumericGradient(loss_value, x));
+  };
+};
@@ -3,6 +3,8 @@
 
 #include <boost/ut.hpp>
 
+#include <thread>
+
 namespace ut = boost::ut;
 
 static ut::suite autograd = [] {
@@ -387,4 +389,132 @@ static ut::suite autograd = [] {
     expect(AllClose(v->grad, expected));
 
   };
+
+  "no_grad_guard"_test = [] {
+    TVariable<TTensor<float, 2, 2>> v({{1, 2}, {3, 4}}, true);
+    {
+      TNoGradGuard guard;
+      expect(eq(IsGradEnabled(), false));
+
+      auto sm = Sum(Tanh(v * v + v));
+      expect(eq(sm.IsLeaf(), true) && eq(sm->requires_grad, false));
+      expect(AllClose(sm->value, TTensor<float>(Sum(Tanh(v->value * v->value + v->value)))));
+      {
+        TNoGradGuard nested;
+      }
+      expect(eq(IsGradEnabled(), false));
+    }
+    expect(eq(IsGradEnabled(), true));
+
+    auto sm = Sum(v * v);
+    expect(eq(sm.IsLeaf(), false) && eq(sm->requires_grad, true));
+    sm->Backward();
+    expect(eq(v->grad, TTensor<float, 2, 2>({{2, 4}, {6, 8}})));
+  };
+
+  "no_grad_result_outlives_free_list"_test = [] {
+    float value = 0;
+    std::thread([&value] {
+      //  Made before the free list of the thread, so it is released after the list is destroyed
+      thread_local TVariable<TTensor<float, 3>> held;
+      TNoGradGuard guard;
+      TVariable<TTensor<float, 3>> x({1, 2, 3}, false);
+      held = x + x;
+      value = float(held->value[2]);
+    }).join();
+    expect(eq(value, 6.f));
+  };
+
+  "inplace"_test = [] {
+    TVariable<TTensor<float, 2>> acc({1, 2}, false);
+    TVariable<TTensor<float, 2>> v({3, 4}, false);
+    auto* node = acc.get();
+
+    AddInplace(acc, v);
+    MulInplace(acc, v);
+    SubInplace(acc, v);
+    TanhInplace(acc);
+    expect(eq(acc.get(), node) && eq(acc->version, 4u));
+    expect(AllClose(acc->value, Tanh(TTensor<float, 2>({9, 20}))));
+
+    TVariable<TTensor<float, 2>> w({1, 1}, true);
+    AddInplace(acc, w);
+    expect(neq(acc.get(), node) && eq(acc->requires_grad, true));
+    Sum(acc)->Backward();
+    expect(eq(w->grad, TTensor<float, 2>(1)));
+
+    expect(throws([&w, &v] {
+      AddInplace(w, v);
+    }));
+    {
+      TNoGradGuard guard;
+      SigmoidInplace(w);
+    }
+    expect(AllClose(w->value, Sigmoid(TTensor<float, 2>(1))));
+  };
+
+  "inplace_version_check"_test = [] {
+    TVariable<TTensor<float, 2>> w({1, 2}, true);
+    TVariable<TTensor<float, 2>> x({3, 4}, false);
+    TVariable<TTensor<float, 2>> y({5, 6}, false);
+
+    auto ok = Sum(x + w);
+    AddInplace(x, y);
+    expect(nothrow([&ok] {
+      ok->Backward();
+    }));
+
+    auto saved = Sum(x * w);
+    AddInplace(x, y);
+    expect(throws<std::runtime_error>([&saved] {
+      saved->Backward();
+    }));
+  };
+
+  "inplace_in_graph"_test = [] {
+    TVariable<TTensor<float, 2>> w({1, 2}, true);
+    TVariable<TTensor<float, 2>> u({3, 4}, true);
+    TVariable<TTensor<float, 2>> c({5, 6}, false);
+
+    auto acc = w * c;
+    auto* node = acc.get();
+    AddInplace(acc, u);
+    SubInplace(acc, w);
+    expect(eq(acc.get(), node) && eq(acc->version, 2u));
+    expect(eq(acc->value, TTensor<float, 2>({7, 14})));
+    Sum(acc * acc)->Backward();
+    expect(AllClose(w->grad, TTensor<float, 2>({56, 140})));
+    expect(AllClose(u->grad, TTensor<float, 2>({14, 28})));
+
+    //  Tanh reads its own value in Backward
+    auto activated = Tanh(w);
+    node = activated.get();
+    AddInplace(activated, u);
+    expect(neq(activated.get(), node));
+
+    //  The value of a node used by another one is still needed as it is
+    auto product = w * c;
+    auto square = product * product;
+    node = product.get();
+    AddInplace(product, u);
+    expect(neq(product.get(), node) && eq(node->version, 0u));
+  };
+
+  "inplace_self"_test = [] {
+    TVariable<TTensor<float, 2>> w({1, 2}, true);
+
+    auto x = w * w;
+    auto* node = x.get();
+    AddInplace(x, x);
+    expect(neq(x.get(), node));
+    Sum(x)->Backward();
+    expect(AllClose(w->grad, TTensor<float, 2>({4, 8})));
+
+    w->ZeroGrad();
+    auto y = w * w;
+    SubInplace(y, y);
+    expect(eq(y->value, TTensor<float, 2>(0)));
+    Sum(y)->Backward();
+    expect(AllClose(w->grad, TTensor<float, 2>(0)));
+  };
 };
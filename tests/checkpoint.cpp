@@ -0,0 +1,111 @@
+#include <boost/ut.hpp>
+#include <dllib/checkpoint.hpp>
+#include <dllib/normalization.hpp>
+
+#include <array>
+
+namespace ut = boost::ut;
+
+static ut::suite checkpoint_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  using TInput = TTensor<float, 3, 4>;
+
+  "intermediate_values_are_dropped"_test = [] {
+    TVariable<TInput> x(TInput(.5), true);
+    std::weak_ptr<IVariable<TInput>> intermediate;
+
+    auto out = Checkpoint([&intermediate](const TVariable<TInput>& v) {
+      auto tanh = Tanh(v);
+      intermediate = tanh;
+      return tanh * tanh;
+    }, x);
+    expect(eq(intermediate.expired(), true));
+    expect(AllClose(out->value, Tanh(x->value) * Tanh(x->value)));
+
+    Sum(out)->Backward();
+    auto t = Tanh(x->value);
+    expect(AllClose(x->grad, 2 * t * (1 - t * t)));
+  };
+
+  "deep_mlp_gradients_match"_test = [] {
+    constexpr size_t depth = 16;
+
+    auto run = [](bool checkpointed) {
+      helpers::entropy.seed(42);
+      std::mt19937 gen(17);
+      auto normal = [&gen, dist = std::normal_distribution<float>{}]() mutable {
+        return dist(gen);
+      };
+
+      std::array<FullyConnected<float, 4, 4>, depth> layers;
+      for (auto& layer : layers) {
+        layer = FullyConnected<float, 4, 4>(std::ref(normal));
+      }
+      auto step = [&layers](size_t i, TVariable<TInput> x) {
+        return Tanh(layers[i](DropOut(x, .25)));
+      };
+
+      TInput inp;
+      for (auto& x : inp.View<-1u>()) {
+        x = normal();
+      }
+      TVariable<TInput> x(inp, true);
+
+      TVariable<TInput> out = x;
+      if (checkpointed) {
+        out = CheckpointSequential(step, depth, x);
+      } else {
+        for (size_t i = 0; i < depth; ++i) {
+          out = step(i, out);
+        }
+      }
+      Sum(out * out)->Backward();
+
+      std::vector<TTensor<float, 4, 4>> grads;
+      for (auto& layer : layers) {
+        grads.push_back(get<0>(layer.GetParameters())->grad);
+      }
+      return std::make_tuple(out->value, x->grad, grads);
+    };
+
+    auto [plain_out, plain_input_grad, plain_grads] = run(false);
+    auto [out, input_grad, grads] = run(true);
+    expect(eq(out, plain_out));
+    expect(eq(input_grad, plain_input_grad));
+    expect(eq(grads == plain_grads, true));
+  };
+
+  "batch_norm_statistics_update_once"_test = [] {
+    TInput x = {{1, 2, 3, 4}, {0, 1, 0, 1}, {5, -5, 2, 2}};
+    BatchNorm<float, 4> plain;
+    BatchNorm<float, 4> checkpointed;
+
+    Sum(Tanh(plain(TVariable(x, true))))->Backward();
+    Sum(Tanh(Checkpoint([&checkpointed](const TVariable<TInput>& inp) {
+      return checkpointed(inp);
+    }, TVariable(x, true))))->Backward();
+
+    expect(AllClose(checkpointed.GetRunningMean(), plain.GetRunningMean()));
+    expect(AllClose(checkpointed.GetRunningVariance(), plain.GetRunningVariance()));
+  };
+
+  "failed_recompute_restores_state"_test = [] {
+    size_t calls = 0;
+    auto out = Checkpoint([&calls](const TVariable<TInput>& inp) {
+      helpers::entropy();
+      if (++calls == 2) {
+        throw std::runtime_error("recompute failed");
+      }
+      return Tanh(inp);
+    }, TVariable(TInput(1.f), true));
+
+    auto entropy = helpers::entropy;
+    expect(throws<std::runtime_error>([&out] {
+      Sum(out)->Backward();
+    }));
+    expect(eq(helpers::checkpoint_recompute_enabled, false));
+    expect(helpers::entropy == entropy);
+  };
+};
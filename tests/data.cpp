@@ -0,0 +1,86 @@
+#include <boost/ut.hpp>
+#include <dllib/data.hpp>
+
+#include <filesystem>
+#include <vector>
+
+#include <unistd.h>
+
+namespace ut = boost::ut;
+
+constexpr size_t Samples = 20, Features = 3;
+
+static ut::suite data_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  auto path = (std::filesystem::temp_directory_path() / ("dllib-data-" + std::to_string(getpid()))).string();
+
+  //  Sample i has features {i, 2i, 3i} and target -i
+  auto write = [path] {
+    TDatasetWriter<Features> writer(path);
+    for (size_t i = 0; i < Samples; ++i) {
+      float x = float(i);
+      writer.Add({x, 2 * x, 3 * x}, TTensor<float, 1>{-x});
+    }
+  };
+
+  "mapped_dataset"_test = [path, write] {
+    write();
+    TMappedDataset<Features> dataset(path);
+    expect(eq(dataset.Size(), Samples));
+    expect(dataset.GetFeatures(7) == TTensor<float, Features>{7, 14, 21});
+    expect(eq(float(dataset.GetTargets(19)[0]), -19.f));
+
+    expect(throws([&path] { TMappedDataset<Features + 1> wrong(path); }));
+    expect(throws([&path] { TMappedDataset<Features, 2> wrong(path); }));
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    expect(throws([&path] { TMappedDataset<Features> truncated(path); }));
+    expect(throws([] { TMappedDataset<Features> missing("/nonexistent/dataset"); }));
+    std::filesystem::remove(path);
+  };
+
+  "batch_loader_in_order"_test = [path, write] {
+    write();
+    TMappedDataset<Features> dataset(path);
+    TBatchLoader<8, Features> loader(dataset, /*shuffle=*/false);
+
+    //  The third batch wraps around into the second epoch
+    std::vector<float> seen;
+    for (size_t i = 0; i < 3; ++i) {
+      const auto& batch = loader.Next();
+      for (size_t b = 0; b < 8; ++b) {
+        seen.push_back(batch.features[b][0]);
+      }
+    }
+    for (size_t i = 0; i < seen.size(); ++i) {
+      expect(eq(seen[i], float(i % Samples)));
+    }
+    expect(ge(loader.Epoch(), 2u));
+    std::filesystem::remove(path);
+  };
+
+  "batch_loader_shuffles_epochs"_test = [path, write] {
+    write();
+    TMappedDataset<Features> dataset(path);
+    TBatchLoader<4, Features> loader(dataset, /*shuffle=*/true, /*seed=*/5);
+
+    std::vector<size_t> count(Samples);
+    std::vector<float> order;
+    bool consistent = true;
+    for (size_t i = 0; i < Samples / 4; ++i) {
+      const auto& batch = loader.Next();
+      for (size_t b = 0; b < 4; ++b) {
+        float x = batch.features[b][0];
+        consistent = consistent && float(batch.features[b][2]) == 3 * x && float(batch.targets[b][0]) == -x;
+        ++count[size_t(x)];
+        order.push_back(x);
+      }
+    }
+    expect(consistent);
+    //  Every sample exactly once per epoch, but not in the order of the file
+    expect(std::all_of(count.begin(), count.end(), [](size_t c) { return c == 1; }));
+    expect(!std::is_sorted(order.begin(), order.end()));
+    std::filesystem::remove(path);
+  };
+};
@@ -0,0 +1,107 @@
+#include <boost/ut.hpp>
+#include <dllib/data_parallel.hpp>
+#include <dllib/layer.hpp>
+
+#include <random>
+
+namespace ut = boost::ut;
+
+namespace {
+
+constexpr size_t In = 3, Hidden = 5, Out = 2;
+
+struct TModel {
+  auto operator()(const auto& x) {
+    return second(Tanh(first(x)));
+  }
+
+  auto GetParameters() {
+    return std::tie(first, second);
+  }
+
+  dllib::FullyConnected<float, In, Hidden> first;
+  dllib::FullyConnected<float, Hidden, Out> second;
+};
+
+}  // namespace
+
+static ut::suite data_parallel_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  "matches_large_batch"_test = [] {
+    constexpr size_t Shards = 4, Shard = 4, Batch = Shards * Shard;
+
+    std::mt19937 gen(3);
+    std::normal_distribution<float> dist;
+    TTensor<float, Batch, In> inp;
+    TTensor<float, Batch, Out> expected;
+    for (auto& x : inp.View<-1u>()) {
+      x = dist(gen);
+    }
+    for (auto& x : expected.View<-1u>()) {
+      x = dist(gen);
+    }
+
+    TModel model;
+    TModel reference = helpers::MakeReplica(model);
+
+    auto diff = reference(TVariable(inp, false)) - TVariable(expected, false);
+    Sum(diff * diff)->Backward();
+
+    TThreadPool pool(3);
+    TDataParallel parallel(model, pool, Shards);
+    parallel.Backward([&inp, &expected](TModel& replica, size_t shard) {
+      TTensor<float, Shard, In> shard_inp;
+      TTensor<float, Shard, Out> shard_expected;
+      for (size_t i = 0; i < Shard; ++i) {
+        shard_inp[i] = inp[shard * Shard + i];
+        shard_expected[i] = expected[shard * Shard + i];
+      }
+      auto diff = replica(TVariable(shard_inp, false)) - TVariable(shard_expected, false);
+      return Sum(diff * diff);
+    });
+
+    size_t count = 0;
+    ForEachParameter([&count](auto& actual, auto& expected) {
+      ++count;
+      expect(AllClose(actual->grad, expected->grad, 1e-4));
+    }, model, reference);
+    expect(eq(count, 4u));
+
+    //  One optimizer step on the model, the replicas pick up the new values on the next Backward
+    auto optimizer = MakeOptimizerManager<TSGDOptimizerUnit>(0.1f);
+    optimizer.AddParameter(model);
+    optimizer.Step();
+    parallel.Backward([](TModel& replica, size_t) {
+      return Sum(replica(TVariable(TTensor<float, 1, In>(0.f), false)));
+    });
+    auto [weights, bias] = model.second.GetParameters();
+    expect(AllClose(get<0>(bias.GetParameters())->grad, TTensor<float, Out>(float(Shards))));
+  };
+
+  "step_exception"_test = [] {
+    TModel model;
+    TThreadPool pool(2);
+    TDataParallel parallel(model, pool, 4);
+    auto step = [](TModel& replica, size_t shard) {
+      auto loss = Sum(replica(TVariable(TTensor<float, 1, In>(1.f), false)));
+      if (shard == 2) {
+        throw std::runtime_error("step failed");
+      }
+      return loss;
+    };
+    expect(throws<std::runtime_error>([&parallel, &step] {
+      parallel.Backward(step);
+    }));
+    ForEachParameter([](auto& var) {
+      expect(AllClose(var->grad, std::remove_cvref_t<decltype(var->grad)>(0.f)));
+    }, model);
+
+    parallel.Backward([](TModel& replica, size_t) {
+      return Sum(replica(TVariable(TTensor<float, 1, In>(0.f), false)));
+    });
+    auto [weights, bias] = model.second.GetParameters();
+    expect(AllClose(get<0>(bias.GetParameters())->grad, TTensor<float, Out>(4.f)));
+  };
+};
@@ -0,0 +1,157 @@
+#include <boost/ut.hpp>
+#include <dllib/distributed.hpp>
+#include <dllib/layer.hpp>
+
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <thread>
+
+#include <unistd.h>
+
+namespace ut = boost::ut;
+
+namespace {
+
+constexpr size_t In = 3, Hidden = 4, Out = 2;
+
+struct TModel {
+  auto operator()(const auto& x) {
+    return second(Tanh(first(x)));
+  }
+
+  auto GetParameters() {
+    return std::tie(first, second);
+  }
+
+  dllib::FullyConnected<float, In, Hidden> first;
+  dllib::FullyConnected<float, Hidden, Out> second;
+};
+
+//  Runs `function(transport)` on `size` threads playing the ranks
+template<class TFunction>
+void RunRanks(bool shared_memory, size_t size, TFunction function) {
+  static size_t session = 0;
+  std::string name = "dllib-" + std::to_string(getpid()) + "-" + std::to_string(session++);
+  auto directory = std::filesystem::temp_directory_path() / name;
+  if (!shared_memory) {
+    std::filesystem::create_directory(directory);
+  }
+
+  std::vector<std::jthread> ranks;
+  for (size_t rank = 0; rank < size; ++rank) {
+    ranks.emplace_back([=] {
+      std::unique_ptr<dllib::ITransport> transport;
+      if (shared_memory) {
+        transport = std::make_unique<dllib::TSharedMemoryTransport>("/" + name, rank, size, 64);
+      } else {
+        transport = std::make_unique<dllib::TUnixSocketTransport>(directory.string(), rank, size);
+      }
+      function(*transport);
+    });
+  }
+  ranks.clear();
+  std::filesystem::remove_all(directory);
+}
+
+}  // namespace
+
+static ut::suite distributed_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  for (bool shared_memory : {false, true}) {
+    "ring_all_reduce"_test = [shared_memory] {
+      constexpr size_t Size = 3, Length = 1001;
+      std::vector<std::vector<float>> results(Size);
+      RunRanks(shared_memory, Size, [&results](ITransport& transport) {
+        std::vector<float> data(Length);
+        for (size_t i = 0; i < Length; ++i) {
+          data[i] = float(i * (transport.Rank() + 1));
+        }
+        RingAllReduce(transport, std::span(data));
+        results[transport.Rank()] = std::move(data);
+      });
+
+      for (const auto& result : results) {
+        expect(eq(result.size(), Length));
+        bool all_equal = true;
+        for (size_t i = 0; i < Length; ++i) {
+          all_equal = all_equal && result[i] == float(i * 6);
+        }
+        expect(all_equal);
+      }
+    };
+
+    "distributed_data_parallel"_test = [shared_memory] {
+      constexpr size_t Size = 2, Shard = 3, Batch = Size * Shard;
+
+      std::mt19937 gen(11);
+      std::normal_distribution<float> dist;
+      TTensor<float, Batch, In> inp;
+      TTensor<float, Batch, Out> expected;
+      for (auto& x : inp.View<-1u>()) {
+        x = dist(gen);
+      }
+      for (auto& x : expected.View<-1u>()) {
+        x = dist(gen);
+      }
+
+      TModel reference;
+      std::vector<TModel> models;
+      for (size_t rank = 0; rank < Size; ++rank) {
+        models.push_back(helpers::MakeReplica(reference));
+      }
+      auto diff = reference(TVariable(inp, false)) - TVariable(expected, false);
+      Sum(diff * diff)->Backward();
+
+      std::vector<size_t> bucket_counts(Size);
+      RunRanks(shared_memory, Size, [&](ITransport& transport) {
+        auto& model = models[transport.Rank()];
+        //  Small buckets, so there are several of them
+        TDistributedDataParallel<TModel> parallel(model, transport, 12 * sizeof(float));
+        bucket_counts[transport.Rank()] = parallel.BucketCount();
+
+        TTensor<float, Shard, In> shard_inp;
+        TTensor<float, Shard, Out> shard_expected;
+        for (size_t i = 0; i < Shard; ++i) {
+          shard_inp[i] = inp[transport.Rank() * Shard + i];
+          shard_expected[i] = expected[transport.Rank() * Shard + i];
+        }
+        auto diff = model(TVariable(shard_inp, false)) - TVariable(shard_expected, false);
+        parallel.Backward(Sum(diff * diff));
+      });
+
+      for (size_t rank = 0; rank < Size; ++rank) {
+        expect(gt(bucket_counts[rank], 1u));
+        ForEachParameter([](auto& actual, auto& expected) {
+          expect(AllClose(actual->grad, expected->grad, 1e-4));
+        }, models[rank], reference);
+      }
+    };
+  }
+
+  "transport_failure"_test = [] {
+    struct TBrokenTransport final : ITransport {
+      size_t Rank() const override {
+        return 0;
+      }
+
+      size_t Size() const override {
+        return 2;
+      }
+
+      void Exchange(std::span<const std::byte>, std::span<std::byte>) override {
+        throw std::runtime_error("The previous rank has closed the connection");
+      }
+    };
+
+    TModel model;
+    TBrokenTransport transport;
+    TDistributedDataParallel<TModel> parallel(model, transport, 12 * sizeof(float));
+    auto out = model(TVariable(TTensor<float, 1, In>(1.f), false));
+    expect(throws<std::runtime_error>([&parallel, &out] {
+      parallel.Backward(Sum(out));
+    }));
+  };
+};
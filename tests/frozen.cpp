@@ -0,0 +1,120 @@
+#include <boost/ut.hpp>
+#include <dllib/frozen.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "helpers.hpp"
+
+namespace ut = boost::ut;
+
+using test_helpers::Randomize;
+
+namespace {
+
+constexpr size_t Batch = 4;
+
+using TInput = dllib::TTensor<double, Batch, 3>;
+using TModel = dllib::Sequential<
+  TInput,
+  dllib::FullyConnected<double, 3, 5>,
+  dllib::TanhActivation,
+  dllib::LayerNorm<double, 5>,
+  dllib::FullyConnected<double, 5, 4>,
+  dllib::ReLUActivation,
+  dllib::BatchNorm<double, 4>,
+  dllib::FullyConnected<double, 4, 2>,
+  dllib::SigmoidActivation>;
+
+//  A model with running statistics of BatchNorm different from the initial ones
+std::unique_ptr<TModel> MakeTrainedModel(std::mt19937& gen) {
+  auto model = std::make_unique<TModel>();
+  TInput x;
+  for (size_t i = 0; i < 5; ++i) {
+    Randomize(x, gen);
+    model->Forward(x);
+  }
+  return model;
+}
+
+}  // namespace
+
+static ut::suite frozen_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  "frozen_matches_model"_test = [] {
+    std::mt19937 gen(1);
+    auto model = MakeTrainedModel(gen);
+    auto frozen = Freeze(*model);
+
+    TInput x;
+    Randomize(x, gen);
+    auto expected = (*model)(x);
+    expect(AllClose(frozen(x), expected, 1e-12));
+
+    //  The frozen copy doesn't see later training
+    auto [weights, bias] = model->GetLayer<0>().GetParameters();
+    weights->value = TTensor<double, 3, 5>(0);
+    expect(AllClose(frozen(x), expected, 1e-12));
+  };
+
+  "frozen_weights_blob"_test = [] {
+    std::mt19937 gen(2);
+    auto model = MakeTrainedModel(gen);
+    TFrozenWeights weights(*model);
+
+    //  Weights and bias of three FullyConnected, scale and shift of LayerNorm, and BatchNorm with its statistics
+    expect(eq(weights.TensorCount(), 12u));
+    expect(eq(reinterpret_cast<std::uintptr_t>(weights.Data()) % TFrozenWeights::Alignment, 0u));
+    const auto& first = weights.Get<TTensor<double, 3, 5>>(0);
+    const auto& mean = weights.Get<TTensor<double, 4>>(8);
+    expect(eq(reinterpret_cast<std::uintptr_t>(&mean) % TFrozenWeights::Alignment, 0u));
+    expect(AllClose(first, std::get<0>(model->GetLayer<0>().GetParameters())->value));
+    expect(AllClose(mean, model->GetLayer<5>().GetRunningMean()));
+    expect(eq(weights.Size() % TFrozenWeights::Alignment, 0u));
+
+    expect(throws([&weights] { weights.Get<TTensor<double, 5, 3>>(0); }));
+    expect(throws([&weights] { weights.Get<TTensor<double, 4>>(12); }));
+
+    //  Anything with serialization fields can be frozen
+    FullyConnected<float, 7, 3> layer;
+    TFrozenWeights layer_weights(layer);
+    expect(eq(layer_weights.TensorCount(), 2u));
+    expect(AllClose(layer_weights.Get<TTensor<float, 3>>(1), std::get<0>(std::get<1>(layer.GetParameters()).GetParameters())->value));
+  };
+
+  "frozen_concurrent_calls"_test = [] {
+    std::mt19937 gen(3);
+    auto model = MakeTrainedModel(gen);
+    const auto frozen = Freeze(*model);
+
+    std::vector<TInput> inputs(16);
+    std::vector<TTensor<double, Batch, 2>> expected;
+    for (auto& x : inputs) {
+      Randomize(x, gen);
+      expected.push_back((*model)(x));
+    }
+
+    std::atomic<size_t> mismatches = 0;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; ++t) {
+      threads.emplace_back([&frozen, &inputs, &expected, &mismatches, t] {
+        for (size_t i = 0; i < 500; ++i) {
+          size_t k = (i + t) % inputs.size();
+          if (!AllClose(frozen(inputs[k]), expected[k], 1e-12)) {
+            ++mismatches;
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    expect(eq(mismatches.load(), 0u));
+  };
+};
@@ -0,0 +1,142 @@
+#include <boost/ut.hpp>
+#include <dllib/fused_optimizer.hpp>
+#include <dllib/layer.hpp>
+#include <dllib/loss.hpp>
+
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace ut = boost::ut;
+
+namespace {
+
+constexpr size_t Batch = 4;
+
+//  The second layer has more weights than a chunk of the fused step
+struct TModel {
+  auto operator()(const dllib::TVariable<dllib::TTensor<double, Batch, 3>>& x) {
+    return third(Tanh(second(Tanh(first(x)))));
+  }
+
+  auto GetParameters() {
+    return std::tie(first, second, third);
+  }
+
+  auto GetSerializationFields() const {
+    return std::tie(first, second, third);
+  }
+
+  dllib::FullyConnected<double, 3, 20> first;
+  dllib::FullyConnected<double, 20, 30> second;
+  dllib::FullyConnected<double, 30, 2> third;
+};
+
+//  Runs `steps` steps of `optimizer` on `model` with the same batches for every optimizer
+template<class TOptimizer>
+void Train(TModel& model, TOptimizer& optimizer, size_t steps, unsigned seed = 1) {
+  std::mt19937 gen(seed);
+  std::normal_distribution<double> dist;
+  dllib::TTensor<double, Batch, 3> x;
+  dllib::TTensor<double, Batch, 2> y;
+  for (size_t i = 0; i < steps; ++i) {
+    for (auto& v : x.View<-1u>()) {
+      v = dist(gen);
+    }
+    for (auto& v : y.View<-1u>()) {
+      v = dist(gen);
+    }
+    MeanSquaredError(model(dllib::TVariable(x, false)), y)->Backward();
+    optimizer.Step();
+  }
+}
+
+//  All the parameters of a model as one vector
+std::vector<double> Flatten(TModel& model, bool grads = false) {
+  std::vector<double> result;
+  dllib::ForEachParameter([&result, grads](auto& var) {
+    for (double x : (grads ? var->grad : var->value).template View<-1u>()) {
+      result.push_back(x);
+    }
+  }, model);
+  return result;
+}
+
+bool Close(const std::vector<double>& l, const std::vector<double>& r, double tolerance) {
+  bool close = l.size() == r.size();
+  for (size_t i = 0; close && i < l.size(); ++i) {
+    close = std::abs(l[i] - r[i]) <= tolerance * (1 + std::abs(r[i]));
+  }
+  return close;
+}
+
+}  // namespace
+
+static ut::suite fused_optimizer_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  "fused_matches_units"_test = [] {
+    auto check = [](auto&& manager, auto&& fused) {
+      TModel model;
+      TModel replica = helpers::MakeReplica(model);
+      manager.AddParameter(model);
+      fused.AddParameter(replica);
+      Train(model, manager, 20);
+      Train(replica, fused, 20);
+      expect(Close(Flatten(replica), Flatten(model), 1e-12));
+
+      //  The gradients are cleared by the step itself
+      bool cleared = true;
+      for (double grad : Flatten(replica, true)) {
+        cleared = cleared && grad == 0;
+      }
+      expect(cleared);
+    };
+    check(MakeOptimizerManager<TSGDOptimizerUnit>(0.01), MakeFusedOptimizer<TFusedSGD>(0.01));
+    check(MakeOptimizerManager<TMomentumOptimizerUnit>(0.01, 0.9), MakeFusedOptimizer<TFusedMomentum>(0.01, 0.9));
+    check(MakeOptimizerManager<TAdamOptimizerUnit>(0.01), MakeFusedOptimizer<TFusedAdam>(0.01));
+  };
+
+  "fused_serialization"_test = [] {
+    //  A checkpoint of TOptimizerManager continues with the fused optimizer and back
+    TModel model;
+    TModel replica = helpers::MakeReplica(model);
+    auto manager = MakeOptimizerManager<TAdamOptimizerUnit>(0.01);
+    auto fused = MakeFusedOptimizer<TFusedAdam>(0.01);
+    manager.AddParameter(model);
+    fused.AddParameter(replica);
+    Train(model, manager, 10);
+
+    std::stringstream ss;
+    Dump(ss, model);
+    Dump(ss, manager);
+    Load(ss, replica);
+    Load(ss, fused);
+    std::stringstream fused_state;
+    Dump(fused_state, fused);
+    std::stringstream manager_state;
+    Dump(manager_state, manager);
+    expect(fused_state.str() == manager_state.str());
+
+    Train(model, manager, 10, 2);
+    Train(replica, fused, 10, 2);
+    expect(Close(Flatten(replica), Flatten(model), 1e-12));
+  };
+
+  "fused_threads"_test = [] {
+    TThreadPool pool(3);
+    TModel model;
+    TModel replica = helpers::MakeReplica(model);
+    auto fused = MakeFusedOptimizer<TFusedAdam>(0.01);
+    auto threaded = MakeFusedOptimizer<TFusedAdam>(0.01);
+    threaded.SetThreadPool(&pool);
+    fused.AddParameter(model);
+    threaded.AddParameter(replica);
+    Train(model, fused, 20);
+    Train(replica, threaded, 20);
+
+    //  Every element is updated by the same code, whichever thread does it
+    expect(Flatten(replica) == Flatten(model));
+  };
+};
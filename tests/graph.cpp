@@ -0,0 +1,115 @@
+#include <boost/ut.hpp>
+#include <dllib/graph.hpp>
+#include <dllib/layer.hpp>
+
+namespace ut = boost::ut;
+
+static ut::suite graph_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  using TInput = TTensor<float, 4, 3>;
+  using TOutput = TTensor<float, 4, 2>;
+
+  auto make_batch = [](size_t step) {
+    TInput inp;
+    TOutput expected;
+    for (size_t i = 0; i < 4; ++i) {
+      for (size_t j = 0; j < 3; ++j) {
+        inp[i][j] = float(i + 2 * j + step) / 10;
+      }
+      for (size_t j = 0; j < 2; ++j) {
+        expected[i][j] = float(i * j + step) / 5;
+      }
+    }
+    return std::make_pair(inp, expected);
+  };
+
+  "replay_matches_eager"_test = [make_batch] {
+    FullyConnected<float, 3, 2> fc;
+    auto eager_fc = fc;
+    auto& weights = get<0>(fc.GetParameters());
+    auto& eager_weights = get<0>(eager_fc.GetParameters());
+    eager_weights = eager_weights.Copy();
+    auto& eager_bias = get<0>(get<1>(eager_fc.GetParameters()).GetParameters());
+    eager_bias = eager_bias.Copy();
+
+    TVariable<TInput> inp(false);
+    TVariable<TOutput> expected(false);
+    auto build = [&fc, &inp, &expected] {
+      auto diff = expected - fc(DropOut(inp));
+      return Sum(diff * diff);
+    };
+
+    TStaticGraph graph;
+    for (size_t step = 0; step < 3; ++step) {
+      std::tie(inp->value, expected->value) = make_batch(step);
+
+      helpers::entropy.seed(step);
+      graph.Run(build);
+
+      helpers::entropy.seed(step);
+      auto diff = TVariable(expected->value, false) - eager_fc(DropOut(TVariable(inp->value, false)));
+      Sum(diff * diff)->Backward();
+
+      expect(AllClose(weights->grad, eager_weights->grad));
+      weights->ZeroGrad();
+      eager_weights->ZeroGrad();
+    }
+  };
+
+  "fallback_to_eager"_test = [] {
+    TVariable<TTensor<float, 2>> v({1, 2}, true);
+    TStaticGraph graph;
+
+    auto square = [&v] {
+      return Sum(v * v);
+    };
+    auto cube = [&v] {
+      return Sum(v * v * v);
+    };
+
+    graph.Run(square);
+    expect(eq(v->grad, TTensor<float, 2>({2, 4})));
+    v->ZeroGrad();
+
+    graph.Run(cube);
+    expect(eq(v->grad, TTensor<float, 2>({3, 12})));
+    v->ZeroGrad();
+
+    graph.Run(cube, /* key = */ 1);
+    expect(eq(v->grad, TTensor<float, 2>({3, 12})));
+    v->ZeroGrad();
+
+    v->value = {2, 3};
+    graph.Run(cube, /* key = */ 1);
+    expect(eq(v->grad, TTensor<float, 2>({12, 27})));
+  };
+
+  "inplace_during_capture"_test = [] {
+    TVariable<TTensor<float, 2>> w({1, 2}, true);
+    TVariable<TTensor<float, 2>> x({3, 4}, false);
+    TVariable<TTensor<float, 2>> y({0.5, 2}, false);
+
+    TStaticGraph graph;
+    graph.Capture([&w, &x, &y] {
+      auto c = x * y;
+      AddInplace(c, y);
+      TanhInplace(c);
+      MulInplace(c, y);
+      return Sum(c * w);
+    });
+
+    x->value = {-1, 0.25};
+    w->ZeroGrad();
+    graph.Replay();
+    expect(AllClose(w->grad, Tanh(x->value * y->value + y->value) * y->value));
+  };
+
+  "replay_before_capture"_test = [] {
+    TStaticGraph graph;
+    expect(throws<std::runtime_error>([&graph] {
+      graph.Replay();
+    }));
+  };
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <random>
+
+//  Helpers shared by the test suites
+
+namespace test_helpers {
+
+//  Fills `tensor` with normal samples
+template<class T>
+void Randomize(T& tensor, std::mt19937& gen, double mean = 0, double stddev = 1) {
+  std::normal_distribution<double> dist(mean, stddev);
+  for (auto& x : tensor.template View<-1u>()) {
+    x = dist(gen);
+  }
+}
+
+//  Compares the gradient of `var` after Backward with central differences of `loss_value`
+template<class TLossValue, class TVariable>
+bool MatchesNumericGradient(TLossValue&& loss_value, TVariable& var) {
+  constexpr double Eps = 1e-6;
+  auto& values = var->value.template View<-1u>();
+  const auto& grads = var->grad.template View<-1u>();
+  bool matches = true;
+  for (size_t i = 0; i < values.Size(); ++i) {
+    double saved = values[i];
+    values[i] = saved + Eps;
+    double plus = loss_value();
+    values[i] = saved - Eps;
+    double minus = loss_value();
+    values[i] = saved;
+    matches = matches && std::abs((plus - minus) / (2 * Eps) - grads[i]) < 1e-6;
+  }
+  return matches;
+}
+
+}  // namespace test_helpers
@@ -0,0 +1,80 @@
+#include <boost/ut.hpp>
+#include <dllib/hogwild.hpp>
+
+#include <random>
+
+namespace ut = boost::ut;
+
+static ut::suite hogwild_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  "for_each_parameter"_test = [] {
+    FullyConnected<float, 3, 2> fc;
+    auto copy = helpers::MakeReplica(fc);
+
+    size_t count = 0;
+    ForEachParameter([&count](auto& var, auto& copied) {
+      ++count;
+      expect(var.get() != copied.get());
+      expect(eq(var->value, copied->value));
+    }, fc, copy);
+    expect(eq(count, 2u));
+  };
+
+  "hogwild_linear_regression"_test = [] {
+    constexpr size_t Batch = 8, In = 4, Samples = 256;
+    using TInput = TTensor<float, Batch, In>;
+    using TOutput = TTensor<float, Batch, 1>;
+
+    std::mt19937 gen(5);
+    std::normal_distribution<float> dist;
+    std::vector<TTensor<float, In>> xs(Samples);
+    std::vector<float> ys(Samples);
+    TTensor<float, In> true_weights({1, -2, 0.5, 3});
+    for (size_t i = 0; i < Samples; ++i) {
+      for (size_t j = 0; j < In; ++j) {
+        xs[i][j] = dist(gen);
+      }
+      ys[i] = Sum(xs[i] * true_weights) + 1;
+    }
+
+    FullyConnected<float, In, 1> fc;
+    auto loss = [&xs, &ys](auto& model, size_t thread, size_t iteration) {
+      TInput inp;
+      TOutput expected;
+      for (size_t b = 0; b < Batch; ++b) {
+        size_t sample = (thread * 97 + iteration * Batch + b) % Samples;
+        inp[b] = xs[sample];
+        expected[b][0] = ys[sample];
+      }
+      auto diff = model(TVariable(inp, false)) - TVariable(expected, false);
+      return Sum(diff * diff);
+    };
+
+    HogwildTrain<TMomentumOptimizerUnit>(fc, 4, 300, loss, 0.002f, 0.5f);
+
+    auto [weights, bias_layer] = fc.GetParameters();
+    auto& bias = get<0>(bias_layer.GetParameters());
+    expect(AllClose(weights->value.View<-1u>(), true_weights, 1e-2));
+    expect(std::abs(float(bias->value[0]) - 1) < 1e-2);
+    expect(eq(Sum(weights->grad * weights->grad), 0.f));
+  };
+
+  "hogwild_exception"_test = [] {
+    FullyConnected<float, 2, 1> fc;
+    std::atomic<size_t> iterations = 0;
+    auto loss = [&iterations](auto& model, size_t thread, size_t iteration) {
+      iterations.fetch_add(1);
+      if (thread == 1 && iteration == 3) {
+        throw std::runtime_error("step failed");
+      }
+      return Sum(model(TVariable(TTensor<float, 1, 2>(1.f), false)));
+    };
+
+    expect(throws<std::runtime_error>([&fc, &loss] {
+      HogwildTrain<TSGDOptimizerUnit>(fc, 3, 100'000, loss, 0.001f);
+    }));
+    expect(lt(iterations.load(), 300'000u));
+  };
+};
@@ -0,0 +1,39 @@
+#include <boost/ut.hpp>
+#include <dllib/layer.hpp>
+
+namespace ut = boost::ut;
+
+template<size_t... Dims>
+using Tensor = dllib::TTensor<float, Dims...>;
+
+static ut::suite layer_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  "dropout_no_grad"_test = [] {
+    TVariable<Tensor<4, 8>> v(Tensor<4, 8>(1), false);
+    {
+      TNoGradGuard guard;
+      auto out = DropOut(v, .9);
+      expect(eq(out.get(), v.get()));
+    }
+    auto out = DropOut(v, .9);
+    expect(eq(out.IsLeaf(), false));
+  };
+
+  "fully_connected_no_grad"_test = [] {
+    FullyConnected<float, 3, 2> fc;
+    Tensor<4, 3> inp = {
+      {1, 2, 3},
+      {4, 5, 6},
+      {7, 8, 9},
+      {0, 1, 0},
+    };
+    auto expected = fc(inp);
+
+    TNoGradGuard guard;
+    auto out = fc(DropOut(TVariable(inp, false)));
+    expect(eq(out.IsLeaf(), true));
+    expect(AllClose(out->value, expected));
+  };
+};
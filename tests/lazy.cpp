@@ -0,0 +1,62 @@
+#include <boost/ut.hpp>
+#include <dllib/lazy.hpp>
+
+namespace ut = boost::ut;
+
+template<size_t... Dims>
+using Tensor = dllib::TTensor<float, Dims...>;
+
+static ut::suite lazy_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  "tanh_of_sum"_test = [] {
+    TVariable<Tensor<2, 3>> a({{1, 2, 3}, {-1, -2, -3}}, true);
+    TVariable<Tensor<2, 3>> b({{.5, -.5, 0}, {.1, .2, .3}}, true);
+
+    TVariable<Tensor<2, 3>> fused = Tanh(Lazy(a) + b);
+    expect(eq(fused->GetChildren().size(), 2u));
+    expect(AllClose(fused->value, Tanh(a->value + b->value)));
+
+    Sum(fused)->Backward();
+    auto fused_a = a->grad, fused_b = b->grad;
+    a->ZeroGrad();
+    b->ZeroGrad();
+
+    Sum(Tanh(a + b))->Backward();
+    expect(AllClose(fused_a, a->grad));
+    expect(AllClose(fused_b, b->grad));
+  };
+
+  "sum_of_squares"_test = [] {
+    TVariable<Tensor<3, 2>> out({{1, 2}, {3, 4}, {5, 6}}, true);
+    TVariable<Tensor<3, 2>> expected({{0, 2}, {4, 4}, {2, 8}}, false);
+    auto diff = expected - out;
+
+    auto loss = Sum(Lazy(diff) * diff);
+    expect(eq(loss->value.Data(), 15.f));
+    loss->Backward();
+    expect(AllClose(out->grad, Tensor<3, 2>({{2, 0}, {-2, 0}, {6, -4}})));
+    expect(eq(expected->grad, Tensor<3, 2>(0)));
+  };
+
+  "mixed_chain"_test = [] {
+    TVariable<Tensor<4>> a({1, 2, 3, 4}, true);
+    TVariable<Tensor<4>> b({.5, 1, 1.5, 2}, true);
+
+    auto lazy = Sum(Sigmoid(Lazy(a) / b) * Exp(-Lazy(b)) + Log(Lazy(a)) * 2.f - 1.f);
+    lazy->Backward();
+    auto lazy_a = a->grad, lazy_b = b->grad;
+    a->ZeroGrad();
+    b->ZeroGrad();
+
+    //  There is no division of variables, so only the gradient of `a` is compared
+    TVariable<Tensor<4>> two(Tensor<4>(2), false), one(Tensor<4>(1), false);
+    TVariable<Tensor<4>> inv_b(Tensor<4>(1) / b->value, false);
+    auto eager = Sum(Sigmoid(a * inv_b) * Exp(-b) + Log(a) * two - one);
+    expect(AllClose(lazy->value, eager->value, 1e-5));
+    eager->Backward();
+    expect(AllClose(lazy_a, a->grad, 1e-5));
+    expect(AllClose(lazy_b, Tensor<4>({-0.7889577, -0.4012771, -0.2277687, -0.1334123}), 1e-5));
+  };
+};
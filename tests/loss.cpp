@@ -0,0 +1,91 @@
+#include <boost/ut.hpp>
+#include <dllib/loss.hpp>
+
+#include <cmath>
+
+namespace ut = boost::ut;
+
+static ut::suite loss_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  "softmax_cross_entropy"_test = [] {
+    TTensor<double, 2, 3> logits = {{1, 2, 3}, {0.5, -1, 0}};
+    TTensor<size_t, 2> labels = {2, 1};
+    TVariable x(logits, true);
+    auto loss = SoftmaxCrossEntropy(x, labels);
+    loss->Backward();
+
+    //  The same from the definition: -log(exp(x_label) / sum(exp(x)))
+    double expected = 0;
+    TTensor<double, 2, 3> expected_grad;
+    for (size_t b = 0; b < 2; ++b) {
+      double exp_sum = 0;
+      for (size_t c = 0; c < 3; ++c) {
+        exp_sum += std::exp(logits[b][c]);
+      }
+      expected -= std::log(std::exp(logits[b][labels[b]]) / exp_sum) / 2;
+      for (size_t c = 0; c < 3; ++c) {
+        expected_grad[b][c] = (std::exp(logits[b][c]) / exp_sum - (c == size_t(labels[b]))) / 2;
+      }
+    }
+    expect(lt(std::abs(loss->value - expected), 1e-12));
+    expect(AllClose(x->grad, expected_grad, 1e-12));
+
+    x->ZeroGrad();
+    SoftmaxCrossEntropy(x, labels, EReduction::Sum)->Backward();
+    expect(AllClose(x->grad, expected_grad * 2., 1e-12));
+  };
+
+  "softmax_cross_entropy_is_stable"_test = [] {
+    //  exp(1000) overflows, shifting by the largest logit keeps everything finite
+    TVariable x(TTensor<float, 2, 2>{{1000, 0}, {-1000, -990}}, true);
+    auto loss = SoftmaxCrossEntropy(x, TTensor<size_t, 2>{1, 1}, EReduction::Sum);
+    loss->Backward();
+    expect(lt(std::abs(loss->value - (1000 + std::log1p(std::exp(-10.f)))), 1e-2));
+    expect(AllClose(x->grad, TTensor<float, 2, 2>{{1, -1}, {std::exp(-10.f), -std::exp(-10.f)}}, 1e-4));
+
+    expect(throws([&x] { SoftmaxCrossEntropy(x, TTensor<size_t, 2>{0, 2}); }));
+  };
+
+  "mean_squared_error"_test = [] {
+    TTensor<float, 2, 3> prediction = {{1, 2, 3}, {4, 5, 6}};
+    TTensor<float, 2, 3> target = {{0, 2, 5}, {4, 4, 4}};
+    TVariable p(prediction, true), t(target, true);
+
+    auto loss = MeanSquaredError(p, t);
+    expect(lt(std::abs(loss->value - 10.f / 6), 1e-6));
+    loss->Backward();
+    expect(AllClose(p->grad, (prediction - target) * (2.f / 6)));
+    expect(AllClose(t->grad, (target - prediction) * (2.f / 6)));
+
+    //  Summed, it's the usual Sum(diff * diff)
+    TVariable composed(prediction, true);
+    auto diff = composed - TVariable(target, false);
+    Sum(diff * diff)->Backward();
+    TVariable fused(prediction, true);
+    auto sum = MeanSquaredError(fused, target, EReduction::Sum);
+    sum->Backward();
+    expect(eq(float(sum->value), 10.f));
+    expect(AllClose(fused->grad, composed->grad));
+  };
+
+  "huber"_test = [] {
+    TTensor<float, 4> prediction = {0.5, -0.5, 3, -2};
+    TTensor<float, 4> target(0);
+    TVariable p(prediction, true);
+
+    auto loss = Huber(p, target, 1.f, EReduction::Sum);
+    //  Quadratic for the first two, linear for the outliers
+    expect(lt(std::abs(loss->value - (0.125f + 0.125f + 2.5f + 1.5f)), 1e-6));
+    loss->Backward();
+    expect(AllClose(p->grad, TTensor<float, 4>{0.5, -0.5, 1, -1}));
+
+    p->ZeroGrad();
+    Huber(p, target, 2.f)->Backward();
+    expect(AllClose(p->grad, TTensor<float, 4>{0.5, -0.5, 2, -2} / 4.f));
+
+    expect(throws([&p, &target] { Huber(p, target, 0.f); }));
+    expect(throws([&p, &target] { Huber(p, target, -1.f); }));
+  };
+};
@@ -0,0 +1,133 @@
+#include <boost/ut.hpp>
+#include <dllib/low_rank.hpp>
+#include <dllib/serialization.hpp>
+
+#include <cmath>
+#include <random>
+#include <sstream>
+
+#include "helpers.hpp"
+
+namespace ut = boost::ut;
+
+using test_helpers::Randomize;
+
+namespace {
+
+constexpr size_t Batch = 3, From = 10, To = 7;
+
+//  Weights which are the sum of `rank` outer products with norms 1, 2, ... rank, plus noise
+template<size_t Rank>
+dllib::TTensor<double, From, To> MakeWeights(std::mt19937& gen, double noise) {
+  dllib::TTensor<double, From, Rank> u;
+  dllib::TTensor<double, Rank, To> v;
+  Randomize(u, gen);
+  Randomize(v, gen);
+  for (size_t r = 0; r < Rank; ++r) {
+    v[r] *= double(r + 1);
+  }
+  dllib::TTensor<double, From, To> noise_weights;
+  Randomize(noise_weights, gen, 0, noise);
+  return dllib::MatrixProduct(u, v) + noise_weights;
+}
+
+double FrobeniusNorm(const dllib::TTensor<double, From, To>& w) {
+  double sum = 0;
+  for (double x : w.View<-1u>()) {
+    sum += x * x;
+  }
+  return std::sqrt(sum);
+}
+
+}  // namespace
+
+static ut::suite low_rank_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  "low_rank_recovers_low_rank_weights"_test = [] {
+    std::mt19937 gen(1);
+    FullyConnected<double, From, To> dense;
+    auto [weights, bias] = dense.GetParameters();
+    weights->value = MakeWeights<3>(gen, 0);
+
+    LowRankFullyConnected<double, From, 3, To> low_rank(dense);
+    TTensor<double, Batch, From> x;
+    Randomize(x, gen);
+    expect(AllClose(low_rank(x), dense(x), 1e-9));
+
+    //  The factors share the singular values evenly
+    auto [left, right, low_rank_bias] = low_rank.GetParameters();
+    for (size_t r = 0; r < 3; ++r) {
+      double left_norm = 0, right_norm = 0;
+      for (size_t i = 0; i < From; ++i) {
+        left_norm += left->value[i][r] * left->value[i][r];
+      }
+      for (size_t j = 0; j < To; ++j) {
+        right_norm += right->value[r][j] * right->value[r][j];
+      }
+      expect(lt(std::abs(left_norm - right_norm), 1e-9 * left_norm));
+    }
+  };
+
+  "low_rank_truncation"_test = [] {
+    std::mt19937 gen(2);
+    FullyConnected<double, From, To> dense;
+    auto [weights, bias] = dense.GetParameters();
+    weights->value = MakeWeights<5>(gen, 0.01);
+
+    //  The error of a truncated SVD is the norm of the dropped singular values, compare to the exact
+    //  factorization got by keeping the full rank
+    LowRankFullyConnected<double, From, 2, To> low_rank(dense);
+    LowRankFullyConnected<double, From, To, To> full(dense);
+    auto [left, right, low_rank_bias] = low_rank.GetParameters();
+    auto [full_left, full_right, full_bias] = full.GetParameters();
+    expect(AllClose(MatrixProduct(full_left->value, full_right->value), weights->value, 1e-9));
+
+    auto error = FrobeniusNorm(weights->value - MatrixProduct(left->value, right->value));
+    TTensor<double, To, To> keep_two(0);
+    keep_two[0][0] = keep_two[1][1] = 1;
+    auto best = FrobeniusNorm(weights->value - MatrixProduct(MatrixProduct(full_left->value, keep_two), full_right->value));
+    expect(lt(std::abs(error - best), 1e-9 * best));
+  };
+
+  "low_rank_gradients"_test = [] {
+    std::mt19937 gen(3);
+    LowRankFullyConnected<double, From, 2, To> layer;
+    auto [left, right, bias] = layer.GetParameters();
+    auto [bias_var] = bias.GetParameters();
+    TVariable<TTensor<double, Batch, From>> x(true);
+    Randomize(x->value, gen);
+    TTensor<double, Batch, To> grad;
+    Randomize(grad, gen);
+
+    auto result = layer(x);
+    expect(AllClose(result->value, layer(x->value), 1e-12));
+    result->Backward(grad);
+
+    //  The same as a layer holding the product of the factors
+    FullyConnected<double, From, To> dense;
+    auto [weights, dense_bias] = dense.GetParameters();
+    auto [dense_bias_var] = dense_bias.GetParameters();
+    weights->value = MatrixProduct(left->value, right->value);
+    dense_bias_var->value = bias_var->value;
+    TVariable<TTensor<double, Batch, From>> dense_x(x->value, true);
+    dense(dense_x)->Backward(grad);
+    expect(AllClose(x->grad, dense_x->grad, 1e-12));
+    expect(AllClose(bias_var->grad, dense_bias_var->grad, 1e-12));
+    expect(AllClose(left->grad, MatrixProduct(weights->grad, right->value.T()), 1e-12));
+    expect(AllClose(right->grad, MatrixProduct(left->value.T(), weights->grad), 1e-12));
+  };
+
+  "low_rank_serialization"_test = [] {
+    std::mt19937 gen(4);
+    LowRankFullyConnected<double, From, 3, To> layer, loaded;
+    TTensor<double, Batch, From> x;
+    Randomize(x, gen);
+
+    std::stringstream ss;
+    Dump(ss, layer);
+    Load(ss, loaded);
+    expect(AllClose(loaded(x), layer(x)));
+  };
+};
@@ -0,0 +1,92 @@
+#include <boost/ut.hpp>
+#include <dllib/fused_optimizer.hpp>
+#include <dllib/layer.hpp>
+#include <dllib/memory.hpp>
+#include <dllib/optimizer.hpp>
+
+namespace ut = boost::ut;
+
+static ut::suite memory_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  auto& tracker = TMemoryTracker::Get();
+
+  "memory_tracker"_test = [&tracker] {
+    size_t parameters = tracker.GetLiveBytes(EMemoryCategory::Parameters);
+    size_t gradients = tracker.GetLiveBytes(EMemoryCategory::Gradients);
+    size_t activations = tracker.GetLiveBytes(EMemoryCategory::Activations);
+    size_t state = tracker.GetLiveBytes(EMemoryCategory::OptimizerState);
+
+    FullyConnected<float, 3, 2> fc;
+    auto optimizer = MakeOptimizerManager<TAdamOptimizerUnit>(0.01f);
+    optimizer.AddParameter(fc);
+
+    auto step = [&fc, &optimizer]<size_t Batch>() {
+      TVariable<TTensor<float, Batch, 3>> inp(TTensor<float, Batch, 3>(1.f), false);
+      Sum(Tanh(fc(inp)))->Backward();
+      optimizer.Step();
+    };
+
+#ifdef DLLIB_MEMORY_TRACKING
+    constexpr size_t parameter_bytes = (3 * 2 + 2) * sizeof(float);
+    expect(eq(tracker.GetLiveBytes(EMemoryCategory::Parameters) - parameters, parameter_bytes));
+    expect(eq(tracker.GetLiveBytes(EMemoryCategory::Gradients) - gradients, parameter_bytes));
+    expect(eq(tracker.GetLiveBytes(EMemoryCategory::OptimizerState) - state, 2 * parameter_bytes));
+
+    size_t small = tracker.MeasurePeak([&step] { step.template operator()<4>(); });
+    size_t large = tracker.MeasurePeak([&step] { step.template operator()<64>(); });
+    expect(gt(small, 0u));
+    expect(gt(large, 8 * small));
+    expect(ge(tracker.GetPeakBytes(EMemoryCategory::Activations) - activations, 64 * 2 * sizeof(float)));
+    //  The graph is released after the step
+    expect(eq(tracker.GetLiveBytes(EMemoryCategory::Activations), activations));
+#else
+    step.template operator()<4>();
+    expect(eq(parameters + gradients + activations + state, 0u));
+    expect(eq(tracker.GetPeakBytes(), 0u));
+#endif
+  };
+
+  "leaf_category_follows_requires_grad"_test = [&tracker] {
+    size_t parameters = tracker.GetLiveBytes(EMemoryCategory::Parameters);
+    size_t activations = tracker.GetLiveBytes(EMemoryCategory::Activations);
+
+    TVariable<TTensor<float, 8>> leaf(false);
+    leaf->requires_grad = true;
+
+#ifdef DLLIB_MEMORY_TRACKING
+    expect(eq(tracker.GetLiveBytes(EMemoryCategory::Parameters) - parameters, 8 * sizeof(float)));
+    expect(eq(tracker.GetLiveBytes(EMemoryCategory::Activations), activations));
+
+    leaf->requires_grad = false;
+    expect(eq(tracker.GetLiveBytes(EMemoryCategory::Parameters), parameters));
+    expect(eq(tracker.GetLiveBytes(EMemoryCategory::Activations) - activations, 8 * sizeof(float)));
+#else
+    expect(eq(parameters + activations + tracker.GetLiveBytes(EMemoryCategory::Parameters), 0u));
+#endif
+  };
+
+  "fused_optimizer_state_counted_once"_test = [&tracker] {
+    size_t state = tracker.GetLiveBytes(EMemoryCategory::OptimizerState);
+    FullyConnected<float, 3, 2> first;
+    FullyConnected<float, 2, 4> second;
+    FullyConnected<float, 4, 1> third;
+
+    auto optimizer = MakeFusedOptimizer<TFusedAdam>(0.01f);
+    size_t peak = tracker.MeasurePeak([&] {
+      optimizer.AddParameter(first);
+      optimizer.AddParameter(second);
+      optimizer.AddParameter(third);
+    });
+
+#ifdef DLLIB_MEMORY_TRACKING
+    constexpr size_t parameter_bytes = (3 * 2 + 2 + 2 * 4 + 4 + 4 * 1 + 1) * sizeof(float);
+    expect(eq(tracker.GetLiveBytes(EMemoryCategory::OptimizerState) - state, 2 * parameter_bytes));
+    expect(eq(tracker.GetPeakBytes(EMemoryCategory::OptimizerState) - state, 2 * parameter_bytes));
+    expect(eq(peak, 2 * parameter_bytes));
+#else
+    expect(eq(state + peak, 0u));
+#endif
+  };
+};
@@ -0,0 +1,161 @@
+#include <boost/ut.hpp>
+#include <dllib/memory_plan.hpp>
+#include <dllib/normalization.hpp>
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+
+namespace ut = boost::ut;
+
+static ut::suite memory_plan_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  using TMatrix = TTensor<float, 16, 16>;
+
+  "chain_reuses_buffers"_test = [] {
+    TVariable<TMatrix> x(TMatrix(0.5f), true);
+
+    TStaticGraph graph;
+    graph.Capture([&x] {
+      TVariable<TMatrix> y = x;
+      for (size_t i = 0; i < 8; ++i) {
+        y = Tanh(y);
+      }
+      return Sum(y);
+    });
+
+    auto plan = PlanMemory(graph);
+    expect(eq(plan.buffers.size(), 18u));
+    expect(eq(plan.naive_bytes, 2 * (8 * sizeof(TMatrix) + sizeof(float))));
+    //  Tanh keeps its output for backward, so all values are alive at the start of backward, but
+    //  gradients are freed as soon as they are pushed and the plan hits the working set exactly
+    expect(eq(plan.planned_bytes, plan.peak_live_bytes));
+    expect(lt(plan.planned_bytes, plan.naive_bytes * 2 / 3));
+
+    for (const auto& lhs : plan.buffers) {
+      expect(eq(lhs.offset % TMemoryPlan::Alignment, 0u));
+      for (const auto& rhs : plan.buffers) {
+        if (&lhs == &rhs || lhs.last_use < rhs.first_use || rhs.last_use < lhs.first_use) {
+          continue;
+        }
+        expect(lhs.offset + lhs.bytes <= rhs.offset || rhs.offset + rhs.bytes <= lhs.offset);
+      }
+    }
+
+    std::stringstream report;
+    report << plan;
+    expect(report.str().find("planned") != std::string::npos);
+  };
+
+  "values_without_grad"_test = [] {
+    TVariable<TMatrix> x(TMatrix(0.5f), false);
+    TVariable<TMatrix> w(TMatrix(0.1f), true);
+
+    TStaticGraph graph;
+    graph.Capture([&x, &w] {
+      return Sum(Tanh(Tanh(x)) * w);
+    });
+
+    auto plan = PlanMemory(graph);
+    size_t grads = 0;
+    for (const auto& buffer : plan.buffers) {
+      grads += buffer.is_gradient;
+    }
+    //  Only the product and the root need gradients, tanh of the input is a constant
+    expect(eq(grads, 2u));
+    expect(eq(plan.buffers.size(), 6u));
+  };
+
+  "planned_graph_matches_eager"_test = [] {
+    TVariable<TMatrix> x(TMatrix(0.5f), false);
+    TVariable<TMatrix> w(TMatrix(0.1f), true);
+    TVariable<TMatrix> b(TMatrix(-0.2f), true);
+
+    auto build = [&x, &w, &b] {
+      auto constant = Tanh(Tanh(x));
+      auto y = MatrixProduct(constant, w);
+      for (size_t i = 0; i < 4; ++i) {
+        y = Tanh(MatrixProduct(y, w) + b) * constant;
+      }
+      //  Not a part of the graph of the root
+      auto unused = Sum(y * y);
+      return Sum(y);
+    };
+
+    auto eager = [&] {
+      w->ZeroGrad();
+      b->ZeroGrad();
+      auto loss = build();
+      loss->Backward();
+      return std::tuple(loss->value.Data(), w->grad, b->grad);
+    };
+
+    TPlannedGraph graph;
+    auto root = graph.Capture(build);
+    const auto& plan = graph.GetPlan();
+    expect(lt(plan.planned_bytes, plan.naive_bytes));
+    expect(ge(graph.GetArenaBytes(), plan.planned_bytes));
+    auto planned = std::tuple(root->value.Data(), w->grad, b->grad);
+
+    auto [loss, w_grad, b_grad] = eager();
+    expect(lt(std::abs(get<0>(planned) - loss), 1e-4f));
+    expect(AllClose(get<1>(planned), w_grad, 1e-4f));
+    expect(AllClose(get<2>(planned), b_grad, 1e-4f));
+
+    //  Replays see new inputs, and leftovers of the previous step in the reused slots don't leak in
+    for (size_t step = 0; step < 2; ++step) {
+      x->value = TMatrix(step == 0 ? -1.f : 0.25f);
+      w->ZeroGrad();
+      b->ZeroGrad();
+      graph.Replay();
+      auto replayed = std::tuple(root->value.Data(), w->grad, b->grad);
+
+      auto [loss, w_grad, b_grad] = eager();
+      expect(lt(std::abs(get<0>(replayed) - loss), 1e-4f));
+      expect(AllClose(get<1>(replayed), w_grad, 1e-4f));
+      expect(AllClose(get<2>(replayed), b_grad, 1e-4f));
+    }
+  };
+
+  "planned_graph_needs_the_same_graph"_test = [] {
+    TVariable<TMatrix> x(TMatrix(0.5f), true);
+    size_t runs = 0;
+
+    TPlannedGraph graph;
+    expect(throws<std::runtime_error>([&graph] {
+      graph.Replay();
+    }));
+    expect(throws<std::runtime_error>([&] {
+      graph.Capture([&x, &runs] {
+        auto y = Tanh(x);
+        if (runs++ > 0) {
+          y = Tanh(y);
+        }
+        return Sum(y);
+      });
+    }));
+  };
+
+  "planned_graph_side_effects_happen_once"_test = [] {
+    TTensor<float, 3, 4> x = {{1, 2, 3, 4}, {0, 1, 0, 1}, {5, -5, 2, 2}};
+    BatchNorm<float, 4> eager;
+    BatchNorm<float, 4> planned;
+    Sum(Tanh(eager(TVariable(x, true))))->Backward();
+
+    auto expected_entropy = helpers::entropy;
+    expected_entropy();
+    TPlannedGraph graph;
+    graph.Capture([&planned, &x] {
+      helpers::entropy();
+      return Sum(Tanh(planned(TVariable(x, true))));
+    });
+
+    expect(AllClose(planned.GetRunningMean(), eager.GetRunningMean()));
+    expect(AllClose(planned.GetRunningVariance(), eager.GetRunningVariance()));
+    expect(helpers::entropy == expected_entropy);
+    expect(eq(helpers::checkpoint_recompute_enabled, false));
+  };
+};
@@ -0,0 +1,165 @@
+#include <boost/ut.hpp>
+#include <dllib/layer.hpp>
+#include <dllib/mixed_precision.hpp>
+
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+namespace ut = boost::ut;
+
+static ut::suite mixed_precision_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  "bfloat16_rounding"_test = [] {
+    expect(eq(TBFloat16(1.f).Bits(), 0x3f80));
+    expect(eq(float(TBFloat16(-2.5f)), -2.5f));
+    //  Ties go to even, the unit in the last place of 1 is 2^-7
+    expect(eq(float(TBFloat16(1 + std::ldexp(1.f, -8))), 1.f));
+    expect(eq(float(TBFloat16(1 + 3 * std::ldexp(1.f, -8))), 1 + std::ldexp(1.f, -6)));
+    expect(eq(float(TBFloat16(1 + 3 * std::ldexp(1.f, -9))), 1 + std::ldexp(1.f, -7)));
+
+    //  Bits rather than std::isinf and std::isnan, which -ffast-math folds
+    expect(eq(TBFloat16(std::numeric_limits<float>::max()).Bits(), 0x7f80));
+    expect(eq(TBFloat16(-std::numeric_limits<float>::infinity()).Bits(), 0xff80));
+    uint16_t nan = TBFloat16(std::numeric_limits<float>::quiet_NaN()).Bits();
+    expect(eq(nan & 0x7f80, 0x7f80) && neq(nan & 0x7f, 0));
+
+    TBFloat16 x = 3;
+    x *= 2;
+    x -= 1;
+    expect(eq(float(x), 5.f));
+  };
+
+  "bfloat16_products_accumulate_in_float"_test = [] {
+    //  Past 256 a bf16 sum can't take another 1, a float one can, and 512 rounds to bf16 exactly
+    TTensor<TBFloat16, 1, 512> row(1);
+    TTensor<TBFloat16, 512, 1> column(1);
+    expect(eq(float(MatrixProduct(row, column)[0][0].Data()), 512.f));
+    expect(eq(float(MatrixProductTransposed(row, row)[0][0].Data()), 512.f));
+    expect(eq(float(TransposedMatrixProduct(column, column)[0][0].Data()), 512.f));
+  };
+
+  "bfloat16_tensors"_test = [] {
+    TTensor<float, 2, 2> value = {{1, -2}, {0.5, 4}};
+    auto low = value.To<TBFloat16>();
+    expect(AllClose(low.To<float>(), value));
+
+    TVariable x(low, true);
+    Sum(Tanh(x) * x)->Backward();
+    auto expected = Tanh(value) + value * (1 - Tanh(value) * Tanh(value));
+    expect(AllClose(x->grad.To<float>(), expected, 2e-2));
+  };
+
+  "master_weights_keep_small_updates"_test = [] {
+    TVariable<TTensor<TBFloat16, 2>> var(TTensor<TBFloat16, 2>(1), true);
+    auto optimizer = MakeOptimizerManager<TMixedPrecision<TSGDOptimizerUnit>::TUnit>(1e-3f);
+    optimizer.AddParameter(var);
+
+    //  A step of 1e-3 is below the precision of bf16 around 1, only the master weights see it
+    Sum(var)->Backward();
+    optimizer.Step();
+    expect(AllClose(var->value.To<float>(), TTensor<float, 2>(1)));
+    expect(AllClose(var->grad.To<float>(), TTensor<float, 2>(0)));
+
+    for (size_t i = 1; i < 100; ++i) {
+      Sum(var)->Backward();
+      optimizer.Step();
+    }
+    expect(AllClose(var->value.To<float>(), TTensor<float, 2>(0.9), 4e-3));
+  };
+
+  "dynamic_loss_scaling"_test = [] {
+    FullyConnected<TBFloat16, 3, 2> model;
+    auto optimizer = MakeOptimizerManager<TMixedPrecision<TAdamOptimizerUnit>::TUnit>(1e-2f);
+    optimizer.AddParameter(model);
+    TTensor<TBFloat16, 4, 3> inp(TBFloat16(0.5f));
+
+    auto snapshot = [&model] {
+      std::stringstream out;
+      ForEachParameter([&out](auto& var) {
+        Dump(out, var->value);
+      }, model);
+      return out.str();
+    };
+
+    //  The scaled gradients overflow, the step is skipped and the scale backs off
+    TDynamicLossScaler scaler(std::ldexp(1.f, 126), /*growth_interval=*/2);
+    auto before = snapshot();
+    scaler.Backward(Sum(model(TVariable(inp, false))));
+    expect(!optimizer.HasFiniteGradients());
+    expect(!scaler.Step(optimizer));
+    expect(eq(scaler.SkippedSteps(), 1u));
+    expect(eq(scaler.Scale(), std::ldexp(1.f, 125)));
+    expect(eq(snapshot(), before));
+    expect(optimizer.HasFiniteGradients());
+
+    //  With a sane scale the steps go on and the scale grows every growth_interval steps
+    TDynamicLossScaler sane(1 << 10, 2);
+    for (size_t i = 0; i < 4; ++i) {
+      sane.Backward(Sum(model(TVariable(inp, false))));
+      expect(sane.Step(optimizer));
+    }
+    expect(eq(sane.Scale(), float(1 << 12)));
+    expect(snapshot() != before);
+  };
+
+  "matches_single_precision"_test = [] {
+    //  Same initial values in both precisions
+    auto gen = [i = 0]() mutable {
+      return TBFloat16(0.25f * float(++i % 7) - 0.75f);
+    };
+    FullyConnected<TBFloat16, 3, 2> low(gen);
+    auto float_gen = [i = 0]() mutable {
+      return 0.25f * float(++i % 7) - 0.75f;
+    };
+    FullyConnected<float, 3, 2> full(float_gen);
+
+    auto low_optimizer = MakeOptimizerManager<TMixedPrecision<TAdamOptimizerUnit>::TUnit>(1e-2f);
+    low_optimizer.AddParameter(low);
+    auto full_optimizer = MakeOptimizerManager<TAdamOptimizerUnit>(1e-2f);
+    full_optimizer.AddParameter(full);
+
+    TTensor<float, 4, 3> inp = {{1, 0, -1}, {0.5, 2, 0}, {-1, -1, 1}, {0, 0.25, 0.5}};
+    TDynamicLossScaler scaler;
+    for (size_t i = 0; i < 20; ++i) {
+      auto low_out = low(TVariable(inp.To<TBFloat16>(), false));
+      scaler.Backward(Sum(low_out * low_out));
+      expect(scaler.Step(low_optimizer));
+
+      auto full_out = full(TVariable(inp, false));
+      Sum(full_out * full_out)->Backward();
+      full_optimizer.Step();
+    }
+
+    ForEachParameter([](auto& low, auto& full) {
+      expect(AllClose(low->value.template To<float>(), full->value, 3e-2));
+    }, low, full);
+  };
+
+  "mixed_precision_serialization"_test = [] {
+    TVariable<TTensor<TBFloat16, 3>> var(TTensor<TBFloat16, 3>(1), true);
+    auto optimizer = MakeOptimizerManager<TMixedPrecision<TMomentumOptimizerUnit>::TUnit>(1e-3f, 0.9f);
+    optimizer.AddParameter(var);
+    for (size_t i = 0; i < 10; ++i) {
+      Sum(var)->Backward();
+      optimizer.Step();
+    }
+
+    std::stringstream state;
+    optimizer.Dump(state);
+
+    TVariable<TTensor<TBFloat16, 3>> other(TTensor<TBFloat16, 3>(0), true);
+    auto restored = MakeOptimizerManager<TMixedPrecision<TMomentumOptimizerUnit>::TUnit>(1e-3f, 0.9f);
+    restored.AddParameter(other);
+    restored.Load(state);
+    expect(other->value == var->value);
+
+    Sum(var)->Backward();
+    optimizer.Step();
+    Sum(other)->Backward();
+    restored.Step();
+    expect(other->value == var->value);
+  };
+};
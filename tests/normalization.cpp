@@ -0,0 +1,122 @@
+#include <boost/ut.hpp>
+#include <dllib/normalization.hpp>
+#include <dllib/optimizer.hpp>
+#include <dllib/serialization.hpp>
+
+#include <cmath>
+#include <random>
+#include <sstream>
+
+#include "helpers.hpp"
+
+namespace ut = boost::ut;
+
+using test_helpers::Randomize;
+using test_helpers::MatchesNumericGradient;
+
+namespace {
+
+constexpr size_t Batch = 4, Features = 3;
+
+}  // namespace
+
+static ut::suite normalization_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  "layer_norm_forward"_test = [] {
+    LayerNorm<double, 4> norm;
+    TTensor<double, 2, 4> x = {{1, 2, 3, 4}, {1e6, 1e6 + 1, 1e6 + 2, 1e6 + 3}};
+    auto result = norm(x);
+
+    //  Both rows are the same up to a shift, the large offset doesn't lose precision
+    double inv_std = 1 / std::sqrt(1.25 + 1e-5);
+    TTensor<double, 4> expected = {-1.5 * inv_std, -0.5 * inv_std, 0.5 * inv_std, 1.5 * inv_std};
+    expect(AllClose(result[0], expected, 1e-9));
+    expect(AllClose(result[1], expected, 1e-9));
+    expect(AllClose(norm(TVariable(x, false))->value, result));
+  };
+
+  "layer_norm_backward"_test = [] {
+    std::mt19937 gen(1);
+    LayerNorm<double, Features> norm;
+    auto [scale, shift] = norm.GetParameters();
+    Randomize(scale->value, gen, 1, 2);
+    Randomize(shift->value, gen, 1, 2);
+    TVariable<TTensor<double, Batch, Features>> x(true);
+    TTensor<double, Batch, Features> weights;
+    Randomize(x->value, gen, 1, 2);
+    Randomize(weights, gen, 1, 2);
+
+    auto loss = [&] {
+      return Sum(norm(x) * TVariable(weights, false));
+    };
+    auto loss_value = [&loss] {
+      TNoGradGuard guard;
+      return double(loss()->value);
+    };
+
+    loss()->Backward();
+    ForEachParameter([&loss_value](auto& var) {
+      expect(MatchesNumericGradient(loss_value, var));
+    }, norm);
+    expect(MatchesNumericGradient(loss_value, x));
+  };
+
+  "batch_norm_backward"_test = [] {
+    std::mt19937 gen(2);
+    BatchNorm<double, Features> norm;
+    auto [scale, shift] = norm.GetParameters();
+    Randomize(scale->value, gen, 1, 2);
+    Randomize(shift->value, gen, 1, 2);
+    TVariable<TTensor<double, Batch, Features>> x(true);
+    TTensor<double, Batch, Features> weights;
+    Randomize(x->value, gen, 1, 2);
+    Randomize(weights, gen, 1, 2);
+
+    //  Evaluated with gradients enabled, the batch statistics are what's being differentiated
+    auto loss = [&] {
+      return Sum(norm(x) * TVariable(weights, false));
+    };
+    auto loss_value = [&loss] {
+      return double(loss()->value);
+    };
+
+    loss()->Backward();
+    ForEachParameter([&loss_value](auto& var) {
+      expect(MatchesNumericGradient(loss_value, var));
+    }, norm);
+    expect(MatchesNumericGradient(loss_value, x));
+  };
+
+  "batch_norm_running_statistics"_test = [] {
+    BatchNorm<float, 2> norm(0.5f);
+    TTensor<float, 4, 2> x = {{1, 10}, {2, 10}, {3, 10}, {4, 10}};
+    auto training = norm(TVariable(x, true));
+    expect(lt(std::abs(float(Sum(training->value))), 1e-5));
+
+    //  Unbiased variance of 1, 2, 3, 4 is 5 / 3
+    expect(AllClose(norm.GetRunningMean(), TTensor<float, 2>{1.25, 5}));
+    expect(AllClose(norm.GetRunningVariance(), TTensor<float, 2>{0.5f + 5.f / 6, 0.5}));
+    norm(TVariable(x, true));
+    expect(AllClose(norm.GetRunningMean(), TTensor<float, 2>{1.875, 7.5}));
+
+    //  Inference uses the running statistics, for tensors and without gradients alike
+    TTensor<float, 1, 2> sample = {{1.875, 7.5}};
+    auto inference = norm(sample);
+    expect(AllClose(inference, TTensor<float, 1, 2>(0)));
+    {
+      TNoGradGuard guard;
+      expect(AllClose(norm(TVariable(sample, false))->value, inference));
+    }
+    expect(AllClose(norm.GetRunningMean(), TTensor<float, 2>{1.875, 7.5}));
+
+    std::stringstream ss;
+    Dump(ss, norm);
+    BatchNorm<float, 2> loaded;
+    Load(ss, loaded);
+    expect(AllClose(loaded.GetRunningMean(), norm.GetRunningMean()));
+    expect(AllClose(loaded.GetRunningVariance(), norm.GetRunningVariance()));
+    expect(AllClose(loaded(sample), inference));
+  };
+};
@@ -1,7 +1,9 @@
 #include <boost/ut.hpp>
 #include <dllib/optimizer.hpp>
+#include <algorithm>
 #include <sstream>
 #include <memory>
+#include <random>
 
 namespace ut = boost::ut;
 
@@ -102,4 +104,131 @@ static ut::suite optimizer_tests = [] {
       expect(AllClose(v->value, Tensor<2, 1>({{0.8024092}, {2.8004302}})));
     }
   };
+
+  "quantized_state"_test = [] {
+    constexpr size_t Size = 100;
+    std::mt19937 gen(1);
+    std::normal_distribution<double> dist;
+    double values[2][64] = {}, decoded[64];
+    for (size_t i = 0; i < Size; ++i) {
+      //  Magnitudes from 1 down to 1e-4 in every block
+      values[i / 64][i % 64] = dist(gen) * std::pow(10., -double(i % 5));
+    }
+    helpers::TQuantizedState<Size, true> state;
+    helpers::TQuantizedState<Size, false> squares;
+    bool close = true, positive = true;
+    for (size_t block = 0; block < 2; ++block) {
+      state.StoreBlock(block, values[block]);
+      state.LoadBlock(block, decoded);
+      double scale = 0;
+      for (double x : values[block]) {
+        scale = std::max(scale, std::abs(x));
+      }
+      for (size_t i = 0; i < 64; ++i) {
+        //  The fourth root is rounded to a code step of 1 / 127, off by at most half a step
+        double x = values[block][i], root = std::sqrt(std::sqrt(std::abs(x) / scale));
+        close = close && std::abs(decoded[i] - x) <= scale * (std::pow(root + 0.5 / 127, 4) - std::pow(root, 4));
+      }
+
+      double square[64];
+      for (size_t i = 0; i < 64; ++i) {
+        square[i] = values[block][i] * values[block][i];
+      }
+      squares.StoreBlock(block, square);
+      squares.LoadBlock(block, decoded);
+      for (size_t i = 0; i < 64; ++i) {
+        positive = positive && (square[i] > 0) == (decoded[i] > 0);
+      }
+    }
+    expect(close);
+    expect(positive);
+    expect(eq(sizeof(state), 128 + 2 * sizeof(float)));
+
+    //  The max of the block underflows the float scale, zeros must stay zeros
+    std::fill_n(values[0], 64, 1e-50);
+    values[0][0] = 0;
+    state.StoreBlock(0, values[0]);
+    state.LoadBlock(0, decoded);
+    expect(std::all_of(decoded, decoded + 64, [](double x) {
+      return x == 0;
+    }));
+  };
+
+  "quantized_momentum"_test = [f] {
+    TVariable<Tensor<2, 1>> v({{1}, {3}}, true);
+    std::stringstream ss;
+    {
+      TQuantizedMomentumOptimizerUnit opt(v, /* lr = */ .1, /* alpha = */ .9);
+      f(v)->Backward();
+      opt.Step();
+      expect(AllClose(v->value, Tensor<2, 1>({{0.8}, {1.8}})));
+      Dump(ss, opt);
+    }
+    {
+      TQuantizedMomentumOptimizerUnit opt(v, /* lr = */ .1, /* alpha = */ .9);
+      Load(ss, opt);
+      f(v)->Backward();
+      opt.Step();
+      expect(AllClose(v->value, Tensor<2, 1>({{0.46}, {0}}), 1e-2));
+    }
+  };
+
+  "quantized_adam"_test = [f] {
+    TVariable<Tensor<2, 1>> v({{1}, {3}}, true);
+    std::stringstream ss;
+    {
+      TQuantizedAdamOptimizerUnit opt(v, /* lr = */ .1, /* beta1 = */ .9, /* beta2 = */ 0.99, /* eps = */ 2e-2);
+      f(v)->Backward();
+      opt.Step();
+      expect(AllClose(v->value, Tensor<2, 1>({{0.9009901}, {2.9001663}})));
+      Dump(ss, opt);
+    }
+    {
+      TQuantizedAdamOptimizerUnit opt(v, /* lr = */ .1, /* beta1 = */ .9, /* beta2 = */ 0.99, /* eps = */ 2e-2);
+      Load(ss, opt);
+      f(v)->Backward();
+      opt.Step();
+      expect(AllClose(v->value, Tensor<2, 1>({{0.8024092}, {2.8004302}}), 1e-2));
+    }
+  };
+
+  "quantized_adam_converges"_test = [] {
+    //  Linear regression with weights spread over several orders of magnitude
+    constexpr size_t Batch = 16, From = 100;
+    std::mt19937 gen(2);
+    std::normal_distribution<float> dist;
+    TTensor<float, From, 1> target;
+    for (size_t i = 0; i < From; ++i) {
+      target[i][0] = dist(gen) * std::pow(10.f, -float(i % 3));
+    }
+    TVariable<TTensor<float, From, 1>> full(TTensor<float, From, 1>(0), true);
+    TVariable<TTensor<float, From, 1>> quantized(TTensor<float, From, 1>(0), true);
+    auto full_opt = MakeOptimizerManager<TAdamOptimizerUnit>(0.01f);
+    auto quantized_opt = MakeOptimizerManager<TQuantizedAdamOptimizerUnit>(0.01f);
+    full_opt.AddParameter(full);
+    quantized_opt.AddParameter(quantized);
+
+    auto loss = [&target](const auto& weights, const auto& x) {
+      TTensor<float, Batch, 1> y(0);
+      MatrixProduct(x, target, y);
+      auto error = MatrixProduct(TVariable(x, false), weights) - TVariable(y, false);
+      return Sum(error * error);
+    };
+    float full_loss = 0, quantized_loss = 0;
+    for (size_t step = 0; step < 1000; ++step) {
+      TTensor<float, Batch, From> x;
+      for (auto& value : x.View<-1u>()) {
+        value = dist(gen);
+      }
+      auto l = loss(full, x), q = loss(quantized, x);
+      full_loss = l->value.Data();
+      quantized_loss = q->value.Data();
+      l->Backward();
+      q->Backward();
+      full_opt.Step();
+      quantized_opt.Step();
+    }
+    expect(lt(quantized_loss, 1e-2f * Batch));
+    expect(lt(quantized_loss, 2 * full_loss + 1e-3f));
+  };
 };
@@ -0,0 +1,155 @@
+#include <boost/ut.hpp>
+#include <dllib/checkpoint.hpp>
+#include <dllib/parallel.hpp>
+
+#include <random>
+
+namespace ut = boost::ut;
+
+static ut::suite parallel_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  "thread_pool"_test = [] {
+    TThreadPool pool(4);
+    std::atomic<size_t> counter = 0;
+    for (size_t i = 0; i < 100; ++i) {
+      pool.Submit([&pool, &counter] {
+        for (size_t j = 0; j < 10; ++j) {
+          pool.Submit([&counter] {
+            counter.fetch_add(1);
+          });
+        }
+        counter.fetch_add(1);
+      });
+    }
+    pool.Wait();
+    expect(eq(counter.load(), 1100u));
+  };
+
+  "thread_pool_exception"_test = [] {
+    TThreadPool pool(4);
+    for (size_t i = 0; i < 100; ++i) {
+      pool.Submit([i] {
+        if (i % 10 == 3) {
+          throw std::runtime_error("task failed");
+        }
+      });
+    }
+    expect(throws<std::runtime_error>([&pool] {
+      pool.Wait();
+    }));
+
+    std::atomic<size_t> counter = 0;
+    pool.Submit([&counter] {
+      counter.fetch_add(1);
+    });
+    expect(nothrow([&pool] {
+      pool.Wait();
+    }));
+    expect(eq(counter.load(), 1u));
+  };
+
+  "parallel_backward"_test = [] {
+    using TMatrix = TTensor<float, 8, 8>;
+
+    std::mt19937 gen(123);
+    std::normal_distribution<float> dist;
+    auto random_matrix = [&gen, &dist] {
+      TMatrix result;
+      for (auto& x : result.View<-1u>()) {
+        x = dist(gen);
+      }
+      return result;
+    };
+
+    TVariable<TMatrix> shared(random_matrix(), true);
+    std::vector<TVariable<TMatrix>> inputs;
+    for (size_t i = 0; i < 16; ++i) {
+      inputs.emplace_back(random_matrix(), true);
+    }
+
+    auto build = [&shared, &inputs] {
+      TVariable<TMatrix> total = Tanh(MatrixProduct(inputs[0], shared));
+      for (size_t i = 1; i < inputs.size(); ++i) {
+        total = total + Tanh(MatrixProduct(inputs[i], shared)) * inputs[i];
+      }
+      return Sum(total * total);
+    };
+
+    build()->Backward();
+    auto expected_shared = shared->grad;
+    std::vector<TMatrix> expected_inputs;
+    for (auto& input : inputs) {
+      expected_inputs.push_back(input->grad);
+      input->ZeroGrad();
+    }
+    shared->ZeroGrad();
+
+    TThreadPool pool(4);
+    ParallelBackward(build(), pool);
+
+    expect(AllClose(shared->grad, expected_shared, 1e-3));
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      expect(AllClose(inputs[i]->grad, expected_inputs[i], 1e-3));
+    }
+  };
+
+  "parallel_backward_checkpoints"_test = [] {
+    using TMatrix = TTensor<float, 4, 4>;
+
+    std::mt19937 gen(7);
+    std::normal_distribution<float> dist;
+    auto random_matrix = [&gen, &dist] {
+      TMatrix result;
+      for (auto& x : result.View<-1u>()) {
+        x = dist(gen);
+      }
+      return result;
+    };
+
+    //  The checkpointed segments write the gradient of `shared`, which is not an argument of their nodes
+    TVariable<TMatrix> shared(random_matrix(), true);
+    std::vector<TVariable<TMatrix>> inputs;
+    for (size_t i = 0; i < 16; ++i) {
+      inputs.emplace_back(random_matrix(), true);
+    }
+
+    auto build = [&shared, &inputs] {
+      TVariable<TMatrix> total = MatrixProduct(inputs[0], shared);
+      for (size_t i = 1; i < inputs.size(); ++i) {
+        total = total + Checkpoint([&shared](const TVariable<TMatrix>& x) {
+          return Tanh(MatrixProduct(x, shared));
+        }, inputs[i]);
+      }
+      return Sum(total * total);
+    };
+
+    build()->Backward();
+    auto expected_shared = shared->grad;
+    shared->ZeroGrad();
+    for (auto& input : inputs) {
+      input->ZeroGrad();
+    }
+
+    TThreadPool pool(4);
+    for (size_t attempt = 0; attempt < 10; ++attempt) {
+      ParallelBackward(build(), pool);
+      expect(AllClose(shared->grad, expected_shared, 1e-3));
+      shared->ZeroGrad();
+    }
+  };
+
+  "parallel_backward_exception"_test = [] {
+    TVariable<TTensor<float, 2>> w({1, 2}, true);
+    TVariable<TTensor<float, 2>> x({3, 4}, false);
+    TVariable<TTensor<float, 2>> y({5, 6}, false);
+
+    auto saved = Sum(Tanh(x * w) + x * w);
+    AddInplace(x, y);
+    TThreadPool pool(2);
+    expect(throws<std::runtime_error>([&saved, &pool] {
+      ParallelBackward(saved, pool);
+    }));
+  };
+};
@@ -0,0 +1,111 @@
+#include <boost/ut.hpp>
+#include <dllib/per_sample.hpp>
+
+#include <cmath>
+#include <random>
+
+namespace ut = boost::ut;
+
+static ut::suite per_sample_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  constexpr size_t Batch = 5, In = 4, Out = 3;
+  using TInput = TTensor<float, Batch, In>;
+  using TOutput = TTensor<float, Batch, Out>;
+
+  std::mt19937 gen(7);
+  std::normal_distribution<float> dist;
+  TInput inp;
+  TOutput expected;
+  for (auto& x : inp.View<-1u>()) {
+    x = dist(gen);
+  }
+  for (auto& x : expected.View<-1u>()) {
+    x = dist(gen);
+  }
+
+  "matches_sample_loop"_test = [inp, expected] {
+    FullyConnected<float, In, Out> fc;
+    auto grads = PerSampleGradients(fc, inp, [&expected](const auto& out) {
+      auto diff = out - TVariable(expected, false);
+      return Sum(diff * diff);
+    });
+
+    auto [weights, bias_layer] = fc.GetParameters();
+    auto& bias = get<0>(bias_layer.GetParameters());
+    expect(eq(Sum(weights->grad * weights->grad), 0.f));
+
+    for (size_t b = 0; b < Batch; ++b) {
+      TTensor<float, 1, In> sample_inp({inp[b]});
+      TTensor<float, 1, Out> sample_expected({expected[b]});
+      auto diff = TVariable(sample_expected, false) - fc(TVariable(sample_inp, false));
+      Sum(diff * diff)->Backward();
+
+      expect(AllClose(grads.weights[b], weights->grad, 1e-4));
+      expect(AllClose(grads.bias[b], bias->grad, 1e-4));
+      float norm = std::sqrt(Sum(weights->grad * weights->grad) + Sum(bias->grad * bias->grad));
+      expect(std::abs(float(grads.norms[b]) - norm) < 1e-4);
+
+      weights->ZeroGrad();
+      bias->ZeroGrad();
+    }
+  };
+
+  "clipping"_test = [inp, expected] {
+    FullyConnected<float, In, Out> fc;
+    auto loss = [&expected](const auto& out) {
+      auto diff = out - TVariable(expected, false);
+      return Sum(diff * diff);
+    };
+    auto unclipped = PerSampleGradients(fc, inp, loss);
+    auto clipped = PerSampleGradients(fc, inp, loss, 0.5f);
+
+    for (size_t b = 0; b < Batch; ++b) {
+      float norm = std::sqrt(Sum(clipped.weights[b] * clipped.weights[b]) + Sum(clipped.bias[b] * clipped.bias[b]));
+      float scale = std::min(1.f, 0.5f / float(unclipped.norms[b]));
+      expect(norm < 0.5f + 1e-4);
+      expect(AllClose(clipped.weights[b], unclipped.weights[b] * scale, 1e-4));
+    }
+
+    AccumulateGradients(fc, clipped);
+    auto [weights, bias_layer] = fc.GetParameters();
+    TTensor<float, In, Out> total(0);
+    for (size_t b = 0; b < Batch; ++b) {
+      total += clipped.weights[b];
+    }
+    expect(AllClose(weights->grad, total));
+
+    FullyConnected<float, In, Out> fused_fc = fc;
+    auto [fused_weights, fused_bias_layer] = fused_fc.GetParameters();
+    fused_weights = TVariable(fused_weights->value, true);
+    auto norms = AccumulateClippedGradients(fused_fc, inp, loss, 0.5f);
+    expect(AllClose(fused_weights->grad, total, 1e-4));
+    expect(AllClose(norms, unclipped.norms));
+  };
+
+  "bias_and_input_grad"_test = [inp, expected] {
+    Bias<float, In> bias;
+    TVariable<TInput> x(inp, true);
+    auto grads = PerSampleGradients(bias, x, [](const auto& out) {
+      return Sum(out * out);
+    });
+
+    auto& b = get<0>(bias.GetParameters());
+    for (size_t i = 0; i < Batch; ++i) {
+      TTensor<float, In> expected_grad = (inp[i] + b->value) * 2.f;
+      expect(AllClose(grads.bias[i], expected_grad, 1e-5));
+      expect(AllClose(x->grad[i], expected_grad, 1e-5));
+    }
+  };
+
+  "no_grad"_test = [inp] {
+    FullyConnected<float, In, Out> fc;
+    TNoGradGuard guard;
+    expect(throws<std::runtime_error>([&fc, &inp] {
+      PerSampleGradients(fc, inp, [](const auto& out) {
+        return Sum(out * out);
+      });
+    }));
+  };
+};
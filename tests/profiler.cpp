@@ -0,0 +1,66 @@
+#include <boost/ut.hpp>
+#include <dllib/autograd.hpp>
+#include <dllib/profiler.hpp>
+
+#include <sstream>
+
+namespace ut = boost::ut;
+
+static ut::suite profiler_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  "profiler"_test = [] {
+    TVariable<TTensor<float, 2, 3>> a(TTensor<float, 2, 3>(1.f), true);
+    TVariable<TTensor<float, 3, 4>> b(TTensor<float, 3, 4>(2.f), true);
+
+    auto& profiler = TProfiler::Get();
+    profiler.Clear();
+    profiler.Start();
+    Sum(Tanh(MatrixProduct(a, b)))->Backward();
+    profiler.Stop();
+    //  Not recorded
+    Sum(a)->Backward();
+
+    auto events = profiler.GetEvents();
+#ifdef DLLIB_PROFILE
+    expect(eq(events.size(), 6u));
+
+    size_t forward = 0;
+    for (const auto& event : events) {
+      forward += event.phase == TProfiler::EPhase::Forward;
+    }
+    expect(eq(forward, 3u));
+
+    const auto& product = *events.front().operation;
+    expect(eq(product.name, std::string("TMatrixProduct")));
+    expect(eq(product.shapes, std::string("[2, 3], [3, 4] -> [2, 4]")));
+    expect(eq(events.front().bytes, (6u + 12u + 8u) * sizeof(float)));
+
+    std::stringstream trace;
+    profiler.WriteChromeTrace(trace);
+    expect(trace.str().find("\"traceEvents\"") != std::string::npos);
+    expect(trace.str().find("\"name\":\"TTanh\",\"cat\":\"backward\"") != std::string::npos);
+
+    std::stringstream summary;
+    profiler.WriteSummary(summary);
+    expect(summary.str().find("TSum") != std::string::npos);
+#else
+    expect(events.empty());
+#endif
+    profiler.Clear();
+  };
+
+  "profiler_trace_escaping"_test = [] {
+    TProfiler::TOperationInfo info{"T\"quoted\"\\name\n", "\t[2]\x01"};
+    auto& profiler = TProfiler::Get();
+    profiler.Clear();
+    profiler.Record({&info, TProfiler::EPhase::Forward, 0, 1000, 8, 0});
+
+    std::stringstream trace;
+    profiler.WriteChromeTrace(trace);
+    expect(trace.str().find(R"("name":"T\"quoted\"\\name\u000a")") != std::string::npos);
+    expect(trace.str().find(R"("shapes":"\u0009[2]\u0001")") != std::string::npos);
+    profiler.Clear();
+  };
+};
@@ -0,0 +1,199 @@
+#include <boost/ut.hpp>
+#include <dllib/optimizer.hpp>
+#include <dllib/recurrent.hpp>
+
+#include <cmath>
+#include <random>
+
+#include "helpers.hpp"
+
+namespace ut = boost::ut;
+
+using test_helpers::Randomize;
+using test_helpers::MatchesNumericGradient;
+
+namespace {
+
+constexpr size_t Batch = 2, In = 3, Hidden = 4;
+
+double SigmoidOf(double x) {
+  return 1 / (1 + std::exp(-x));
+}
+
+}  // namespace
+
+static ut::suite recurrent_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  "lstm_forward"_test = [] {
+    std::mt19937 gen(1);
+    auto normal = [&gen, dist = std::normal_distribution<double>()]() mutable {
+      return dist(gen);
+    };
+    LSTMCell<double, In, Hidden> cell(normal);
+    auto [weights, bias] = cell.GetParameters();
+
+    TTensor<double, Batch, In> x;
+    TTensor<double, Batch, 2 * Hidden> state;
+    Randomize(x, gen);
+    Randomize(state, gen);
+    auto result = cell(x, state);
+
+    bool matches = true;
+    for (size_t b = 0; b < Batch; ++b) {
+      for (size_t j = 0; j < Hidden; ++j) {
+        double gates[4];
+        for (size_t gate = 0; gate < 4; ++gate) {
+          double sum = bias->value[gate * Hidden + j];
+          for (size_t k = 0; k < In; ++k) {
+            sum += x[b][k] * weights->value[k][gate * Hidden + j];
+          }
+          for (size_t k = 0; k < Hidden; ++k) {
+            sum += state[b][k] * weights->value[In + k][gate * Hidden + j];
+          }
+          gates[gate] = gate == 2 ? std::tanh(sum) : SigmoidOf(sum);
+        }
+        double c = gates[1] * state[b][Hidden + j] + gates[0] * gates[2];
+        matches = matches && std::abs(result[b][Hidden + j] - c) < 1e-12;
+        matches = matches && std::abs(result[b][j] - gates[3] * std::tanh(c)) < 1e-12;
+      }
+    }
+    expect(matches);
+  };
+
+  "gru_forward"_test = [] {
+    std::mt19937 gen(2);
+    auto normal = [&gen, dist = std::normal_distribution<double>()]() mutable {
+      return dist(gen);
+    };
+    GRUCell<double, In, Hidden> cell(normal);
+    auto [input_weights, state_weights, input_bias, state_bias] = cell.GetParameters();
+
+    TTensor<double, Batch, In> x;
+    TTensor<double, Batch, Hidden> h;
+    Randomize(x, gen);
+    Randomize(h, gen);
+    auto result = cell(x, h);
+
+    bool matches = true;
+    for (size_t b = 0; b < Batch; ++b) {
+      for (size_t j = 0; j < Hidden; ++j) {
+        double input_gates[3], state_gates[3];
+        for (size_t gate = 0; gate < 3; ++gate) {
+          input_gates[gate] = input_bias->value[gate * Hidden + j];
+          state_gates[gate] = state_bias->value[gate * Hidden + j];
+          for (size_t k = 0; k < In; ++k) {
+            input_gates[gate] += x[b][k] * input_weights->value[k][gate * Hidden + j];
+          }
+          for (size_t k = 0; k < Hidden; ++k) {
+            state_gates[gate] += h[b][k] * state_weights->value[k][gate * Hidden + j];
+          }
+        }
+        double r = SigmoidOf(input_gates[0] + state_gates[0]);
+        double z = SigmoidOf(input_gates[1] + state_gates[1]);
+        double n = std::tanh(input_gates[2] + r * state_gates[2]);
+        matches = matches && std::abs(result[b][j] - ((1 - z) * n + z * h[b][j])) < 1e-12;
+      }
+    }
+    expect(matches);
+  };
+
+  "lstm_backward"_test = [] {
+    std::mt19937 gen(3);
+    LSTMCell<double, In, Hidden> cell;
+    TVariable<TTensor<double, Batch, In>> x1(true), x2(true);
+    TVariable<TTensor<double, Batch, 2 * Hidden>> initial(true);
+    TTensor<double, Batch, Hidden> hidden_weights;
+    TTensor<double, Batch, 2 * Hidden> state_weights;
+    Randomize(x1->value, gen);
+    Randomize(x2->value, gen);
+    Randomize(initial->value, gen);
+    Randomize(hidden_weights, gen);
+    Randomize(state_weights, gen);
+
+    //  Two steps, the loss reads the hidden state through GetHidden and the whole state directly
+    auto loss = [&] {
+      auto state = cell(x2, cell(x1, initial));
+      auto hidden = LSTMCell<double, In, Hidden>::GetHidden(state);
+      return Sum(hidden * TVariable(hidden_weights, false)) + Sum(state * TVariable(state_weights, false));
+    };
+    auto loss_value = [&loss] {
+      TNoGradGuard guard;
+      return double(loss()->value);
+    };
+
+    loss()->Backward();
+    ForEachParameter([&loss_value](auto& var) {
+      expect(MatchesNumericGradient(loss_value, var));
+    }, cell);
+    expect(MatchesNumericGradient(loss_value, x1));
+    expect(MatchesNumericGradient(loss_value, x2));
+    expect(MatchesNumericGradient(loss_value, initial));
+  };
+
+  "gru_backward"_test = [] {
+    std::mt19937 gen(4);
+    GRUCell<double, In, Hidden> cell;
+    TVariable<TTensor<double, Batch, In>> x1(true), x2(true);
+    TVariable<TTensor<double, Batch, Hidden>> initial(true);
+    TTensor<double, Batch, Hidden> output_weights;
+    Randomize(x1->value, gen);
+    Randomize(x2->value, gen);
+    Randomize(initial->value, gen);
+    Randomize(output_weights, gen);
+
+    auto loss = [&] {
+      return Sum(cell(x2, cell(x1, initial)) * TVariable(output_weights, false));
+    };
+    auto loss_value = [&loss] {
+      TNoGradGuard guard;
+      return double(loss()->value);
+    };
+
+    loss()->Backward();
+    size_t count = 0;
+    ForEachParameter([&loss_value, &count](auto& var) {
+      ++count;
+      expect(MatchesNumericGradient(loss_value, var));
+    }, cell);
+    expect(eq(count, 4u));
+    expect(MatchesNumericGradient(loss_value, x1));
+    expect(MatchesNumericGradient(loss_value, x2));
+    expect(MatchesNumericGradient(loss_value, initial));
+  };
+
+  "recurrent_training"_test = [] {
+    //  Learn to output the sum of a short sequence of inputs
+    constexpr size_t Steps = 3;
+    std::mt19937 gen(5);
+    LSTMCell<float, 1, 8> cell([&gen, dist = std::normal_distribution<float>(0, 0.3)]() mutable {
+      return dist(gen);
+    });
+    auto optimizer = MakeOptimizerManager<TAdamOptimizerUnit>(0.02f);
+    optimizer.AddParameter(cell);
+
+    std::uniform_real_distribution<float> uniform(-0.3, 0.3);
+    auto loss = [&] {
+      auto state = LSTMCell<float, 1, 8>::InitialState<16>();
+      TTensor<float, 16, 8> expected(0);
+      for (size_t step = 0; step < Steps; ++step) {
+        TTensor<float, 16, 1> x;
+        for (size_t b = 0; b < 16; ++b) {
+          x[b][0] = uniform(gen);
+          expected[b][0] += x[b][0];
+        }
+        state = cell(TVariable(x, false), state);
+      }
+      auto diff = LSTMCell<float, 1, 8>::GetHidden(state) - TVariable(expected, false);
+      return Sum(diff * diff);
+    };
+
+    float first = loss()->value;
+    for (size_t i = 0; i < 300; ++i) {
+      loss()->Backward();
+      optimizer.Step();
+    }
+    expect(lt(float(loss()->value), first / 4));
+  };
+};
@@ -0,0 +1,173 @@
+#include <boost/ut.hpp>
+#include <dllib/loss.hpp>
+#include <dllib/optimizer.hpp>
+#include <dllib/sequential.hpp>
+
+#include <memory>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "helpers.hpp"
+
+namespace ut = boost::ut;
+
+using test_helpers::Randomize;
+
+namespace {
+
+constexpr size_t Batch = 4;
+
+using TInput = dllib::TTensor<double, Batch, 3>;
+using TModel = dllib::Sequential<
+  TInput,
+  dllib::FullyConnected<double, 3, 5>,
+  dllib::TanhActivation,
+  dllib::LayerNorm<double, 5>,
+  dllib::FullyConnected<double, 5, 4>,
+  dllib::ReLUActivation,
+  dllib::BatchNorm<double, 4>,
+  dllib::FullyConnected<double, 4, 2>,
+  dllib::SigmoidActivation>;
+
+//  The same layers chained by hand, a node per layer
+template<class T>
+auto ApplyLayers(TModel& model, const T& x) {
+  auto hidden = model.GetLayer<2>()(model.GetLayer<1>()(model.GetLayer<0>()(x)));
+  auto normalized = model.GetLayer<5>()(model.GetLayer<4>()(model.GetLayer<3>()(hidden)));
+  return model.GetLayer<7>()(model.GetLayer<6>()(normalized));
+}
+
+}  // namespace
+
+static ut::suite sequential_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  "sequential_matches_layers"_test = [] {
+    std::mt19937 gen(1);
+    auto model = std::make_unique<TModel>();
+    TVariable<TInput> x(true);
+    TTensor<double, Batch, 2> grad;
+    Randomize(x->value, gen);
+    Randomize(grad, gen);
+
+    auto result = ApplyLayers(*model, x);
+    result->Backward(grad);
+    TInput expected_x_grad = x->grad;
+    std::vector<std::vector<double>> expected_grads;
+    ForEachParameter([&expected_grads](auto& var) {
+      const auto& grad = var->grad.template View<-1u>();
+      expected_grads.emplace_back(grad.begin(), grad.end());
+      var->ZeroGrad();
+    }, *model);
+
+    expect(AllClose(model->Forward(x->value), result->value, 1e-12));
+    TInput x_grad(0);
+    model->Backward(grad, &x_grad);
+    expect(AllClose(x_grad, expected_x_grad, 1e-12));
+    size_t i = 0;
+    bool grads_match = true;
+    ForEachParameter([&expected_grads, &i, &grads_match](auto& var) {
+      const auto& grad = var->grad.template View<-1u>();
+      for (size_t j = 0; j < grad.Size(); ++j) {
+        grads_match = grads_match && std::abs(grad[j] - expected_grads[i][j]) < 1e-12;
+      }
+      ++i;
+    }, *model);
+    expect(eq(i, 10u));
+    expect(grads_match);
+
+    //  Inference uses the running statistics of BatchNorm, as the layers do on tensors
+    expect(AllClose((*model)(x->value), ApplyLayers(*model, x->value), 1e-12));
+  };
+
+  "sequential_as_node"_test = [] {
+    std::mt19937 gen(2);
+    auto model = std::make_unique<TModel>();
+    TVariable<TInput> x(true);
+    Randomize(x->value, gen);
+
+    auto result = (*model)(x);
+    expect(AllClose(result->value, ApplyLayers(*model, x)->value, 1e-12));
+    MeanSquaredError(result, TTensor<double, Batch, 2>(0.5))->Backward();
+
+    TInput fused_grad = x->grad;
+    x->ZeroGrad();
+    ForEachParameter([](auto& var) {
+      var->ZeroGrad();
+    }, *model);
+    MeanSquaredError(ApplyLayers(*model, x), TTensor<double, Batch, 2>(0.5))->Backward();
+    expect(AllClose(fused_grad, x->grad, 1e-12));
+
+    //  A later call overwrites the activations the first node would need
+    auto first = (*model)(x);
+    (*model)(x);
+    expect(throws([&first] { Sum(first)->Backward(); }));
+
+    //  So does destroying the model
+    auto last = (*model)(x);
+    model.reset();
+    expect(throws<std::runtime_error>([&last] { Sum(last)->Backward(); }));
+  };
+
+  "sequential_training"_test = [] {
+    std::mt19937 gen(3);
+    Sequential<
+      TTensor<float, 16, 2>,
+      FullyConnected<float, 2, 16>,
+      TanhActivation,
+      FullyConnected<float, 16, 1>> model;
+    auto optimizer = MakeOptimizerManager<TAdamOptimizerUnit>(0.01f);
+    optimizer.AddParameter(model);
+
+    //  Fit x * y on [-1, 1]^2 with the tensor-level passes only
+    std::uniform_real_distribution<float> uniform(-1, 1);
+    auto loss = [&](bool train) {
+      TTensor<float, 16, 2> x;
+      TTensor<float, 16, 1> grad;
+      float total = 0;
+      for (size_t b = 0; b < 16; ++b) {
+        x[b][0] = uniform(gen);
+        x[b][1] = uniform(gen);
+      }
+      const auto& result = model.Forward(x);
+      for (size_t b = 0; b < 16; ++b) {
+        float diff = result[b][0] - x[b][0] * x[b][1];
+        total += diff * diff;
+        grad[b][0] = 2 * diff / 16;
+      }
+      if (train) {
+        model.Backward(grad);
+        optimizer.Step();
+      }
+      return total / 16;
+    };
+
+    float first = 0, last = 0;
+    for (size_t i = 0; i < 10; ++i) {
+      first += loss(false);
+    }
+    for (size_t i = 0; i < 2000; ++i) {
+      loss(true);
+    }
+    for (size_t i = 0; i < 10; ++i) {
+      last += loss(false);
+    }
+    expect(lt(last, first / 4));
+  };
+
+  "sequential_serialization"_test = [] {
+    auto model = std::make_unique<TModel>();
+    TInput x;
+    std::mt19937 gen(4);
+    Randomize(x, gen);
+    model->Forward(x);
+
+    std::stringstream ss;
+    Dump(ss, *model);
+    auto loaded = std::make_unique<TModel>();
+    Load(ss, *loaded);
+    expect(AllClose((*loaded)(x), (*model)(x)));
+  };
+};
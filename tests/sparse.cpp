@@ -0,0 +1,171 @@
+#include <boost/ut.hpp>
+#include <dllib/optimizer.hpp>
+#include <dllib/serialization.hpp>
+#include <dllib/sparse.hpp>
+
+#include <cmath>
+#include <random>
+#include <sstream>
+
+#include "helpers.hpp"
+
+namespace ut = boost::ut;
+
+using test_helpers::Randomize;
+
+namespace {
+
+constexpr size_t Batch = 3, From = 8, To = 12;
+
+using TSparse = dllib::BlockSparseFullyConnected<double, From, To, 2, 4>;
+using TDense = dllib::FullyConnected<double, From, To>;
+
+//  Gradients of the weights and the bias of a layer
+template<class TLayer>
+auto GetGradients(TLayer& layer) {
+  auto [weights, bias] = layer.GetParameters();
+  auto [bias_var] = bias.GetParameters();
+  return std::make_pair(weights->grad, bias_var->grad);
+}
+
+}  // namespace
+
+static ut::suite sparse_tests = [] {
+  using namespace ut;
+  using namespace dllib;
+
+  "block_sparse_matches_dense"_test = [] {
+    std::mt19937 gen(1);
+    TDense dense;
+    TSparse sparse(dense);
+    expect(eq(sparse.Sparsity(), 0.));
+
+    TVariable<TTensor<double, Batch, From>> x(true), sparse_x(true);
+    TTensor<double, Batch, To> grad;
+    Randomize(x->value, gen);
+    Randomize(grad, gen);
+    sparse_x->value = x->value;
+
+    auto expected = dense(x);
+    auto result = sparse(sparse_x);
+    expect(AllClose(result->value, expected->value, 1e-12));
+    expect(AllClose(sparse(x->value), expected->value, 1e-12));
+
+    expected->Backward(grad);
+    result->Backward(grad);
+    expect(AllClose(sparse_x->grad, x->grad, 1e-12));
+    auto [dense_weights, dense_bias] = GetGradients(dense);
+    auto [sparse_weights, sparse_bias] = GetGradients(sparse);
+    expect(AllClose(sparse_weights, dense_weights, 1e-12));
+    expect(AllClose(sparse_bias, dense_bias, 1e-12));
+  };
+
+  "block_sparse_pruning"_test = [] {
+    std::mt19937 gen(2);
+    TSparse sparse;
+    auto [weights, bias] = sparse.GetParameters();
+    TTensor<double, From, To> before = weights->value;
+
+    //  4 x 3 blocks, a quarter of them is removed
+    sparse.Prune(0.25);
+    expect(eq(sparse.Sparsity(), 0.25));
+    double max_pruned = 0, min_kept = 1e9;
+    size_t pruned = 0;
+    for (size_t i = 0; i < From; i += 2) {
+      for (size_t j = 0; j < To; j += 4) {
+        double norm = 0;
+        bool zero = true;
+        for (size_t r = i; r < i + 2; ++r) {
+          for (size_t c = j; c < j + 4; ++c) {
+            norm += before[r][c] * before[r][c];
+            zero = zero && double(weights->value[r][c]) == 0;
+            expect(double(weights->value[r][c]) == 0 || double(weights->value[r][c]) == double(before[r][c]));
+          }
+        }
+        if (zero) {
+          ++pruned;
+          max_pruned = std::max(max_pruned, norm);
+        } else {
+          min_kept = std::min(min_kept, norm);
+        }
+      }
+    }
+    expect(eq(pruned, 3u));
+    expect(lt(max_pruned, min_kept));
+
+    //  The skipped blocks get no gradient, the rest is the same as for the dense product
+    TVariable<TTensor<double, Batch, From>> x(true);
+    Randomize(x->value, gen);
+    auto result = sparse(x);
+    auto [bias_var] = bias.GetParameters();
+    expect(AllClose(result->value, helpers::AddBias(MatrixProduct(x->value, weights->value), bias_var->value), 1e-12));
+    Sum(result)->Backward();
+    auto [weights_grad, bias_grad] = GetGradients(sparse);
+    for (size_t i = 0; i < From; ++i) {
+      for (size_t j = 0; j < To; ++j) {
+        double dense_grad = 0;
+        for (size_t b = 0; b < Batch; ++b) {
+          dense_grad += x->value[b][i];
+        }
+        expect(eq(double(weights_grad[i][j]), double(weights->value[i][j]) == 0 ? 0. : dense_grad));
+      }
+    }
+
+    //  Pruning never brings blocks back
+    sparse.Prune(0.1);
+    expect(eq(sparse.Sparsity(), 0.25));
+  };
+
+  "pruning_schedule"_test = [] {
+    TPruningSchedule schedule{.initial_sparsity = 0, .final_sparsity = 0.5, .begin_step = 10, .end_step = 20, .frequency = 5};
+    expect(eq(schedule.SparsityAt(0), 0.));
+    expect(eq(schedule.SparsityAt(15), 0.5 - 0.5 * 0.125));
+    expect(eq(schedule.SparsityAt(100), 0.5));
+    expect(schedule.IsPruningStep(10) && schedule.IsPruningStep(15) && schedule.IsPruningStep(20));
+    expect(!schedule.IsPruningStep(12) && !schedule.IsPruningStep(25));
+
+    //  Momentum keeps moving the pruned weights, the hook puts them back to zero after every step
+    std::mt19937 gen(3);
+    TSparse sparse;
+    auto optimizer = MakeOptimizerManager<TMomentumOptimizerUnit>(0.01, 0.9);
+    optimizer.AddParameter(sparse);
+    AddPruning(optimizer, sparse, schedule);
+    auto [weights, bias] = sparse.GetParameters();
+    TTensor<double, Batch, From> x;
+    bool masked = true;
+    for (size_t step = 1; step <= 30; ++step) {
+      Randomize(x, gen);
+      Sum(sparse(TVariable(x, false)))->Backward();
+      optimizer.Step();
+      expect(ge(sparse.Sparsity(), schedule.SparsityAt(step / 5 * 5)));
+      size_t zeros = 0;
+      for (auto w : weights->value.View<-1u>()) {
+        zeros += double(w) == 0;
+      }
+      masked = masked && zeros == size_t(std::round(sparse.Sparsity() * From * To));
+    }
+    expect(masked);
+    expect(eq(sparse.Sparsity(), 0.5));
+  };
+
+  "block_sparse_serialization"_test = [] {
+    std::mt19937 gen(4);
+    TSparse sparse;
+    sparse.Prune(0.5);
+    TTensor<double, Batch, From> x;
+    Randomize(x, gen);
+
+    //  The format is the one of FullyConnected, loading restores the blocks
+    std::stringstream ss;
+    Dump(ss, sparse);
+    TDense dense;
+    Load(ss, dense);
+    expect(AllClose(dense(x), sparse(x), 1e-12));
+
+    ss.seekg(0);
+    TSparse loaded;
+    Load(ss, loaded);
+    expect(eq(loaded.Sparsity(), 0.5));
+    expect(AllClose(loaded(x), sparse(x), 1e-12));
+  };
+};
@@ -66,9 +66,40 @@ static ut::suite tensor_runtime_tests = [] {
       expect(eq(dllib::MatrixProduct(Tensor<4, 3>(data3), Tensor<3, 4>(data1)), Tensor<4, 4>(mul2)));
       expect(eq(dllib::MatrixProductTransposed(Tensor<3, 4>(data1), Tensor<4, 3>(data3).T()), Tensor<3, 3>(mul1)));
       expect(eq(dllib::MatrixProductTransposed(Tensor<4, 3>(data3), Tensor<3, 4>(data1).T()), Tensor<4, 4>(mul2)));
+      expect(eq(dllib::TransposedMatrixProduct(Tensor<3, 4>(data1).T(), Tensor<4, 3>(data3)), Tensor<3, 3>(mul1)));
+      expect(eq(dllib::TransposedMatrixProduct(Tensor<4, 3>(data3).T(), Tensor<3, 4>(data1)), Tensor<4, 4>(mul2)));
     };
   }
 
+  "wide_matrix_product"_test = [] {
+    //  Wider than a tile of the row buffer
+    constexpr size_t Width = 600;
+    Tensor<2, 3> left;
+    Tensor<3, Width> right;
+    Tensor<2, Width> expected;
+    for (size_t i = 0; i < 2; ++i) {
+      for (size_t j = 0; j < 3; ++j) {
+        left[i][j] = int(i + 2 * j);
+      }
+    }
+    for (size_t j = 0; j < 3; ++j) {
+      for (size_t k = 0; k < Width; ++k) {
+        right[j][k] = int(k % 7) - int(j);
+      }
+    }
+    for (size_t i = 0; i < 2; ++i) {
+      for (size_t k = 0; k < Width; ++k) {
+        int sum = 0;
+        for (size_t j = 0; j < 3; ++j) {
+          sum += left[i][j].Data() * right[j][k].Data();
+        }
+        expected[i][k] = sum;
+      }
+    }
+    expect(eq(dllib::MatrixProduct(left, right), expected));
+    expect(eq(dllib::TransposedMatrixProduct(left.T(), right), expected));
+  };
+
   "matrix_transpose"_test = [] {
     int data[2][3] = {
       {1, 2, 3},